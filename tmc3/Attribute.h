@@ -35,7 +35,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "hls.h"
 #include "PayloadBuffer.h"
@@ -64,7 +66,8 @@ public:
 
 //----------------------------------------------------------------------------
 
-std::unique_ptr<AttributeDecoderIntf> makeAttributeDecoder();
+// NB: numThreads is the maximum number of threads used to decode
+std::unique_ptr<AttributeDecoderIntf> makeAttributeDecoder(int numThreads);
 
 //============================================================================
 
@@ -86,7 +89,65 @@ public:
 
 //----------------------------------------------------------------------------
 
-std::unique_ptr<AttributeEncoderIntf> makeAttributeEncoder();
+// NB: numThreads is the maximum number of threads used to encode
+std::unique_ptr<AttributeEncoderIntf> makeAttributeEncoder(int numThreads);
+
+//============================================================================
+// The attribute coders, and with them their LoDs, available to code the
+// attributes of a slice.  Each attribute uses the first coder compatible
+// with its aps, such that attributes with differing LoD parameters do not
+// replace each other's LoDs.
+
+template<typename Coder>
+class AttributeCoderCache {
+public:
+  // Discard all coders
+  void clear()
+  {
+    _coders.clear();
+    _prevSlice.clear();
+  }
+
+  // Start a new slice.  Only the coders used by the previous slice are
+  // retained for use by the new slice.
+  void beginSlice()
+  {
+    if (_coders.empty())
+      return;
+
+    _prevSlice = std::move(_coders);
+    _coders.clear();
+  }
+
+  // Returns a coder compatible with @aps, preferring one already used in
+  // the current slice, then one used in the previous slice, otherwise a
+  // new coder made by @make.
+  template<typename MakeCoder>
+  Coder& get(const AttributeParameterSet& aps, MakeCoder make)
+  {
+    auto isReusable = [&](const std::unique_ptr<Coder>& coder) {
+      return coder->isReusable(aps);
+    };
+
+    auto it = std::find_if(_coders.begin(), _coders.end(), isReusable);
+    if (it != _coders.end())
+      return **it;
+
+    it = std::find_if(_prevSlice.begin(), _prevSlice.end(), isReusable);
+    if (it != _prevSlice.end()) {
+      _coders.push_back(std::move(*it));
+      _prevSlice.erase(it);
+    } else {
+      _coders.push_back(make());
+    }
+
+    return *_coders.back();
+  }
+
+private:
+  std::vector<std::unique_ptr<Coder>> _coders;
+  std::vector<std::unique_ptr<Coder>> _prevSlice;
+};
 
 //============================================================================
 
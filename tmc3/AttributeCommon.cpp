@@ -80,10 +80,19 @@ AttributeLods::generate(
   const PCCPointSet3& cloud)
 {
   _aps = aps;
+  _geomFingerprint = geometryFingerprint(cloud);
+  _numPoints = geom_num_points_minus1 + 1;
+  _minGeomNodeSizeLog2 = minGeomNodeSizeLog2;
+  liftingNeighbours.clear();
+  quantWeights.clear();
+  liftingQuantWeights.clear();
 
   if (minGeomNodeSizeLog2 > 0)
     assert(aps.scalable_lifting_enabled_flag);
 
+  // Any state retained by the predictors of previously generated LoDs
+  // must not leak into the new ones.
+  predictors.clear();
   buildPredictorsFast(
     aps, cloud, minGeomNodeSizeLog2, geom_num_points_minus1, predictors,
     numPointsInLod, indexes);
@@ -95,6 +104,28 @@ AttributeLods::generate(
 
 //----------------------------------------------------------------------------
 
+void
+AttributeLods::deriveLiftingParams(int numThreads)
+{
+  if (!quantWeights.empty())
+    return;
+
+  liftingNeighbours.build(predictors);
+
+  if (!_aps.scalable_lifting_enabled_flag) {
+    PCCComputeQuantizationWeights(
+      liftingNeighbours, numPointsInLod, numThreads, quantWeights);
+  } else {
+    computeQuantizationWeightsScalable(
+      predictors, numPointsInLod, _numPoints, _minGeomNodeSizeLog2,
+      quantWeights);
+  }
+
+  computeLiftingQuantWeights(quantWeights, numThreads, liftingQuantWeights);
+}
+
+//----------------------------------------------------------------------------
+
 bool
 AttributeLods::isReusable(const AttributeParameterSet& aps) const
 {
@@ -150,4 +181,25 @@ AttributeLods::isReusable(const AttributeParameterSet& aps) const
 
 //============================================================================
 
+uint64_t
+geometryFingerprint(const PCCPointSet3& cloud)
+{
+  // 64-bit FNV-1a, operating on 32-bit position components
+  const uint64_t kFnvPrime = 0x100000001b3ull;
+  uint64_t hash = 0xcbf29ce484222325ull;
+
+  const size_t numPoints = cloud.getPointCount();
+  hash = (hash ^ uint64_t(numPoints)) * kFnvPrime;
+
+  for (size_t i = 0; i < numPoints; i++) {
+    const auto& pos = cloud[i];
+    for (int k = 0; k < 3; k++)
+      hash = (hash ^ uint32_t(pos[k])) * kFnvPrime;
+  }
+
+  return hash;
+}
+
+//============================================================================
+
 }  // namespace pcc
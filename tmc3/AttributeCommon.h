@@ -61,6 +61,13 @@ struct AttributeLods {
   // Indicates if the generated LoDs are compatible with the provided aps
   bool isReusable(const AttributeParameterSet& aps) const;
 
+  // Indicates if the generated LoDs were derived from the geometry
+  // identified by geomFingerprint.
+  bool isGeneratedFrom(uint64_t geomFingerprint) const
+  {
+    return !empty() && _geomFingerprint == geomFingerprint;
+  }
+
   bool empty() const { return numPointsInLod.empty(); };
 
   void generate(
@@ -73,12 +80,40 @@ struct AttributeLods {
   std::vector<uint32_t> numPointsInLod;
   std::vector<uint32_t> indexes;
 
+  // Derives the lifting neighbour table and the lifting quantisation
+  // weights of each predictor, unless they have already been derived for
+  // the current LoDs.  Only the lifting transform uses them.
+  void deriveLiftingParams(int numThreads);
+
+  // The neighbours of each predictor, in the form used by lifting
+  LiftingNeighbours liftingNeighbours;
+
+  // The lifting quantisation weight of each predictor, and its square root
+  // and reciprocal (see deriveLiftingParams())
+  std::vector<uint64_t> quantWeights;
+  std::vector<LiftingQuantWeight> liftingQuantWeights;
+
 private:
   // This is the aps that was used to generate the LoDs.  It is used to check
   // if the generated LoDs are reusable.
   AttributeParameterSet _aps;
+
+  // Fingerprint of the geometry that was used to generate the LoDs.
+  uint64_t _geomFingerprint;
+
+  // Number of points and minimum node size used to derive the scalable
+  // lifting quantisation weights
+  int _numPoints;
+  int _minGeomNodeSizeLog2;
 };
 
+//============================================================================
+// Computes a hash of the point positions (in coding order) that identifies
+// the geometry used to generate LoDs.  Slices with identical geometry
+// (eg, successive frames of a static scene) have equal fingerprints.
+
+uint64_t geometryFingerprint(const PCCPointSet3& cloud);
+
 //============================================================================
 
 }  // namespace pcc
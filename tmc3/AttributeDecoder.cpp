@@ -189,12 +189,16 @@ PCCResidualsDecoder::decode(int32_t value[3])
   int b3 = value[1] <= 1;
   value[2] = decodeSymbol(3 + (b0 << 1) + b2, 3 + (b1 << 1) + b3, 1);
 
-  if (value[0] && arithmeticDecoder.decode(binaryModel0))
-    value[0] = -value[0];
-  if (value[1] && arithmeticDecoder.decode(binaryModel0))
-    value[1] = -value[1];
-  if (value[2] && arithmeticDecoder.decode(binaryModel0))
-    value[2] = -value[2];
+  // signs of the non-zero components, in component order
+  int numSigns = !!value[0] + !!value[1] + !!value[2];
+  int signs = arithmeticDecoder.decodeBypass(numSigns);
+  for (int k = 2; k >= 0; k--) {
+    if (!value[k])
+      continue;
+    if (signs & 1)
+      value[k] = -value[k];
+    signs >>= 1;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -216,9 +220,9 @@ AttributeDecoderIntf::~AttributeDecoderIntf() = default;
 // AttributeDecoder factory
 
 std::unique_ptr<AttributeDecoderIntf>
-makeAttributeDecoder()
+makeAttributeDecoder(int numThreads)
 {
-  return std::unique_ptr<AttributeDecoder>(new AttributeDecoder());
+  return std::unique_ptr<AttributeDecoder>(new AttributeDecoder(numThreads));
 }
 
 //============================================================================
@@ -242,10 +246,15 @@ AttributeDecoder::decode(
   PCCResidualsDecoder decoder;
   decoder.start(sps, payload.data() + abhSize, payload.size() - abhSize);
 
-  // generate LoDs if necessary
-  if (attr_aps.lodParametersPresent() && _lods.empty())
-    _lods.generate(
-      attr_aps, geom_num_points_minus1, minGeomNodeSizeLog2, pointCloud);
+  // generate LoDs if necessary.  Previously generated LoDs are retained
+  // only if the geometry is unchanged.
+  if (attr_aps.lodParametersPresent()) {
+    if (
+      _lods.empty()
+      || !_lods.isGeneratedFrom(geometryFingerprint(pointCloud)))
+      _lods.generate(
+        attr_aps, geom_num_points_minus1, minGeomNodeSizeLog2, pointCloud);
+  }
 
   if (attr_desc.attr_num_dimensions_minus1 == 0) {
     switch (attr_aps.attr_encoding) {
@@ -259,8 +268,7 @@ AttributeDecoder::decode(
 
     case AttributeEncoding::kLiftingTransform:
       decodeReflectancesLift(
-        attr_desc, attr_aps, qpSet, geom_num_points_minus1,
-        minGeomNodeSizeLog2, decoder, pointCloud);
+        attr_desc, qpSet, geom_num_points_minus1, decoder, pointCloud);
       break;
     }
   } else if (attr_desc.attr_num_dimensions_minus1 == 2) {
@@ -275,8 +283,7 @@ AttributeDecoder::decode(
 
     case AttributeEncoding::kLiftingTransform:
       decodeColorsLift(
-        attr_desc, attr_aps, qpSet, geom_num_points_minus1,
-        minGeomNodeSizeLog2, decoder, pointCloud);
+        attr_desc, qpSet, geom_num_points_minus1, decoder, pointCloud);
       break;
     }
   } else {
@@ -383,6 +390,7 @@ AttributeDecoder::computeColorPredictionWeights(
   PCCPredictor& predictor,
   PCCResidualsDecoder& decoder)
 {
+  predictor.predMode = 0;
   int64_t maxDiff = 0;
 
   if (predictor.neighborCount > 1 && aps.max_num_direct_predictors) {
@@ -608,27 +616,20 @@ AttributeDecoder::decodeColorsRaht(
 void
 AttributeDecoder::decodeColorsLift(
   const AttributeDescription& desc,
-  const AttributeParameterSet& aps,
   const QpSet& qpSet,
   int geom_num_points_minus1,
-  int minGeomNodeSizeLog2,
   PCCResidualsDecoder& decoder,
   PCCPointSet3& pointCloud)
 {
   const size_t pointCount = pointCloud.getPointCount();
-  std::vector<uint64_t> weights;
+  _lods.deriveLiftingParams(_numThreads);
+  const auto& weights = _lods.quantWeights;
 
-  if (!aps.scalable_lifting_enabled_flag) {
-    PCCComputeQuantizationWeights(_lods.predictors, weights);
-  } else {
-    computeQuantizationWeightsScalable(
-      _lods.predictors, _lods.numPointsInLod, geom_num_points_minus1 + 1,
-      minGeomNodeSizeLog2, weights);
-  }
-
-  const size_t lodCount = _lods.numPointsInLod.size();
-  std::vector<Vec3<int64_t>> colors;
-  colors.resize(pointCount);
+  // NB: each colour component is lifted as a separate array
+  std::vector<int64_t> colorValues(3 * pointCount);
+  int64_t* const colors[3] = {colorValues.data(),
+                              colorValues.data() + pointCount,
+                              colorValues.data() + 2 * pointCount};
 
   // NB: when partially decoding, the truncated unary limit for zero_run
   // must be the original value.  geom_num_points may be the case.  However,
@@ -655,37 +656,30 @@ AttributeDecoder::decodeColorsLift(
       zero_cnt = decoder.decodeZeroCnt(zeroCntLimit);
     }
 
-    const int64_t iQuantWeight = irsqrt(weights[predictorIndex]);
-    auto& color = colors[predictorIndex];
-    const int64_t delta = values[0];
-    const int64_t reconstructedDelta = quant[0].scale(delta);
-    color[0] = divExp2RoundHalfInf(reconstructedDelta * iQuantWeight, 40);
-    for (size_t d = 1; d < 3; ++d) {
+    const int64_t iQuantWeight =
+      _lods.liftingQuantWeights[predictorIndex].iQuantWeight;
+    for (size_t d = 0; d < 3; ++d) {
       const int64_t delta = values[d];
-      const int64_t reconstructedDelta = quant[1].scale(delta);
-      color[d] = divExp2RoundHalfInf(reconstructedDelta * iQuantWeight, 40);
+      const int64_t reconstructedDelta = quant[d ? 1 : 0].scale(delta);
+      colors[d][predictorIndex] =
+        divExp2RoundHalfInf(reconstructedDelta * iQuantWeight, 40);
     }
   }
 
   // reconstruct
-  for (size_t lodIndex = 1; lodIndex < lodCount; ++lodIndex) {
-    const size_t startIndex = _lods.numPointsInLod[lodIndex - 1];
-    const size_t endIndex = _lods.numPointsInLod[lodIndex];
-    PCCLiftUpdate(
-      _lods.predictors, weights, startIndex, endIndex, false, colors);
-    PCCLiftPredict(_lods.predictors, startIndex, endIndex, false, colors);
-  }
+  PCCLiftInverse(
+    _lods.liftingNeighbours, weights, _lods.numPointsInLod, 3, colors);
 
   Vec3<int64_t> clipMax{(1 << desc.bitdepth) - 1,
                         (1 << desc.bitdepthSecondary) - 1,
                         (1 << desc.bitdepthSecondary) - 1};
 
   for (size_t f = 0; f < pointCount; ++f) {
-    const auto color0 =
-      divExp2RoundHalfInf(colors[f], kFixedPointAttributeShift);
     Vec3<attr_t> color;
     for (size_t d = 0; d < 3; ++d) {
-      color[d] = attr_t(PCCClip(color0[d], int64_t(0), clipMax[d]));
+      const int64_t color0 =
+        divExp2RoundHalfInf(colors[d][f], kFixedPointAttributeShift);
+      color[d] = attr_t(PCCClip(color0, int64_t(0), clipMax[d]));
     }
     pointCloud.setColor(_lods.indexes[f], color);
   }
@@ -696,25 +690,15 @@ AttributeDecoder::decodeColorsLift(
 void
 AttributeDecoder::decodeReflectancesLift(
   const AttributeDescription& desc,
-  const AttributeParameterSet& aps,
   const QpSet& qpSet,
   int geom_num_points_minus1,
-  int minGeomNodeSizeLog2,
   PCCResidualsDecoder& decoder,
   PCCPointSet3& pointCloud)
 {
   const size_t pointCount = pointCloud.getPointCount();
-  std::vector<uint64_t> weights;
+  _lods.deriveLiftingParams(_numThreads);
+  const auto& weights = _lods.quantWeights;
 
-  if (!aps.scalable_lifting_enabled_flag) {
-    PCCComputeQuantizationWeights(_lods.predictors, weights);
-  } else {
-    computeQuantizationWeightsScalable(
-      _lods.predictors, _lods.numPointsInLod, geom_num_points_minus1 + 1,
-      minGeomNodeSizeLog2, weights);
-  }
-
-  const size_t lodCount = _lods.numPointsInLod.size();
   std::vector<int64_t> reflectances;
   reflectances.resize(pointCount);
 
@@ -741,7 +725,8 @@ AttributeDecoder::decodeReflectancesLift(
       detail = decoder.decode();
       zero_cnt = decoder.decodeZeroCnt(zeroCntLimit);
     }
-    const int64_t iQuantWeight = irsqrt(weights[predictorIndex]);
+    const int64_t iQuantWeight =
+      _lods.liftingQuantWeights[predictorIndex].iQuantWeight;
     auto& reflectance = reflectances[predictorIndex];
     const int64_t delta = detail;
     const int64_t reconstructedDelta = quant[0].scale(delta);
@@ -749,14 +734,9 @@ AttributeDecoder::decodeReflectancesLift(
   }
 
   // reconstruct
-  for (size_t lodIndex = 1; lodIndex < lodCount; ++lodIndex) {
-    const size_t startIndex = _lods.numPointsInLod[lodIndex - 1];
-    const size_t endIndex = _lods.numPointsInLod[lodIndex];
-    PCCLiftUpdate(
-      _lods.predictors, weights, startIndex, endIndex, false, reflectances);
-    PCCLiftPredict(
-      _lods.predictors, startIndex, endIndex, false, reflectances);
-  }
+  int64_t* const components[1] = {reflectances.data()};
+  PCCLiftInverse(
+    _lods.liftingNeighbours, weights, _lods.numPointsInLod, 1, components);
   const int64_t maxReflectance = (1 << desc.bitdepth) - 1;
   for (size_t f = 0; f < pointCount; ++f) {
     const auto refl =
@@ -54,6 +54,8 @@ struct PCCResidualsDecoder;
 
 class AttributeDecoder : public AttributeDecoderIntf {
 public:
+  AttributeDecoder(int numThreads) : _numThreads(numThreads) {}
+
   void decode(
     const SequenceParameterSet& sps,
     const AttributeDescription& desc,
@@ -70,19 +72,15 @@ protected:
 
   void decodeReflectancesLift(
     const AttributeDescription& desc,
-    const AttributeParameterSet& aps,
     const QpSet& qpSet,
     int geom_num_points_minus1,
-    int minGeomNodeSizeLog2,
     PCCResidualsDecoder& decoder,
     PCCPointSet3& pointCloud);
 
   void decodeColorsLift(
     const AttributeDescription& desc,
-    const AttributeParameterSet& aps,
     const QpSet& qpSet,
     int geom_num_points_minus1,
-    int minGeomNodeSizeLog2,
     PCCResidualsDecoder& decoder,
     PCCPointSet3& pointCloud);
 
@@ -130,6 +128,9 @@ protected:
 
 private:
   AttributeLods _lods;
+
+  // Maximum number of threads used by parallelised stages
+  int _numThreads;
 };
 
 //============================================================================
@@ -39,6 +39,7 @@
 #include "DualLutCoder.h"
 #include "constants.h"
 #include "entropy.h"
+#include "entropyrate.h"
 #include "quantization.h"
 #include "RAHT.h"
 #include "FixedPoint.h"
@@ -208,12 +209,13 @@ PCCResidualsEncoder::encode(int32_t value0, int32_t value1, int32_t value2)
   encodeSymbol(mag1, 1 + b0, 1 + b1, 1);
   encodeSymbol(mag2, 3 + (b0 << 1) + b2, 3 + (b1 << 1) + b3, 1);
 
-  if (mag0)
-    arithmeticEncoder.encode(value0 < 0, binaryModel0);
-  if (mag1)
-    arithmeticEncoder.encode(value1 < 0, binaryModel0);
-  if (mag2)
-    arithmeticEncoder.encode(value2 < 0, binaryModel0);
+  // signs of the non-zero components, in component order
+  int numSigns = !!mag0 + !!mag1 + !!mag2;
+  int signs = 0;
+  for (int value : {value0, value1, value2})
+    if (value)
+      signs = (signs << 1) | (value < 0);
+  arithmeticEncoder.encodeBypass(signs, numSigns);
 }
 
 //----------------------------------------------------------------------------
@@ -228,6 +230,7 @@ PCCResidualsEncoder::encode(int32_t value)
 
 //============================================================================
 // An encapsulation of the entropy coding methods used in attribute coding
+// NB: rates are in units of 2^-kRateFracBits bits.
 
 struct PCCResidualsEntropyEstimator {
   size_t freq0[kAttributeResidualAlphabetSize + 1];
@@ -238,13 +241,13 @@ struct PCCResidualsEntropyEstimator {
   size_t isZero1Count;
   PCCResidualsEntropyEstimator() { init(); }
   void init();
-  double bitsDetail(
+  int bitsDetail(
     const uint32_t detail,
     const size_t symbolCount,
     const size_t* const freq) const;
-  double bits(const uint32_t value0) const;
+  int bits(const uint32_t value0) const;
   void update(const uint32_t value0);
-  double bits(
+  int bits(
     const uint32_t value0, const uint32_t value1, const uint32_t value2) const;
   void
   update(const uint32_t value0, const uint32_t value1, const uint32_t value2);
@@ -266,7 +269,7 @@ PCCResidualsEntropyEstimator::init()
 
 //----------------------------------------------------------------------------
 
-double
+int
 PCCResidualsEntropyEstimator::bitsDetail(
   const uint32_t detail,
   const size_t symbolCount,
@@ -274,26 +277,22 @@ PCCResidualsEntropyEstimator::bitsDetail(
 {
   const uint32_t detailClipped =
     std::min(detail, uint32_t(kAttributeResidualAlphabetSize));
-  const double pDetail =
-    PCCClip(double(freq[detailClipped]) / symbolCount, 0.001, 0.999);
-  double bits = -log2(pDetail);
+  int bits = rateFromFreq(freq[detailClipped], symbolCount);
   if (detail >= kAttributeResidualAlphabetSize) {
-    const double x = double(detail) - double(kAttributeResidualAlphabetSize);
-    bits += 2.0 * std::floor(log2(x + 1.0)) + 1.0;
+    const uint32_t x = detail - kAttributeResidualAlphabetSize;
+    bits += (2 * ilog2(x + 1) + 1) << kRateFracBits;
   }
   return bits;
 }
 
 //----------------------------------------------------------------------------
 
-double
+int
 PCCResidualsEntropyEstimator::bits(const uint32_t value0) const
 {
   const bool isZero0 = value0 == 0;
-  const double pIsZero0 = isZero0
-    ? double(isZero0Count) / symbolCount0
-    : double(symbolCount0 - isZero0Count) / symbolCount0;
-  double bits = -log2(PCCClip(pIsZero0, 0.001, 0.999));
+  int bits = rateFromFreq(
+    isZero0 ? isZero0Count : symbolCount0 - isZero0Count, symbolCount0);
   if (!isZero0) {
     bits += bitsDetail(value0 - 1, symbolCount0, freq0);
   }
@@ -316,24 +315,20 @@ PCCResidualsEntropyEstimator::update(const uint32_t value0)
 
 //----------------------------------------------------------------------------
 
-double
+int
 PCCResidualsEntropyEstimator::bits(
   const uint32_t value0, const uint32_t value1, const uint32_t value2) const
 {
   const bool isZero0 = value0 == 0;
-  const double pIsZero0 = isZero0
-    ? double(isZero0Count) / symbolCount0
-    : double(symbolCount0 - isZero0Count) / symbolCount0;
-  double bits = -log2(PCCClip(pIsZero0, 0.001, 0.999));
+  int bits = rateFromFreq(
+    isZero0 ? isZero0Count : symbolCount0 - isZero0Count, symbolCount0);
   if (!isZero0) {
     bits += bitsDetail(value0 - 1, symbolCount0, freq0);
   }
 
   const bool isZero1 = value1 == 0 && value2 == 0;
-  const double pIsZero1 = isZero1
-    ? double(isZero1Count) / symbolCount0
-    : double(symbolCount0 - isZero1Count) / symbolCount0;
-  bits -= log2(PCCClip(pIsZero1, 0.001, 0.999));
+  bits += rateFromFreq(
+    isZero1 ? isZero1Count : symbolCount0 - isZero1Count, symbolCount0);
   if (!isZero1) {
     bits += bitsDetail(value1, symbolCount1, freq1);
     bits += bitsDetail(value2, symbolCount1, freq1);
@@ -374,9 +369,9 @@ AttributeEncoderIntf::~AttributeEncoderIntf() = default;
 // AttributeEncoder factory
 
 std::unique_ptr<AttributeEncoderIntf>
-makeAttributeEncoder()
+makeAttributeEncoder(int numThreads)
 {
-  return std::unique_ptr<AttributeEncoder>(new AttributeEncoder());
+  return std::unique_ptr<AttributeEncoder>(new AttributeEncoder(numThreads));
 }
 
 //============================================================================
@@ -396,9 +391,15 @@ AttributeEncoder::encode(
   PCCResidualsEncoder encoder;
   encoder.start(sps, int(pointCloud.getPointCount()));
 
-  // generate LoDs if necessary
-  if (attr_aps.lodParametersPresent() && _lods.empty())
-    _lods.generate(attr_aps, pointCloud.getPointCount() - 1, 0, pointCloud);
+  // generate LoDs if necessary.  Previously generated LoDs are retained
+  // only if the geometry is unchanged.
+  if (attr_aps.lodParametersPresent()) {
+    if (
+      _lods.empty()
+      || !_lods.isGeneratedFrom(geometryFingerprint(pointCloud)))
+      _lods.generate(
+        attr_aps, pointCloud.getPointCount() - 1, 0, pointCloud);
+  }
 
   if (desc.attr_num_dimensions_minus1 == 0) {
     switch (attr_aps.attr_encoding) {
@@ -412,7 +413,7 @@ AttributeEncoder::encode(
       break;
 
     case AttributeEncoding::kLiftingTransform:
-      encodeReflectancesLift(desc, attr_aps, qpSet, pointCloud, encoder);
+      encodeReflectancesLift(desc, qpSet, pointCloud, encoder);
       break;
     }
   } else if (desc.attr_num_dimensions_minus1 == 2) {
@@ -426,7 +427,7 @@ AttributeEncoder::encode(
       break;
 
     case AttributeEncoding::kLiftingTransform:
-      encodeColorsLift(desc, attr_aps, qpSet, pointCloud, encoder);
+      encodeColorsLift(desc, qpSet, pointCloud, encoder);
       break;
     }
   } else {
@@ -657,6 +658,7 @@ AttributeEncoder::computeColorPredictionWeights(
   PCCResidualsEntropyEstimator& context,
   const Quantizers& quant)
 {
+  predictor.predMode = 0;
   predictor.maxDiff = 0;
   if (predictor.neighborCount > 1 && aps.max_num_direct_predictors) {
     int64_t minValue[3] = {0, 0, 0};
@@ -978,40 +980,29 @@ AttributeEncoder::encodeColorsTransformRaht(
 void
 AttributeEncoder::encodeColorsLift(
   const AttributeDescription& desc,
-  const AttributeParameterSet& aps,
   const QpSet& qpSet,
   PCCPointSet3& pointCloud,
   PCCResidualsEncoder& encoder)
 {
   const size_t pointCount = pointCloud.getPointCount();
-  std::vector<uint64_t> weights;
+  _lods.deriveLiftingParams(_numThreads);
+  const auto& weights = _lods.quantWeights;
 
-  if (!aps.scalable_lifting_enabled_flag) {
-    PCCComputeQuantizationWeights(_lods.predictors, weights);
-  } else {
-    computeQuantizationWeightsScalable(
-      _lods.predictors, _lods.numPointsInLod, pointCount, 0, weights);
-  }
-
-  const size_t lodCount = _lods.numPointsInLod.size();
-  std::vector<Vec3<int64_t>> colors;
-  colors.resize(pointCount);
+  // NB: each colour component is lifted as a separate array
+  std::vector<int64_t> colorValues(3 * pointCount);
+  int64_t* const colors[3] = {colorValues.data(),
+                              colorValues.data() + pointCount,
+                              colorValues.data() + 2 * pointCount};
 
   for (size_t index = 0; index < pointCount; ++index) {
     const auto& color = pointCloud.getColor(_lods.indexes[index]);
     for (size_t d = 0; d < 3; ++d) {
-      colors[index][d] = int32_t(color[d]) << kFixedPointAttributeShift;
+      colors[d][index] = int32_t(color[d]) << kFixedPointAttributeShift;
     }
   }
 
-  for (size_t i = 0; (i + 1) < lodCount; ++i) {
-    const size_t lodIndex = lodCount - i - 1;
-    const size_t startIndex = _lods.numPointsInLod[lodIndex - 1];
-    const size_t endIndex = _lods.numPointsInLod[lodIndex];
-    PCCLiftPredict(_lods.predictors, startIndex, endIndex, true, colors);
-    PCCLiftUpdate(
-      _lods.predictors, weights, startIndex, endIndex, true, colors);
-  }
+  PCCLiftForward(
+    _lods.liftingNeighbours, weights, _lods.numPointsInLod, 3, colors);
 
   // compress
   int zero_cnt = 0;
@@ -1024,23 +1015,18 @@ AttributeEncoder::encodeColorsLift(
     const auto pointIndex = _lods.indexes[predictorIndex];
     auto quant = qpSet.quantizers(pointCloud[pointIndex], quantLayer);
 
-    const int64_t iQuantWeight = irsqrt(weights[predictorIndex]);
-    const int64_t quantWeight =
-      (weights[predictorIndex] * iQuantWeight + (1ull << 39)) >> 40;
+    const auto& liftWeight = _lods.liftingQuantWeights[predictorIndex];
+    const int64_t iQuantWeight = liftWeight.iQuantWeight;
+    const int64_t quantWeight = liftWeight.quantWeight;
 
-    auto& color = colors[predictorIndex];
-    const int64_t delta = quant[0].quantize(color[0] * quantWeight);
-    auto detail = delta;
-    const int64_t reconstructedDelta = quant[0].scale(delta);
-    color[0] = divExp2RoundHalfInf(reconstructedDelta * iQuantWeight, 40);
     int values[3];
-    values[0] = detail;
-    for (size_t d = 1; d < 3; ++d) {
-      const int64_t delta = quant[1].quantize(color[d] * quantWeight);
-      const auto detail = delta;
-      const int64_t reconstructedDelta = quant[1].scale(delta);
-      color[d] = divExp2RoundHalfInf(reconstructedDelta * iQuantWeight, 40);
-      values[d] = detail;
+    for (size_t d = 0; d < 3; ++d) {
+      int64_t& color = colors[d][predictorIndex];
+      const auto& q = quant[d ? 1 : 0];
+      const int64_t delta = q.quantize(color * quantWeight);
+      const int64_t reconstructedDelta = q.scale(delta);
+      color = divExp2RoundHalfInf(reconstructedDelta * iQuantWeight, 40);
+      values[d] = delta;
     }
     if (!values[0] && !values[1] && !values[2])
       ++zero_cnt;
@@ -1053,24 +1039,19 @@ AttributeEncoder::encodeColorsLift(
   encoder.encodeZeroCnt(zero_cnt, pointCount);
 
   // reconstruct
-  for (size_t lodIndex = 1; lodIndex < lodCount; ++lodIndex) {
-    const size_t startIndex = _lods.numPointsInLod[lodIndex - 1];
-    const size_t endIndex = _lods.numPointsInLod[lodIndex];
-    PCCLiftUpdate(
-      _lods.predictors, weights, startIndex, endIndex, false, colors);
-    PCCLiftPredict(_lods.predictors, startIndex, endIndex, false, colors);
-  }
+  PCCLiftInverse(
+    _lods.liftingNeighbours, weights, _lods.numPointsInLod, 3, colors);
 
   Vec3<int64_t> clipMax{(1 << desc.bitdepth) - 1,
                         (1 << desc.bitdepthSecondary) - 1,
                         (1 << desc.bitdepthSecondary) - 1};
 
   for (size_t f = 0; f < pointCount; ++f) {
-    const auto color0 =
-      divExp2RoundHalfInf(colors[f], kFixedPointAttributeShift);
     Vec3<attr_t> color;
     for (size_t d = 0; d < 3; ++d) {
-      color[d] = attr_t(PCCClip(color0[d], 0, clipMax[d]));
+      const int64_t color0 =
+        divExp2RoundHalfInf(colors[d][f], kFixedPointAttributeShift);
+      color[d] = attr_t(PCCClip(color0, int64_t(0), clipMax[d]));
     }
     pointCloud.setColor(_lods.indexes[f], color);
   }
@@ -1081,22 +1062,14 @@ AttributeEncoder::encodeColorsLift(
 void
 AttributeEncoder::encodeReflectancesLift(
   const AttributeDescription& desc,
-  const AttributeParameterSet& aps,
   const QpSet& qpSet,
   PCCPointSet3& pointCloud,
   PCCResidualsEncoder& encoder)
 {
   const size_t pointCount = pointCloud.getPointCount();
-  std::vector<uint64_t> weights;
+  _lods.deriveLiftingParams(_numThreads);
+  const auto& weights = _lods.quantWeights;
 
-  if (!aps.scalable_lifting_enabled_flag) {
-    PCCComputeQuantizationWeights(_lods.predictors, weights);
-  } else {
-    computeQuantizationWeightsScalable(
-      _lods.predictors, _lods.numPointsInLod, pointCount, 0, weights);
-  }
-
-  const size_t lodCount = _lods.numPointsInLod.size();
   std::vector<int64_t> reflectances;
   reflectances.resize(pointCount);
 
@@ -1106,14 +1079,9 @@ AttributeEncoder::encodeReflectancesLift(
       << kFixedPointAttributeShift;
   }
 
-  for (size_t i = 0; (i + 1) < lodCount; ++i) {
-    const size_t lodIndex = lodCount - i - 1;
-    const size_t startIndex = _lods.numPointsInLod[lodIndex - 1];
-    const size_t endIndex = _lods.numPointsInLod[lodIndex];
-    PCCLiftPredict(_lods.predictors, startIndex, endIndex, true, reflectances);
-    PCCLiftUpdate(
-      _lods.predictors, weights, startIndex, endIndex, true, reflectances);
-  }
+  int64_t* const components[1] = {reflectances.data()};
+  PCCLiftForward(
+    _lods.liftingNeighbours, weights, _lods.numPointsInLod, 1, components);
 
   // compress
   int zero_cnt = 0;
@@ -1126,9 +1094,9 @@ AttributeEncoder::encodeReflectancesLift(
     const auto pointIndex = _lods.indexes[predictorIndex];
     auto quant = qpSet.quantizers(pointCloud[pointIndex], quantLayer);
 
-    const int64_t iQuantWeight = irsqrt(weights[predictorIndex]);
-    const int64_t quantWeight =
-      (weights[predictorIndex] * iQuantWeight + (1ull << 39)) >> 40;
+    const auto& liftWeight = _lods.liftingQuantWeights[predictorIndex];
+    const int64_t iQuantWeight = liftWeight.iQuantWeight;
+    const int64_t quantWeight = liftWeight.quantWeight;
 
     auto& reflectance = reflectances[predictorIndex];
     const int64_t delta = quant[0].quantize(reflectance * quantWeight);
@@ -1146,14 +1114,8 @@ AttributeEncoder::encodeReflectancesLift(
   encoder.encodeZeroCnt(zero_cnt, pointCount);
 
   // reconstruct
-  for (size_t lodIndex = 1; lodIndex < lodCount; ++lodIndex) {
-    const size_t startIndex = _lods.numPointsInLod[lodIndex - 1];
-    const size_t endIndex = _lods.numPointsInLod[lodIndex];
-    PCCLiftUpdate(
-      _lods.predictors, weights, startIndex, endIndex, false, reflectances);
-    PCCLiftPredict(
-      _lods.predictors, startIndex, endIndex, false, reflectances);
-  }
+  PCCLiftInverse(
+    _lods.liftingNeighbours, weights, _lods.numPointsInLod, 1, components);
   const int64_t maxReflectance = (1 << desc.bitdepth) - 1;
   for (size_t f = 0; f < pointCount; ++f) {
     const int64_t refl =
@@ -56,6 +56,8 @@ struct PCCResidualsEntropyEstimator;
 
 class AttributeEncoder : public AttributeEncoderIntf {
 public:
+  AttributeEncoder(int numThreads) : _numThreads(numThreads) {}
+
   void encode(
     const SequenceParameterSet& sps,
     const AttributeDescription& desc,
@@ -71,14 +73,12 @@ protected:
 
   void encodeReflectancesLift(
     const AttributeDescription& desc,
-    const AttributeParameterSet& aps,
     const QpSet& qpSet,
     PCCPointSet3& pointCloud,
     PCCResidualsEncoder& encoder);
 
   void encodeColorsLift(
     const AttributeDescription& desc,
-    const AttributeParameterSet& aps,
     const QpSet& qpSet,
     PCCPointSet3& pointCloud,
     PCCResidualsEncoder& encoder);
@@ -144,6 +144,9 @@ protected:
 
 private:
   AttributeLods _lods;
+
+  // Maximum number of threads used by parallelised stages
+  int _numThreads;
 };
 
 //============================================================================
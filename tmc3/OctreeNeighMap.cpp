@@ -45,7 +45,7 @@ void
 updateGeometryOccupancyAtlas(
   const Vec3<int32_t>& currentPosition,
   const int atlasShift,
-  const pcc::ringbuf<PCCOctree3Node>& fifo,
+  const pcc::ringbuf<PCCOctree3Node>::iterator& fifoCurr,
   const pcc::ringbuf<PCCOctree3Node>::iterator& fifoCurrLvlEnd,
   MortonMap3D* occupancyAtlas,
   Vec3<int32_t>* atlasOrigin)
@@ -67,7 +67,7 @@ updateGeometryOccupancyAtlas(
   *atlasOrigin = currentOrigin;
   occupancyAtlas->clearUpdates();
 
-  for (auto it = fifo.begin(); it != fifoCurrLvlEnd; ++it) {
+  for (auto it = fifoCurr; it != fifoCurrLvlEnd; ++it) {
     if (currentOrigin != it->pos >> shift)
       break;
     const uint32_t x = (it->pos[0] & mask) >> shiftX;
@@ -211,11 +211,11 @@ GeometryNeighPattern makeGeometryNeighPattern(
   const MortonMap3D& occupancyAtlas);
 
 // populate (if necessary) the occupancy atlas with occupancy information
-// from @fifo.
+// from the nodes in the range [@fifoCurr, @fifoCurrLvlEnd).
 void updateGeometryOccupancyAtlas(
   const Vec3<int32_t>& position,
   const int atlasShift,
-  const ringbuf<PCCOctree3Node>& fifo,
+  const ringbuf<PCCOctree3Node>::iterator& fifoCurr,
   const ringbuf<PCCOctree3Node>::iterator& fifoCurrLvlEnd,
   MortonMap3D* occupancyAtlas,
   Vec3<int32_t>* atlasOrigin);
@@ -174,6 +174,21 @@ ceillog2(uint32_t x)
   return ilog2(x - 1) + 1;
 }
 
+//---------------------------------------------------------------------------
+// Reverse the order of the numBits least significant bits of x.
+// NB: 0 < numBits <= 32.
+
+inline uint32_t
+reverseBits(uint32_t x, int numBits)
+{
+  x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+  x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+  x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+  x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+  x = (x >> 16) | (x << 16);
+  return x >> (32 - numBits);
+}
+
 //---------------------------------------------------------------------------
 // Compute an approximation of \left\floor \sqrt{x} \right\floor
 
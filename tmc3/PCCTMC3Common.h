@@ -40,11 +40,14 @@
 #include "PCCPointSet.h"
 #include "constants.h"
 #include "hls.h"
+#include "parallel.h"
 
 #include "nanoflann.hpp"
 
+#include <cmath>
 #include <cstdint>
 #include <cstddef>
+#include <unordered_map>
 #include <vector>
 
 namespace pcc {
@@ -256,110 +259,130 @@ struct PCCPredictor {
 
 //---------------------------------------------------------------------------
 
-template<typename T>
-void
-PCCLiftPredict(
-  const std::vector<PCCPredictor>& predictors,
-  const size_t startIndex,
-  const size_t endIndex,
-  const bool direct,
-  std::vector<T>& attributes)
-{
-  const size_t predictorCount = endIndex - startIndex;
-  for (size_t index = 0; index < predictorCount; ++index) {
-    const size_t predictorIndex = predictorCount - index - 1 + startIndex;
-    const auto& predictor = predictors[predictorIndex];
-    auto& attribute = attributes[predictorIndex];
-    T predicted(T(0));
-    for (size_t i = 0; i < predictor.neighborCount; ++i) {
-      const size_t neighborPredIndex = predictor.neighbors[i].predictorIndex;
-      const uint32_t weight = predictor.neighbors[i].weight;
-      assert(neighborPredIndex < startIndex);
-      predicted += weight * attributes[neighborPredIndex];
-    }
-    predicted = divExp2RoundHalfInf(predicted, kFixedPointWeightShift);
-    if (direct) {
-      attribute -= predicted;
-    } else {
-      attribute += predicted;
-    }
-  }
-}
+// The neighbours of each predictor in a compact form for use by the
+// lifting transform.  Neighbour j of predictor i is indexes[j][i], with
+// weight weights[j][i].  Unused neighbours have zero weight.
 
-//---------------------------------------------------------------------------
+struct LiftingNeighbours {
+  std::vector<uint32_t> indexes[kAttributePredictionMaxNeighbourCount];
+  std::vector<uint32_t> weights[kAttributePredictionMaxNeighbourCount];
 
-template<typename T>
-void
-PCCLiftUpdate(
-  const std::vector<PCCPredictor>& predictors,
-  const std::vector<uint64_t>& quantizationWeights,
-  const size_t startIndex,
-  const size_t endIndex,
-  const bool direct,
-  std::vector<T>& attributes)
-{
-  std::vector<uint64_t> updateWeights;
-  updateWeights.resize(startIndex, uint64_t(0));
-  std::vector<T> updates;
-  updates.resize(startIndex);
-  for (size_t index = 0; index < startIndex; ++index) {
-    updates[index] = int64_t(0);
-  }
-  const size_t predictorCount = endIndex - startIndex;
-  for (size_t index = 0; index < predictorCount; ++index) {
-    const size_t predictorIndex = predictorCount - index - 1 + startIndex;
-    const auto& predictor = predictors[predictorIndex];
-    const auto currentQuantWeight = quantizationWeights[predictorIndex];
-    for (size_t i = 0; i < predictor.neighborCount; ++i) {
-      const size_t neighborPredIndex = predictor.neighbors[i].predictorIndex;
-      const auto weight = divExp2RoundHalfInf(
-        predictor.neighbors[i].weight * currentQuantWeight,
-        kFixedPointWeightShift);
-      assert(neighborPredIndex < startIndex);
-      updateWeights[neighborPredIndex] += weight;
-      updates[neighborPredIndex] += weight * attributes[predictorIndex];
+  bool empty() const { return indexes[0].empty(); }
+  size_t size() const { return indexes[0].size(); }
+
+  void clear()
+  {
+    for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+      indexes[j].clear();
+      weights[j].clear();
     }
   }
-  for (size_t predictorIndex = 0; predictorIndex < startIndex;
-       ++predictorIndex) {
-    const uint32_t sumWeights = updateWeights[predictorIndex];
-    if (sumWeights) {
-      auto& update = updates[predictorIndex];
-      update = divApprox(update, sumWeights, 0);
-      auto& attribute = attributes[predictorIndex];
-      if (direct) {
-        attribute += update;
-      } else {
-        attribute -= update;
+
+  void build(const std::vector<PCCPredictor>& predictors)
+  {
+    const size_t predictorCount = predictors.size();
+    for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+      indexes[j].assign(predictorCount, 0);
+      weights[j].assign(predictorCount, 0);
+    }
+
+    for (size_t index = 0; index < predictorCount; ++index) {
+      const auto& predictor = predictors[index];
+      for (size_t j = 0; j < predictor.neighborCount; ++j) {
+        // NB: normalised neighbour weights are 32-bit (see computeWeights)
+        assert(
+          predictor.neighbors[j].weight
+          <= std::numeric_limits<uint32_t>::max());
+        indexes[j][index] = predictor.neighbors[j].predictorIndex;
+        weights[j][index] = uint32_t(predictor.neighbors[j].weight);
       }
     }
   }
-}
+};
 
 //---------------------------------------------------------------------------
+// Forward and inverse lifting transforms of attributes ordered by level of
+// detail.  Each of the numComponents attribute components is a separate
+// array of predictor-ordered values.
+
+void PCCLiftForward(
+  const LiftingNeighbours& neighbours,
+  const std::vector<uint64_t>& quantizationWeights,
+  const std::vector<uint32_t>& numPointsInLod,
+  int numComponents,
+  int64_t* const attributes[]);
+
+void PCCLiftInverse(
+  const LiftingNeighbours& neighbours,
+  const std::vector<uint64_t>& quantizationWeights,
+  const std::vector<uint32_t>& numPointsInLod,
+  int numComponents,
+  int64_t* const attributes[]);
+
+//---------------------------------------------------------------------------
+
+// Derives the lifting quantisation weight of each predictor from the
+// weights of the predictors that reference it.  Predictors only reference
+// those of preceding levels of detail: the weights of each level depend
+// only upon the following levels, and are derived in parallel.
 
 inline void
 PCCComputeQuantizationWeights(
-  const std::vector<PCCPredictor>& predictors,
+  const LiftingNeighbours& neighbours,
+  const std::vector<uint32_t>& numPointsInLod,
+  int numThreads,
   std::vector<uint64_t>& quantizationWeights)
 {
-  const size_t pointCount = predictors.size();
-  quantizationWeights.resize(pointCount);
-  for (size_t i = 0; i < pointCount; ++i) {
-    quantizationWeights[i] = (1 << kFixedPointWeightShift);
+  const uint32_t pointCount = uint32_t(neighbours.size());
+  assert(numPointsInLod.empty() || numPointsInLod.back() == pointCount);
+
+  // Transpose the neighbour table: the predictors that reference predictor
+  // i are in the range [refOffsets[i], refOffsets[i + 1]).
+  // NB: neighbours with zero weight do not contribute.
+  std::vector<uint32_t> refOffsets(pointCount + 1, 0);
+  for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+    for (uint32_t i = 0; i < pointCount; ++i) {
+      if (neighbours.weights[j][i])
+        refOffsets[neighbours.indexes[j][i] + 1]++;
+    }
   }
-  for (size_t i = 0; i < pointCount; ++i) {
-    const size_t predictorIndex = pointCount - i - 1;
-    const auto& predictor = predictors[predictorIndex];
-    const auto currentQuantWeight = quantizationWeights[predictorIndex];
-    for (size_t j = 0; j < predictor.neighborCount; ++j) {
-      const size_t neighborPredIndex = predictor.neighbors[j].predictorIndex;
-      const auto weight = predictor.neighbors[j].weight;
-      auto& neighborQuantWeight = quantizationWeights[neighborPredIndex];
-      neighborQuantWeight += divExp2RoundHalfInf(
-        weight * currentQuantWeight, kFixedPointWeightShift);
+  for (uint32_t i = 0; i < pointCount; ++i)
+    refOffsets[i + 1] += refOffsets[i];
+
+  const uint32_t edgeCount = refOffsets[pointCount];
+  std::vector<uint32_t> refIndexes(edgeCount);
+  std::vector<uint32_t> refWeights(edgeCount);
+  std::vector<uint32_t> refPos(refOffsets.begin(), refOffsets.end() - 1);
+  for (uint32_t predictorIndex = 0; predictorIndex < pointCount;
+       ++predictorIndex) {
+    for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+      const uint32_t weight = neighbours.weights[j][predictorIndex];
+      if (!weight)
+        continue;
+      const uint32_t pos = refPos[neighbours.indexes[j][predictorIndex]]++;
+      refIndexes[pos] = predictorIndex;
+      refWeights[pos] = weight;
     }
   }
+
+  quantizationWeights.resize(pointCount);
+  uint64_t* weights = quantizationWeights.data();
+
+  for (size_t lodIndex = numPointsInLod.size(); lodIndex-- > 0;) {
+    const int startIndex = lodIndex ? numPointsInLod[lodIndex - 1] : 0;
+    const int endIndex = numPointsInLod[lodIndex];
+
+    parallelFor(numThreads, startIndex, endIndex, [&](int predictorIndex) {
+      uint64_t weight = 1 << kFixedPointWeightShift;
+      const uint32_t end = refOffsets[predictorIndex + 1];
+      for (uint32_t i = refOffsets[predictorIndex]; i < end; ++i) {
+        assert(refIndexes[i] >= uint32_t(endIndex));
+        weight += divExp2RoundHalfInf(
+          refWeights[i] * weights[refIndexes[i]], kFixedPointWeightShift);
+      }
+      weights[predictorIndex] = weight;
+    });
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -401,32 +424,112 @@ computeQuantizationWeightsScalable(
 }
 
 //---------------------------------------------------------------------------
+// The square root of a lifting quantisation weight, used to scale
+// coefficients prior to quantisation, and its reciprocal.
 
-inline uint32_t
-FindNeighborWithinDistance(
-  const PCCPointSet3& pointCloud,
-  const std::vector<MortonCodeWithIndex>& packedVoxel,
-  const int32_t index,
-  const double radius2,
-  const int32_t searchRange,
-  std::vector<uint32_t>& retained)
+struct LiftingQuantWeight {
+  int64_t quantWeight;
+  int64_t iQuantWeight;
+};
+
+//---------------------------------------------------------------------------
+
+inline void
+computeLiftingQuantWeights(
+  const std::vector<uint64_t>& quantizationWeights,
+  int numThreads,
+  std::vector<LiftingQuantWeight>& liftingQuantWeights)
 {
-  const auto& point = pointCloud[packedVoxel[index].index];
-  const int32_t retainedSize = retained.size();
-  int32_t j = retainedSize - 2;
-  int32_t k = 0;
-  while (j >= 0 && ++k < searchRange) {
-    const int32_t index1 = retained[j];
-    const int32_t pointIndex1 = packedVoxel[index1].index;
-    const auto& point1 = pointCloud[pointIndex1];
-    const auto d2 = (point1 - point).getNorm2<double>();
-    if (d2 <= radius2) {
-      return index1;
+  const int pointCount = int(quantizationWeights.size());
+  liftingQuantWeights.resize(pointCount);
+  parallelFor(numThreads, 0, pointCount, [&](int predictorIndex) {
+    const uint64_t weight = quantizationWeights[predictorIndex];
+    auto& dst = liftingQuantWeights[predictorIndex];
+    dst.iQuantWeight = irsqrt(weight);
+    dst.quantWeight = (weight * dst.iQuantWeight + (1ull << 39)) >> 40;
+  });
+}
+
+//---------------------------------------------------------------------------
+
+// An index of the points retained by distance-based subsampling.  Points
+// are hashed by position into cubic cells whose size is at least twice the
+// subsampling radius, so that the neighbourhood of any point is covered by
+// at most 2x2x2 cells.  The points of each cell are linked in reverse
+// order of retention, permitting a search to be limited to the most
+// recently retained points.
+
+class RetainedPointGrid {
+public:
+  RetainedPointGrid(double radius2, size_t maxPoints)
+  {
+    _radius = int32_t(std::ceil(std::sqrt(radius2)));
+    _cellSizeLog2 = 0;
+    while ((int64_t(1) << _cellSizeLog2) < 2 * int64_t(_radius))
+      _cellSizeLog2++;
+
+    _cells.reserve(maxPoints);
+    _pos.reserve(maxPoints);
+    _prev.reserve(maxPoints);
+  }
+
+  // Adds the position of the next retained point
+  void insert(const point_t& pos)
+  {
+    int32_t ordinal = int32_t(_pos.size());
+    auto it = _cells.emplace(cellKey(pos >> _cellSizeLog2), ordinal);
+    _prev.push_back(it.second ? -1 : it.first->second);
+    it.first->second = ordinal;
+    _pos.push_back(pos);
+  }
+
+  // Tests if any retained point, with an ordinal of at least minOrdinal,
+  // lies within radius2 of pos
+  bool hasNeighbourWithinDistance(
+    const point_t& pos, double radius2, int32_t minOrdinal) const
+  {
+    const point_t lo = (pos - _radius) >> _cellSizeLog2;
+    const point_t hi = (pos + _radius) >> _cellSizeLog2;
+
+    point_t cell;
+    for (cell[0] = lo[0]; cell[0] <= hi[0]; cell[0]++) {
+      for (cell[1] = lo[1]; cell[1] <= hi[1]; cell[1]++) {
+        for (cell[2] = lo[2]; cell[2] <= hi[2]; cell[2]++) {
+          auto it = _cells.find(cellKey(cell));
+          if (it == _cells.end())
+            continue;
+
+          for (int32_t i = it->second; i >= minOrdinal; i = _prev[i]) {
+            if ((_pos[i] - pos).getNorm2<double>() <= radius2)
+              return true;
+          }
+        }
+      }
     }
-    --j;
+
+    return false;
   }
-  return PCC_UNDEFINED_INDEX;
-}
+
+private:
+  // NB: cells that alias only increase the number of candidate points
+  static uint64_t cellKey(const point_t& cell)
+  {
+    const uint64_t kMask = (uint64_t(1) << 21) - 1;
+    return (uint64_t(cell[0]) & kMask) << 42
+      | (uint64_t(cell[1]) & kMask) << 21 | (uint64_t(cell[2]) & kMask);
+  }
+
+  int32_t _radius;
+  int _cellSizeLog2;
+
+  // The most recently retained point of each cell
+  std::unordered_map<uint64_t, int32_t> _cells;
+
+  // Position of each retained point, and the previously retained point in
+  // the same cell (or -1)
+  std::vector<point_t> _pos;
+  std::vector<int32_t> _prev;
+};
 
 //---------------------------------------------------------------------------
 
@@ -744,25 +847,35 @@ subsampleByDistance(
 {
   if (input.size() == 1) {
     indexes.push_back(input[0]);
-  } else {
-    for (const auto index : input) {
-      if (retained.empty()) {
-        retained.push_back(index);
-        continue;
-      }
-      const auto& point = pointCloud[packedVoxel[index].index];
-      const auto& lastRetained =
-        pointCloud[packedVoxel[retained.back()].index];
-      auto distanceToLastRetained = (lastRetained - point).getNorm2<double>();
-      if (
-        distanceToLastRetained <= radius2
-        || FindNeighborWithinDistance(
-             pointCloud, packedVoxel, index, radius2, searchRange, retained)
-          != PCC_UNDEFINED_INDEX) {
-        indexes.push_back(index);
-      } else {
-        retained.push_back(index);
-      }
+    return;
+  }
+
+  RetainedPointGrid grid(radius2, retained.size() + input.size());
+  for (const auto index : retained)
+    grid.insert(pointCloud[packedVoxel[index].index]);
+
+  for (const auto index : input) {
+    if (retained.empty()) {
+      retained.push_back(index);
+      grid.insert(pointCloud[packedVoxel[index].index]);
+      continue;
+    }
+
+    // A point is subsampled if it is within radius2 of any of the last
+    // searchRange retained points (the last retained point is always
+    // considered).
+    const auto& point = pointCloud[packedVoxel[index].index];
+    const auto& lastRetained = pointCloud[packedVoxel[retained.back()].index];
+    const int32_t minOrdinal =
+      std::max(0, int32_t(retained.size()) - std::max(1, searchRange));
+
+    if (
+      (lastRetained - point).getNorm2<double>() <= radius2
+      || grid.hasNeighbourWithinDistance(point, radius2, minOrdinal)) {
+      indexes.push_back(index);
+    } else {
+      retained.push_back(index);
+      grid.insert(point);
     }
   }
 }
@@ -36,12 +36,17 @@
 #pragma once
 
 #include <functional>
+#include <iostream>
 #include <map>
+#include <string>
+#include <vector>
 
 #include "Attribute.h"
 #include "PayloadBuffer.h"
 #include "PCCMath.h"
 #include "PCCPointSet.h"
+#include "geometry_octree.h"
+#include "geometry_predictive.h"
 #include "hls.h"
 
 namespace pcc {
@@ -53,6 +58,23 @@ struct DecoderParams {
   // layers to skip during the decode process (attribute coding must take
   // this into account)
   int minGeomNodeSizeLog2;
+
+  // Names of attributes that are not to be decoded
+  std::vector<std::string> skipAttributes;
+
+  // Region of interest (xyz order, inclusive of the sequence bounding box
+  // origin).  Points outside the region are not output.  Slices that do
+  // not intersect the region are not decoded.  Disabled if roiSize is 0;
+  // otherwise a zero component leaves that axis unbounded.
+  Vec3<int> roiOrigin;
+  Vec3<int> roiSize;
+
+  // Retain attribute LoDs between slices and frames and reuse them when
+  // the geometry of a slice is unchanged
+  bool attrLodCacheEnabled;
+
+  // Maximum number of threads used by parallelised decoding stages
+  int numThreads;
 };
 
 //============================================================================
@@ -61,7 +83,11 @@ class PCCTMC3Decoder3 {
 public:
   class Callbacks;
 
-  PCCTMC3Decoder3(const DecoderParams& params) : _params(params) { init(); }
+  PCCTMC3Decoder3(const DecoderParams& params)
+    : _params(params), _log(&std::cout)
+  {
+    init();
+  }
 
   PCCTMC3Decoder3(const PCCTMC3Decoder3&) = delete;
   PCCTMC3Decoder3(PCCTMC3Decoder3&&) = default;
@@ -73,6 +99,10 @@ public:
 
   int decompress(const PayloadBuffer* buf, Callbacks* callback);
 
+  // Sets the stream to which decoding statistics are written (std::cout by
+  // default).
+  void setLog(std::ostream* log) { _log = log; }
+
   //==========================================================================
 
   void storeSps(SequenceParameterSet&& sps);
@@ -84,6 +114,11 @@ public:
 
 private:
   void activateParameterSets(const GeometryBrickHeader& gbh);
+  void accumulateSlice();
+  bool isAttributeSkipped(const AttributeDescription& desc) const;
+  bool roiEnabled() const;
+  Box3<int32_t> sliceRoi(const GeometryBrickHeader& gbh) const;
+  bool sliceIntersectsRoi(const GeometryBrickHeader& gbh) const;
   int decodeGeometryBrick(const PayloadBuffer& buf);
   void decodeAttributeBrick(const PayloadBuffer& buf);
   void decodeConstantAttribute(const PayloadBuffer& buf);
@@ -95,15 +130,27 @@ private:
   // Decoder specific parameters
   DecoderParams _params;
 
+  // Destination of decoding statistics
+  std::ostream* _log;
+
   // Current identifier of payloads with the same geometry
   int _sliceId;
 
+  // Identifier of the last decoded geometry slice
+  int _prevSliceId;
+
   // The last decoded frame_idx
   int _currentFrameIdx;
 
   // Position of the slice in the translated+scaled co-ordinate system.
   Vec3<int> _sliceOrigin;
 
+  // The region of interest relative to the current slice origin
+  Box3<int32_t> _sliceRoi;
+
+  // Indicates that the data units of the current slice are to be ignored
+  bool _skipSlice;
+
   // The point cloud currently being decoded
   PCCPointSet3 _currentPointCloud;
   PCCPointSet3 _accumCloud;
@@ -122,16 +169,23 @@ private:
 
   GeometryBrickHeader _gbh;
 
-  // Attribute decoder for reuse between attributes of same slice
-  std::unique_ptr<AttributeDecoderIntf> _attrDecoder;
+  // Entropy context state retained for continuation by the next slice
+  GeometryOctreeContexts _ctxtMemOctreeGeom;
+  PredGeomContexts _ctxtMemPredGeom;
+
+  // Attribute decoders for reuse between attributes of same slice, and
+  // between slices when attrLodCacheEnabled is set
+  AttributeCoderCache<AttributeDecoderIntf> _attrDecoders;
 };
 
 //----------------------------------------------------------------------------
 
 class PCCTMC3Decoder3::Callbacks {
 public:
+  // NB: the callee may modify the cloud in place, or take ownership of its
+  // contents (eg, by swapping); it is discarded by the decoder on return.
   virtual void
-  onOutputCloud(const SequenceParameterSet&, const PCCPointSet3&) = 0;
+  onOutputCloud(const SequenceParameterSet&, PCCPointSet3& cloud) = 0;
 };
 
 //============================================================================
@@ -35,11 +35,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
+#include <iosfwd>
 #include <map>
 #include <string>
 #include <vector>
 
+#include "Attribute.h"
 #include "PayloadBuffer.h"
 #include "PCCMath.h"
 #include "PCCPointSet.h"
@@ -48,6 +51,8 @@
 #include "hls.h"
 #include "partitioning.h"
 #include "geometry.h"
+#include "geometry_octree.h"
+#include "geometry_predictive.h"
 
 namespace pcc {
 
@@ -111,6 +116,13 @@ struct EncoderParams {
 
   // Qp used for IDCM quantisation (used to derive HLS values)
   int idcmQp;
+
+  // Maximum number of threads used by parallelised encoding stages
+  int numThreads;
+
+  // Retain attribute LoDs between slices and reuse them when the geometry
+  // of a slice is unchanged
+  bool attrLodCacheEnabled;
 };
 
 //============================================================================
@@ -132,6 +144,29 @@ public:
     Callbacks*,
     PCCPointSet3* reconstructedCloud = nullptr);
 
+  // Low-latency encoding of a frame supplied incrementally as points in
+  // acquisition order.  The buffered points are coded as a slice whenever
+  // partition.sliceMaxPoints or partition.sliceMaxDurationMs is reached.
+  // endSlice() codes any buffered points immediately, and endFrame()
+  // completes the frame.
+  //
+  // NB: the sequence bounding box must be set.
+  int pushPoints(
+    const PCCPointSet3& points,
+    EncoderParams* params,
+    Callbacks*,
+    PCCPointSet3* reconstructedCloud = nullptr);
+
+  int endSlice(
+    EncoderParams* params,
+    Callbacks*,
+    PCCPointSet3* reconstructedCloud = nullptr);
+
+  int endFrame(
+    EncoderParams* params,
+    Callbacks*,
+    PCCPointSet3* reconstructedCloud = nullptr);
+
   void compressPartition(
     const PCCPointSet3& inputPointCloud,
     const PCCPointSet3& originPartCloud,
@@ -142,7 +177,20 @@ public:
   static void deriveParameterSets(EncoderParams* params);
   static void fixupParameterSets(EncoderParams* params);
 
+  // Sets the stream to which coding statistics are written (std::cout by
+  // default).
+  void setLog(std::ostream* log) { _log = log; }
+
 private:
+  PCCPointSet3 beginFrame(
+    const PCCPointSet3& inputPointCloud, EncoderParams* params, Callbacks*);
+
+  void compressStreamSlice(
+    const PCCPointSet3& sliceCloud,
+    EncoderParams* params,
+    Callbacks*,
+    PCCPointSet3* reconstructedCloud);
+
   void appendReconstructedPoints(PCCPointSet3* reconstructedCloud);
 
   void encodeGeometryBrick(const EncoderParams*, PayloadBuffer* buf);
@@ -177,19 +225,45 @@ private:
   // Identifies the current tile
   int _tileId;
 
+  // Identifier of the previously coded slice, and whether the current
+  // slice is the first of the frame
+  int _prevSliceId;
+  bool _firstSliceInFrame;
+
+  // Entropy context state retained between slices
+  GeometryOctreeContexts _ctxtMemOctreeGeom;
+  PredGeomContexts _ctxtMemPredGeom;
+
+  // Attribute encoders retained between slices (with their LoDs) when
+  // attrLodCacheEnabled is set
+  AttributeCoderCache<AttributeEncoderIntf> _attrEncoders;
+
   // Current frame number.
   // NB: only the log2_max_frame_idx LSBs are sampled for frame_idx
   int _frameCounter;
 
   // Map quantized points to the original input points
   std::multimap<point_t, int32_t> quantizedToOrigin;
+
+  // Points pushed for low-latency encoding that are yet to be coded
+  PCCPointSet3 _streamCloud;
+
+  // The time at which buffering of the current stream slice began
+  std::chrono::steady_clock::time_point _streamSliceStart;
+
+  // Indicates that the first slice of a pushed frame has been coded
+  bool _streamFrameStarted;
+
+  // Destination of coding statistics
+  std::ostream* _log;
 };
 
 //----------------------------------------------------------------------------
 
 class PCCTMC3Encoder3::Callbacks {
 public:
-  virtual void onOutputBuffer(const PayloadBuffer&) = 0;
+  // NB: ownership of the buffer is transferred to the callee.
+  virtual void onOutputBuffer(PayloadBuffer&&) = 0;
   virtual void onPostRecolour(const PCCPointSet3&) = 0;
 };
 
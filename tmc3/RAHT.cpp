@@ -45,6 +45,8 @@
 
 #include "PCCTMC3Common.h"
 #include "PCCMisc.h"
+#include "cpu_features.h"
+#include "raht_kernels.h"
 
 namespace pcc {
 
@@ -353,23 +355,101 @@ intraDcPred(
   }
 }
 
+//============================================================================
+// Memoised square roots and reciprocal square roots of node weights.
+//
+// The same (small) weights recur throughout the tree.  The cache avoids
+// recomputing the fixed-point approximations for each node and transform
+// direction.  It grows on demand; weights above kMaxCachedWeight, which
+// occur only near the root, are not cached.
+
+class RahtWeightCache {
+public:
+  // The fixed-point square root of weight: isqrt(weight << 2 * kFracBits)
+  uint64_t sqrt(int weight);
+
+  // The reciprocal square root of weight: irsqrt(weight)
+  uint64_t rsqrt(int weight);
+
+private:
+  static const int kMaxCachedWeight = 1 << 12;
+
+  // Extends the cache to include weight
+  void grow(int weight);
+
+  // NB: zero indicates an uncomputed entry
+  std::vector<uint64_t> _sqrt;
+  std::vector<uint64_t> _rsqrt;
+};
+
+//----------------------------------------------------------------------------
+
+void
+RahtWeightCache::grow(int weight)
+{
+  size_t size = std::max(size_t(weight) + 1, 2 * _sqrt.size());
+  size = std::min(size, size_t(kMaxCachedWeight) + 1);
+  _sqrt.resize(size, 0);
+  _rsqrt.resize(size, 0);
+}
+
+//----------------------------------------------------------------------------
+
+inline uint64_t
+RahtWeightCache::sqrt(int weight)
+{
+  if (weight > kMaxCachedWeight)
+    return isqrt(uint64_t(weight) << (2 * FixedPoint::kFracBits));
+
+  if (weight >= int(_sqrt.size()))
+    grow(weight);
+
+  auto& val = _sqrt[weight];
+  if (!val)
+    val = isqrt(uint64_t(weight) << (2 * FixedPoint::kFracBits));
+  return val;
+}
+
+//----------------------------------------------------------------------------
+
+inline uint64_t
+RahtWeightCache::rsqrt(int weight)
+{
+  if (weight > kMaxCachedWeight)
+    return irsqrt(weight);
+
+  if (weight >= int(_rsqrt.size()))
+    grow(weight);
+
+  auto& val = _rsqrt[weight];
+  if (!val)
+    val = irsqrt(weight);
+  return val;
+}
+
 //============================================================================
 // Encapsulation of a RAHT transform stage.
 
 class RahtKernel {
 public:
-  RahtKernel(int weightLeft, int weightRight)
+  RahtKernel(RahtWeightCache& cache, int weightLeft, int weightRight)
+  {
+    uint64_t isqrtW = cache.rsqrt(weightLeft + weightRight);
+    _a.val = (cache.sqrt(weightLeft) * isqrtW) >> 40;
+    _b.val = (cache.sqrt(weightRight) * isqrtW) >> 40;
+  }
+
+  RahtKernel(int64_t a, int64_t b)
   {
-    uint64_t w = weightLeft + weightRight;
-    uint64_t isqrtW = irsqrt(w);
-    _a.val =
-      (isqrt(uint64_t(weightLeft) << (2 * _a.kFracBits)) * isqrtW) >> 40;
-    _b.val =
-      (isqrt(uint64_t(weightRight) << (2 * _b.kFracBits)) * isqrtW) >> 40;
+    _a.val = a;
+    _b.val = b;
   }
 
+  int64_t a() const { return _a.val; }
+  int64_t b() const { return _b.val; }
+
   void fwdTransform(
-    FixedPoint left, FixedPoint right, FixedPoint* lf, FixedPoint* hf)
+    FixedPoint left, FixedPoint right, FixedPoint* lf, FixedPoint* hf) const
   {
     FixedPoint a = _a, b = _b;
     // lf = left * a + right * b
@@ -388,7 +468,7 @@ public:
   }
 
   void invTransform(
-    FixedPoint lf, FixedPoint hf, FixedPoint* left, FixedPoint* right)
+    FixedPoint lf, FixedPoint hf, FixedPoint* left, FixedPoint* right) const
   {
     FixedPoint a = _a, b = _b;
 
@@ -409,12 +489,36 @@ private:
 };
 
 //============================================================================
-// In-place transform a set of sparse 2x2x2 blocks each using the same weights
+// Derive the butterfly coefficients for each pair of weights in a block.
 
-template<class Kernel>
 void
-fwdTransformBlock222(int numBufs, FixedPoint buf[][8], int weights[8 + 4 + 2])
+mkBlockCoeffs(
+  RahtWeightCache& cache,
+  const int weights[8 + 4 + 2],
+  RahtBlockCoeffs* coeffs)
 {
+  coeffs->weights = weights;
+  for (int i = 0; i < 4 + 2 + 1; i++) {
+    int weightLeft = weights[2 * i];
+    int weightRight = weights[2 * i + 1];
+    coeffs->a[i] = coeffs->b[i] = 0;
+    if (!weightLeft || !weightRight)
+      continue;
+
+    RahtKernel kernel(cache, weightLeft, weightRight);
+    coeffs->a[i] = kernel.a();
+    coeffs->b[i] = kernel.b();
+  }
+}
+
+//============================================================================
+// In-place transform a set of sparse 2x2x2 blocks each using the same weights
+
+static void
+fwdTransformBlock222Scalar(
+  const RahtBlockCoeffs& coeffs, int numBufs, int64_t buf[][8])
+{
+  const int* weights = coeffs.weights;
   for (int iw = 0, stride = 1; stride < 8; stride <<= 1) {
     for (int i0 = 0; i0 < 8; i0 += 2 * stride, iw += 2) {
       int i1 = i0 + stride;
@@ -433,10 +537,14 @@ fwdTransformBlock222(int numBufs, FixedPoint buf[][8], int weights[8 + 4 + 2])
       }
 
       // actual transform
-      Kernel kernel(weights[iw], weights[iw + 1]);
+      RahtKernel kernel(coeffs.a[iw >> 1], coeffs.b[iw >> 1]);
       for (int k = 0; k < numBufs; k++) {
-        auto& bufk = buf[k];
-        kernel.fwdTransform(bufk[i0], bufk[i1], &bufk[i0], &bufk[i1]);
+        FixedPoint left, right, lf, hf;
+        left.val = buf[k][i0];
+        right.val = buf[k][i1];
+        kernel.fwdTransform(left, right, &lf, &hf);
+        buf[k][i0] = lf.val;
+        buf[k][i1] = hf.val;
       }
     }
   }
@@ -446,10 +554,11 @@ fwdTransformBlock222(int numBufs, FixedPoint buf[][8], int weights[8 + 4 + 2])
 // In-place inverse transform a set of sparse 2x2x2 blocks each using the
 // same weights
 
-template<class Kernel>
-void
-invTransformBlock222(int numBufs, FixedPoint buf[][8], int weights[8 + 4 + 2])
+static void
+invTransformBlock222Scalar(
+  const RahtBlockCoeffs& coeffs, int numBufs, int64_t buf[][8])
 {
+  const int* weights = coeffs.weights;
   for (int iw = 12, stride = 4; stride > 0; stride >>= 1) {
     for (int i1 = 8 - stride; i1 > 0; i1 -= 2 * stride, iw -= 2) {
       int i0 = i1 - stride;
@@ -468,15 +577,71 @@ invTransformBlock222(int numBufs, FixedPoint buf[][8], int weights[8 + 4 + 2])
       }
 
       // actual transform
-      Kernel kernel(weights[iw], weights[iw + 1]);
+      RahtKernel kernel(coeffs.a[iw >> 1], coeffs.b[iw >> 1]);
       for (int k = 0; k < numBufs; k++) {
-        auto& bufk = buf[k];
-        kernel.invTransform(bufk[i0], bufk[i1], &bufk[i0], &bufk[i1]);
+        FixedPoint lf, hf, left, right;
+        lf.val = buf[k][i0];
+        hf.val = buf[k][i1];
+        kernel.invTransform(lf, hf, &left, &right);
+        buf[k][i0] = left.val;
+        buf[k][i1] = right.val;
       }
     }
   }
 }
 
+//----------------------------------------------------------------------------
+
+const RahtKernels kRahtKernelsScalar = {
+  fwdTransformBlock222Scalar,
+  invTransformBlock222Scalar,
+};
+
+//----------------------------------------------------------------------------
+// The block transform kernels best suited to the host processor.
+
+static const RahtKernels&
+selectRahtKernels()
+{
+#if HAVE_X86_SIMD
+  switch (hostSimdLevel()) {
+  case SimdLevel::kAvx2: return kRahtKernelsAvx2;
+  case SimdLevel::kSse41: return kRahtKernelsSse41;
+  case SimdLevel::kNone: break;
+  }
+#endif
+
+  return kRahtKernelsScalar;
+}
+
+//----------------------------------------------------------------------------
+// Apply a block transform kernel to a set of fixed-point blocks.
+
+static_assert(
+  sizeof(FixedPoint) == sizeof(int64_t), "FixedPoint must wrap an int64_t");
+
+static void
+fwdTransformBlock222(
+  const RahtKernels& kernels,
+  const RahtBlockCoeffs& coeffs,
+  int numBufs,
+  FixedPoint buf[][8])
+{
+  kernels.fwdTransformBlock222(
+    coeffs, numBufs, reinterpret_cast<int64_t(*)[8]>(buf));
+}
+
+static void
+invTransformBlock222(
+  const RahtKernels& kernels,
+  const RahtBlockCoeffs& coeffs,
+  int numBufs,
+  FixedPoint buf[][8])
+{
+  kernels.invTransformBlock222(
+    coeffs, numBufs, reinterpret_cast<int64_t(*)[8]>(buf));
+}
+
 //============================================================================
 // expand a set of eight weights into three levels
 
@@ -568,6 +733,9 @@ uraht_process(
   std::vector<UrahtNode> weightsLf, weightsHf;
   std::vector<int> attrsLf, attrsHf;
 
+  RahtWeightCache weightCache;
+  const RahtKernels& kernels = selectRahtKernels();
+
   weightsLf.reserve(numPoints);
   attrsLf.reserve(numPoints * numAttrs);
 
@@ -669,6 +837,7 @@ uraht_process(
       FixedPoint transformBuf[6][8] = {};
       FixedPoint(*transformPredBuf)[8] = &transformBuf[numAttrs];
       int weights[8 + 4 + 2] = {};
+      RahtBlockCoeffs blockCoeffs;
       Qps nodeQp[8 + 4 + 2] = {};
       uint8_t occupancy = 0;
 
@@ -694,6 +863,7 @@ uraht_process(
       }
 
       mkWeightTree(weights);
+      mkBlockCoeffs(weightCache, weights, &blockCoeffs);
 
       if (!inheritDc) {
         for (int j = i, nodeIdx = 0; nodeIdx < 8; nodeIdx++) {
@@ -757,7 +927,8 @@ uraht_process(
           uint64_t w = weights[childIdx];
           int shift = (w > 1024 ? 5 : 0) + (w > 16384 ? 2 : 0)
             + (w > 262144 ? 2 : 0) + (w > 4194304 ? 2 : 0);
-          rsqrtWeight.val = irsqrt(w) >> (40 - shift - FixedPoint::kFracBits);
+          rsqrtWeight.val =
+            weightCache.rsqrt(w) >> (40 - shift - FixedPoint::kFracBits);
           for (int k = 0; k < numAttrs; k++) {
             transformBuf[k][childIdx].val >>= shift;
             transformBuf[k][childIdx] *= rsqrtWeight;
@@ -767,8 +938,7 @@ uraht_process(
         // Predicted attribute values
         if (enablePrediction) {
           FixedPoint sqrtWeight;
-          sqrtWeight.val =
-            isqrt(uint64_t(weights[childIdx]) << (2 * FixedPoint::kFracBits));
+          sqrtWeight.val = weightCache.sqrt(weights[childIdx]);
           for (int k = 0; k < numAttrs; k++)
             transformPredBuf[k][childIdx] *= sqrtWeight;
         }
@@ -778,11 +948,13 @@ uraht_process(
       //  - encoder: transform both attribute sums and prediction
       //  - decoder: just transform prediction
       if (isEncoder && enablePrediction)
-        fwdTransformBlock222<RahtKernel>(2 * numAttrs, transformBuf, weights);
+        fwdTransformBlock222(
+          kernels, blockCoeffs, 2 * numAttrs, transformBuf);
       else if (isEncoder)
-        fwdTransformBlock222<RahtKernel>(numAttrs, transformBuf, weights);
+        fwdTransformBlock222(kernels, blockCoeffs, numAttrs, transformBuf);
       else if (enablePrediction)
-        fwdTransformBlock222<RahtKernel>(numAttrs, transformPredBuf, weights);
+        fwdTransformBlock222(
+          kernels, blockCoeffs, numAttrs, transformPredBuf);
 
       // per-coefficient operations:
       //  - subtract transform domain prediction (encoder)
@@ -832,7 +1004,7 @@ uraht_process(
         }
       }
 
-      invTransformBlock222<RahtKernel>(numAttrs, transformPredBuf, weights);
+      invTransformBlock222(kernels, blockCoeffs, numAttrs, transformPredBuf);
 
       for (int j = i, nodeIdx = 0; nodeIdx < 8; nodeIdx++) {
         if (!weights[nodeIdx])
@@ -850,7 +1022,8 @@ uraht_process(
           uint64_t w = weights[nodeIdx];
           int shift = (w > 1024 ? 5 : 0) + (w > 16384 ? 2 : 0)
             + (w > 262144 ? 2 : 0) + (w > 4194304 ? 2 : 0);
-          rsqrtWeight.val = irsqrt(w) >> (40 - shift - FixedPoint::kFracBits);
+          rsqrtWeight.val =
+            weightCache.rsqrt(w) >> (40 - shift - FixedPoint::kFracBits);
           for (int k = 0; k < numAttrs; k++) {
             transformPredBuf[k][nodeIdx].val >>= shift;
             transformPredBuf[k][nodeIdx] *= rsqrtWeight;
@@ -888,7 +1061,7 @@ uraht_process(
     FixedPoint attrSum[3];
     FixedPoint attrRecDc[3];
     FixedPoint sqrtWeight;
-    sqrtWeight.val = isqrt(uint64_t(weight) << (2 * FixedPoint::kFracBits));
+    sqrtWeight.val = weightCache.sqrt(weight);
     for (int k = 0; k < numAttrs; k++) {
       if (isEncoder)
         attrSum[k] = attrsLf[i * numAttrs + k];
@@ -898,11 +1071,12 @@ uraht_process(
 
     FixedPoint rsqrtWeight;
     for (int w = weight - 1; w > 0; w--) {
-      RahtKernel kernel(w, 1);
+      RahtKernel kernel(weightCache, w, 1);
       int shift = (w > 1024 ? 5 : 0) + (w > 16384 ? 2 : 0)
         + (w > 262144 ? 2 : 0) + (w > 4194304 ? 2 : 0);
       if (isEncoder)
-        rsqrtWeight.val = irsqrt(w) >> (40 - shift - FixedPoint::kFracBits);
+        rsqrtWeight.val =
+          weightCache.rsqrt(w) >> (40 - shift - FixedPoint::kFracBits);
 
       auto quantizers = qpset.quantizers(qpLayer, nodeQp);
       for (int k = 0; k < numAttrs; k++) {
@@ -36,14 +36,19 @@
 #include "TMC3.h"
 
 #include <memory>
+#include <sstream>
 
 #include "PCCTMC3Encoder.h"
 #include "PCCTMC3Decoder.h"
+#include "codec_options.h"
 #include "constants.h"
 #include "ply.h"
 #include "pointset_processing.h"
 #include "program_options_lite.h"
+#include "io_points.h"
 #include "io_tlv.h"
+#include "io_tlv_writer.h"
+#include "osspecific.h"
 #include "version.h"
 
 using namespace std;
@@ -54,18 +59,12 @@ using namespace pcc;
 struct Parameters {
   bool isDecoder;
 
-  // command line parsing should adjust dist2 values according to PQS
-  bool positionQuantizationScaleAdjustsDist2;
-
   // output mode for ply writing (binary or ascii)
   bool outputBinaryPly;
 
   // output ply resolution in points per metre (or 0 for undefined)
   float outputResolution;
 
-  // when true, configure the encoder as if no attributes are specified
-  bool disableAttributeCoding;
-
   // Frame number of first file in input sequence.
   int firstFrameNum;
 
@@ -82,7 +81,8 @@ struct Parameters {
   // Filename for saving pre inverse scaled point cloud (decoder).
   std::string preInvScalePath;
 
-  pcc::EncoderParams encoder;
+  pcc::CodecOptions codec;
+  pcc::EncoderOptions encoder;
   pcc::DecoderParams decoder;
 
   // perform attribute colourspace conversion on ply input/output.
@@ -91,10 +91,41 @@ struct Parameters {
   // todo(df): this should be per-attribute
   int reflectanceScale;
 
-  // resort the input points by azimuth angle
-  bool sortInputByAzimuth;
+  // true if any of the data paths refer to stdin or stdout
+  bool usesStdio() const;
 };
 
+//----------------------------------------------------------------------------
+// The path "-" refers to stdin (for input) or stdout (for output).
+
+static bool
+isStdio(const std::string& path)
+{
+  return path == "-";
+}
+
+//----------------------------------------------------------------------------
+
+bool
+Parameters::usesStdio() const
+{
+  return isStdio(uncompressedDataPath) || isStdio(compressedStreamPath)
+    || isStdio(reconstructedDataPath);
+}
+
+//----------------------------------------------------------------------------
+// The stream buffer originally attached to stdout.  When stdout is used
+// for data, std::cout is redirected to stderr to keep the log separate.
+
+static std::streambuf* stdoutStreamBuf;
+
+static std::ostream&
+stdoutDataStream()
+{
+  static std::ostream os(stdoutStreamBuf);
+  return os;
+}
+
 //----------------------------------------------------------------------------
 
 class SequenceEncoder : public PCCTMC3Encoder3::Callbacks {
@@ -110,7 +141,7 @@ public:
 protected:
   int compressOneFrame(Stopwatch* clock);
 
-  void onOutputBuffer(const PayloadBuffer& buf) override;
+  void onOutputBuffer(PayloadBuffer&& buf) override;
   void onPostRecolour(const PCCPointSet3& cloud) override;
 
 private:
@@ -124,6 +155,9 @@ private:
 
   std::ofstream bytestreamFile;
 
+  // Writes the output bitstream to either bytestreamFile or stdout
+  std::unique_ptr<AsyncTlvWriter> bytestreamWriter;
+
   int frameNum;
 };
 
@@ -141,43 +175,51 @@ public:
 
 protected:
   void onOutputCloud(
-    const SequenceParameterSet& sps,
-    const PCCPointSet3& decodedPointCloud) override;
+    const SequenceParameterSet& sps, PCCPointSet3& pointCloud) override;
 
 private:
   const Parameters* params;
   PCCTMC3Decoder3 decoder;
 
-  std::ofstream bytestreamFile;
-
   int frameNum;
   Stopwatch* clock;
 };
 
 //============================================================================
 
-void convertToGbr(const SequenceParameterSet& sps, PCCPointSet3& cloud);
-void convertFromGbr(const SequenceParameterSet& sps, PCCPointSet3& cloud);
-
-//============================================================================
-
 int
 main(int argc, char* argv[])
 {
+  // NB: whether stdout carries data is unknown until the parameters are
+  //     parsed; any log output is held back until then.
+  std::stringstream earlyLog;
+  stdoutStreamBuf = cout.rdbuf(earlyLog.rdbuf());
+
   cout << "MPEG PCC tmc3 version " << ::pcc::version << endl;
 
   Parameters params;
 
+  bool parsed = false;
   try {
-    if (!ParseParameters(argc, argv, params))
-      return 1;
+    parsed = ParseParameters(argc, argv, params);
   }
   catch (df::program_options_lite::ParseFailure& e) {
     std::cerr << "Error parsing option \"" << e.arg << "\" with argument \""
               << e.val << "\"." << std::endl;
-    return 1;
   }
 
+  // Send all log output to stderr if stdout is used for data
+  if (parsed && params.usesStdio()) {
+    cout.rdbuf(cerr.rdbuf());
+    setStdioBinaryMode();
+  } else {
+    cout.rdbuf(stdoutStreamBuf);
+  }
+  cout << earlyLog.str() << std::flush;
+
+  if (!parsed)
+    return 1;
+
   // Timers to count elapsed wall/user time
   pcc::chrono::Stopwatch<std::chrono::steady_clock> clock_wall;
   pcc::chrono::Stopwatch<pcc::chrono::utime_inc_children_clock> clock_user;
@@ -202,176 +244,6 @@ main(int argc, char* argv[])
   return ret;
 }
 
-//---------------------------------------------------------------------------
-
-std::array<const char*, 3>
-axisOrderToPropertyNames(AxisOrder order)
-{
-  static const std::array<const char*, 3> kAxisOrderToPropertyNames[] = {
-    {"z", "y", "x"}, {"x", "y", "z"}, {"x", "z", "y"}, {"y", "z", "x"},
-    {"z", "y", "x"}, {"z", "x", "y"}, {"y", "x", "z"}, {"x", "y", "z"},
-  };
-
-  return kAxisOrderToPropertyNames[int(order)];
-}
-
-//---------------------------------------------------------------------------
-// :: Command line / config parsing helpers
-
-template<typename T>
-static std::istream&
-readUInt(std::istream& in, T& val)
-{
-  unsigned int tmp;
-  in >> tmp;
-  val = T(tmp);
-  return in;
-}
-
-namespace pcc {
-static std::istream&
-operator>>(std::istream& in, ColourMatrix& val)
-{
-  return readUInt(in, val);
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::istream&
-operator>>(std::istream& in, AxisOrder& val)
-{
-  return readUInt(in, val);
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::istream&
-operator>>(std::istream& in, AttributeEncoding& val)
-{
-  return readUInt(in, val);
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::istream&
-operator>>(std::istream& in, PartitionMethod& val)
-{
-  return readUInt(in, val);
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::istream&
-operator>>(std::istream& in, PredGeomEncOpts::SortMode& val)
-{
-  return readUInt(in, val);
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::ostream&
-operator<<(std::ostream& out, const ColourMatrix& val)
-{
-  switch (val) {
-  case ColourMatrix::kIdentity: out << "0 (Identity)"; break;
-  case ColourMatrix::kBt709: out << "1 (Bt709)"; break;
-  case ColourMatrix::kUnspecified: out << "2 (Unspecified)"; break;
-  case ColourMatrix::kReserved_3: out << "3 (Reserved)"; break;
-  case ColourMatrix::kUsa47Cfr73dot682a20:
-    out << "4 (Usa47Cfr73dot682a20)";
-    break;
-  case ColourMatrix::kBt601: out << "5 (Bt601)"; break;
-  case ColourMatrix::kSmpte170M: out << "6 (Smpte170M)"; break;
-  case ColourMatrix::kSmpte240M: out << "7 (Smpte240M)"; break;
-  case ColourMatrix::kYCgCo: out << "8 (kYCgCo)"; break;
-  case ColourMatrix::kBt2020Ncl: out << "9 (Bt2020Ncl)"; break;
-  case ColourMatrix::kBt2020Cl: out << "10 (Bt2020Cl)"; break;
-  case ColourMatrix::kSmpte2085: out << "11 (Smpte2085)"; break;
-  default: out << "Unknown"; break;
-  }
-  return out;
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::ostream&
-operator<<(std::ostream& out, const AxisOrder& val)
-{
-  switch (val) {
-  case AxisOrder::kZYX: out << "0 (zyx)"; break;
-  case AxisOrder::kXYZ: out << "1 (xyz)"; break;
-  case AxisOrder::kXZY: out << "2 (xzy)"; break;
-  case AxisOrder::kYZX: out << "3 (yzx)"; break;
-  case AxisOrder::kZYX_4: out << "4 (zyx)"; break;
-  case AxisOrder::kZXY: out << "5 (zxy)"; break;
-  case AxisOrder::kYXZ: out << "6 (yxz)"; break;
-  case AxisOrder::kXYZ_7: out << "7 (xyz)"; break;
-  }
-  return out;
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::ostream&
-operator<<(std::ostream& out, const AttributeEncoding& val)
-{
-  switch (val) {
-  case AttributeEncoding::kPredictingTransform: out << "0 (Pred)"; break;
-  case AttributeEncoding::kRAHTransform: out << "1 (RAHT)"; break;
-  case AttributeEncoding::kLiftingTransform: out << "2 (Lift)"; break;
-  }
-  return out;
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::ostream&
-operator<<(std::ostream& out, const PartitionMethod& val)
-{
-  switch (val) {
-  case PartitionMethod::kNone: out << "0 (None)"; break;
-  case PartitionMethod::kUniformGeom: out << "2 (UniformGeom)"; break;
-  case PartitionMethod::kOctreeUniform: out << "3 (UniformOctree)"; break;
-  case PartitionMethod::kUniformSquare: out << "4 (UniformSquare)"; break;
-  default: out << int(val) << " (Unknown)"; break;
-  }
-  return out;
-}
-}  // namespace pcc
-
-namespace pcc {
-static std::ostream&
-operator<<(std::ostream& out, const PredGeomEncOpts::SortMode& val)
-{
-  switch (val) {
-    using SortMode = PredGeomEncOpts::SortMode;
-  case SortMode::kNoSort: out << int(val) << " (None)"; break;
-  case SortMode::kSortMorton: out << int(val) << " (Morton)"; break;
-  case SortMode::kSortAzimuth: out << int(val) << " (Azimuth)"; break;
-  case SortMode::kSortRadius: out << int(val) << " (Radius)"; break;
-  default: out << int(val) << " (Unknown)"; break;
-  }
-  return out;
-}
-}  // namespace pcc
-
-namespace df {
-namespace program_options_lite {
-  template<typename T>
-  struct option_detail<pcc::Vec3<T>> {
-    static constexpr bool is_container = true;
-    static constexpr bool is_fixed_size = true;
-    typedef T* output_iterator;
-
-    static void clear(pcc::Vec3<T>& container){};
-    static output_iterator make_output_iterator(pcc::Vec3<T>& container)
-    {
-      return &container[0];
-    }
-  };
-}  // namespace program_options_lite
-}  // namespace df
-
 //---------------------------------------------------------------------------
 // :: Command line / config parsing
 
@@ -380,43 +252,8 @@ ParseParameters(int argc, char* argv[], Parameters& params)
 {
   namespace po = df::program_options_lite;
 
-  struct {
-    AttributeDescription desc;
-    AttributeParameterSet aps;
-    EncoderAttributeParams encoder;
-  } params_attr;
-
   bool print_help = false;
 
-  // a helper to set the attribute
-  std::function<po::OptionFunc::Func> attribute_setter =
-    [&](po::Options&, const std::string& name, po::ErrorReporter) {
-      // copy the current state of parsed attribute parameters
-      //
-      // NB: this does not cause the default values of attr to be restored
-      // for the next attribute block.  A side-effect of this is that the
-      // following is allowed leading to attribute foo having both X=1 and
-      // Y=2:
-      //   "--attr.X=1 --attribute foo --attr.Y=2 --attribute foo"
-      //
-
-      // NB: insert returns any existing element
-      const auto& it = params.encoder.attributeIdxMap.insert(
-        {name, int(params.encoder.attributeIdxMap.size())});
-
-      if (it.second) {
-        params.encoder.sps.attributeSets.push_back(params_attr.desc);
-        params.encoder.aps.push_back(params_attr.aps);
-        params.encoder.attr.push_back(params_attr.encoder);
-        return;
-      }
-
-      // update existing entry
-      params.encoder.sps.attributeSets[it.first->second] = params_attr.desc;
-      params.encoder.aps[it.first->second] = params_attr.aps;
-      params.encoder.attr[it.first->second] = params_attr.encoder;
-    };
-
   /* clang-format off */
   // The definition of the program/config options, along with default values.
   //
@@ -444,19 +281,23 @@ ParseParameters(int argc, char* argv[], Parameters& params)
 
   ("frameCount",
      params.frameCount, 1,
-     "Number of frames to encode")
+     "Number of frames to encode "
+     "(0 = until end of input when reading from stdin)")
 
   ("reconstructedDataPath",
     params.reconstructedDataPath, {},
-    "The ouput reconstructed pointcloud file path (decoder only)")
+    "The ouput reconstructed pointcloud file path (decoder only)\n"
+    "  -: write raw point frames to stdout")
 
   ("uncompressedDataPath",
     params.uncompressedDataPath, {},
-    "The input pointcloud file path")
+    "The input pointcloud file path\n"
+    "  -: read raw point frames from stdin")
 
   ("compressedStreamPath",
     params.compressedStreamPath, {},
-    "The compressed bitstream path (encoder=output, decoder=input)")
+    "The compressed bitstream path (encoder=output, decoder=input)\n"
+    "  -: use stdout (encoder) or stdin (decoder)")
 
   ("postRecolorPath",
     params.postRecolorPath, {},
@@ -484,429 +325,14 @@ ParseParameters(int argc, char* argv[], Parameters& params)
     params.reflectanceScale, 1,
     "scale factor to be applied to reflectance "
     "pre encoding / post reconstruction")
-
-  (po::Section("Decoder"))
-
-  ("skipOctreeLayers",
-    params.decoder.minGeomNodeSizeLog2, 0,
-    " 0   : Full decode. \n"
-    " N>0 : Skip the bottom N layers in decoding process.\n"
-    " skipLayerNum indicates the number of skipped lod layers from leaf lod.")
-
-  (po::Section("Encoder"))
-
-  ("sortInputByAzimuth",
-    params.sortInputByAzimuth, false,
-    "Sort input points by azimuth angle")
-
-  ("geometry_axis_order",
-    params.encoder.sps.geometry_axis_order, AxisOrder::kXYZ,
-    "Sets the geometry axis coding order:\n"
-    "  0: (zyx)\n  1: (xyz)\n  2: (xzy)\n"
-    "  3: (yzx)\n  4: (zyx)\n  5: (zxy)\n"
-    "  6: (yxz)\n  7: (xyz)")
-
-  // NB: the underlying variable is in STV order.
-  //     Conversion happens during argument sanitization.
-  ("seq_bounding_box_xyz0",
-    params.encoder.sps.seqBoundingBoxOrigin, {0},
-    "Origin (x,y,z) of the sequence bounding box. "
-    "NB: seq_bounding_box_whd must be set for paramter to have an effect")
-
-  // NB: the underlying variable is in STV order.
-  //     Conversion happens during argument sanitization.
-  ("seq_bounding_box_whd",
-    params.encoder.sps.seqBoundingBoxSize, {0},
-    "seq_bounding_box_whd")
-
-  ("srcResolution",
-    params.encoder.srcResolution, 0.f,
-    "Resolution of source point cloud in points per metre")
-
-  ("positionQuantizationScale",
-    params.encoder.geomPreScale, 1.f,
-    "Scale factor to be applied to point positions during pre-processing")
-
-  ("positionQuantizationScaleAdjustsDist2",
-    params.positionQuantizationScaleAdjustsDist2, false,
-    "Scale dist2 values by squared positionQuantizationScale")
-
-  ("mergeDuplicatedPoints",
-    params.encoder.gps.geom_unique_points_flag, true,
-    "Enables removal of duplicated points")
-
-  ("partitionMethod",
-    params.encoder.partition.method, PartitionMethod::kUniformSquare,
-    "Method used to partition input point cloud into slices/tiles:\n"
-    "  0: none\n"
-    "  1: none (deprecated)\n"
-    "  2: n Uniform-Geometry partition bins along the longest edge\n"
-    "  3: Uniform Geometry partition at n octree depth\n"
-    "  4: Uniform Square partition")
-
-  ("partitionOctreeDepth",
-    params.encoder.partition.octreeDepth, 1,
-    "Depth of octree partition for partitionMethod=4")
-
-  ("sliceMaxPoints",
-    params.encoder.partition.sliceMaxPoints, 1100000,
-    "Maximum number of points per slice")
-
-  ("sliceMinPoints",
-    params.encoder.partition.sliceMinPoints, 550000,
-    "Minimum number of points per slice (soft limit)")
-
-  ("tileSize",
-    params.encoder.partition.tileSize, 0,
-    "Partition input into cubic tiles of given size")
-
-  ("cabac_bypass_stream_enabled_flag",
-    params.encoder.sps.cabac_bypass_stream_enabled_flag, false,
-    "Controls coding method for ep(bypass) bins")
-
-  ("disableAttributeCoding",
-    params.disableAttributeCoding, false,
-    "Ignore attribute coding configuration")
-
-  ("enforceLevelLimits",
-    params.encoder.enforceLevelLimits, true,
-    "Abort if level limits exceeded")
-
-  (po::Section("Geometry"))
-
-  ("geomTreeType",
-    params.encoder.gps.predgeom_enabled_flag, false,
-    "Selects the tree coding method\n"
-    "  0: octree\n"
-    "  1: predictive")
-
-  ("qtbtEnabled",
-    params.encoder.gps.qtbt_enabled_flag, true,
-    "Enables non-cubic geometry bounding box")
-
-  ("maxNumQtBtBeforeOt",
-    params.encoder.geom.qtbt.maxNumQtBtBeforeOt, 4,
-    "Max number of qtbt partitions before ot")
-
-  ("minQtbtSizeLog2",
-    params.encoder.geom.qtbt.minQtbtSizeLog2, 0,
-    "Minimum size of qtbt partitions")
-
-  ("numOctreeEntropyStreams",
-    // NB: this is adjusted by minus 1 after the arguments are parsed
-    params.encoder.gbh.geom_stream_cnt_minus1, 1,
-    "Number of entropy streams for octree coding")
-
-  ("bitwiseOccupancyCoding",
-    params.encoder.gps.bitwise_occupancy_coding_flag, true,
-    "Selects between bitwise and bytewise occupancy coding:\n"
-    "  0: bytewise\n"
-    "  1: bitwise")
-
-  ("neighbourContextRestriction",
-    params.encoder.gps.neighbour_context_restriction_flag, false,
-    "Limit geometry octree occupancy contextualisation to sibling nodes")
-
-  ("neighbourAvailBoundaryLog2",
-    params.encoder.gps.neighbour_avail_boundary_log2, 0,
-    "Defines the avaliability volume for neighbour occupancy lookups."
-    " 0: unconstrained")
-
-  ("inferredDirectCodingMode",
-    params.encoder.gps.inferred_direct_coding_mode_enabled_flag, true,
-    "Permits early termination of the geometry octree for isolated points")
-
-  ("adjacentChildContextualization",
-    params.encoder.gps.adjacent_child_contextualization_enabled_flag, true,
-    "Occupancy contextualization using neighbouring adjacent children")
-
-  ("intra_pred_max_node_size_log2",
-    params.encoder.gps.intra_pred_max_node_size_log2, 0,
-    "octree nodesizes eligible for occupancy intra prediction")
-
-  ("planarEnabled",
-    params.encoder.gps.geom_planar_mode_enabled_flag, true,
-    "Use planar mode for geometry coding")
-
-  ("planarModeThreshold0",
-    params.encoder.gps.geom_planar_threshold0, 77,
-    "Activation threshold (0-127) of first planar mode. "
-    "Lower values imply more use of the first planar mode")
-
-  ("planarModeThreshold1",
-    params.encoder.gps.geom_planar_threshold1, 99,
-    "Activation threshold (0-127) of second planar mode. "
-    "Lower values imply more use of the first planar mode")
-
-  ("planarModeThreshold2",
-    params.encoder.gps.geom_planar_threshold2, 113,
-    "Activation threshold (0-127) of third planar mode. "
-    "Lower values imply more use of the third planar mode")
-
-   ("planarModeIdcmUse",
-    params.encoder.gps.geom_planar_idcm_threshold, 0,
-    "Degree (0-127) of IDCM activation when planar mode is enabled.\n"
-    "  0 => never, 127 => always")
-
-  ("trisoup_node_size_log2",
-    params.encoder.gps.trisoup_node_size_log2, 0,
-    "Size of nodes for surface triangulation.\n"
-    "  0: disabled\n")
-
-  ("trisoup_sampling_value",
-    params.encoder.gps.trisoup_sampling_value, 0,
-    "Trisoup voxelisation sampling rate\n"
-    "  0: automatic")
-
-  ("positionQuantisationEnabled",
-    params.encoder.gps.geom_scaling_enabled_flag, false,
-    "Enable in-loop quantisation of positions")
-
-  ("positionBaseQp",
-    params.encoder.gps.geom_base_qp, 0,
-    "Base QP used in position quantisation (0 = lossless)")
-
-  ("positionIdcmQp",
-    params.encoder.idcmQp, 0,
-    "QP used in position quantisation of IDCM nodes")
-
-  ("positionSliceQpOffset",
-    params.encoder.gbh.geom_slice_qp_offset, 0,
-    "Per-slice QP offset used in position quantisation")
-
-  ("positionQuantisationOctreeDepth",
-    params.encoder.gbh.geom_octree_qp_offset_depth, -1,
-    "Octree depth used for signalling position QP offsets (-1 => disabled)")
-
-  ("angularEnabled",
-    params.encoder.gps.geom_angular_mode_enabled_flag, false,
-    "Controls angular contextualisation of occupancy")
-
-  // NB: the underlying variable is in STV order.
-  //     Conversion happens during argument sanitization.
-  ("lidarHeadPosition",
-    params.encoder.gps.geomAngularOrigin, {0, 0, 0},
-    "laser head position (x, y, z) in angular mode")
-
-  ("numLasers",
-    params.encoder.numLasers, 0,
-    "Number of lasers in angular mode")
-
-  ("lasersTheta",
-    params.encoder.lasersTheta, {},
-    "Vertical laser angle in angular mode")
-
-  ("lasersZ",
-    params.encoder.lasersZ, {},
-    "Vertical laser offset in angular mode")
-
-  ("lasersNumPhiPerTurn",
-    params.encoder.gps.geom_angular_num_phi_per_turn, {},
-    "Number of sampling poisitions in a complete laser turn in angular mode")
-
-  ("planarBufferDisabled",
-    params.encoder.gps.planar_buffer_disabled_flag, false,
-    "Disable planar buffer (when angular mode is enabled)")
-
-  ("predGeomSort",
-    params.encoder.predGeom.sortMode, PredGeomEncOpts::kSortMorton,
-    "Predictive geometry tree construction order")
-
-  ("predGeomTreePtsMax",
-    params.encoder.predGeom.maxPtsPerTree, 1100000,
-    "Maximum number of points per predictive geometry tree")
-
-  (po::Section("Attributes"))
-
-  // attribute processing
-  //   NB: Attribute options are special in the way they are applied (see above)
-  ("attribute",
-    attribute_setter,
-    "Encode the given attribute (NB, must appear after the"
-    "following attribute parameters)")
-
-  ("bitdepth",
-    params_attr.desc.bitdepth, 8,
-    "Attribute bitdepth")
-
-  ("defaultValue",
-    params_attr.desc.attr_default_value, {},
-    "Default attribute component value(s) in case of data omission")
-
-  // todo(df): this should be per-attribute
-  ("colourMatrix",
-    params_attr.desc.cicp_matrix_coefficients_idx, ColourMatrix::kBt709,
-    "Matrix used in colourspace conversion\n"
-    "  0: none (identity)\n"
-    "  1: ITU-T BT.709\n"
-    "  8: YCgCo")
-
-  ("transformType",
-    params_attr.aps.attr_encoding, AttributeEncoding::kPredictingTransform,
-    "Coding method to use for attribute:\n"
-    "  0: Hierarchical neighbourhood prediction\n"
-    "  1: Region Adaptive Hierarchical Transform (RAHT)\n"
-    "  2: Hierarichical neighbourhood prediction as lifting transform")
-
-  ("rahtPredictionEnabled",
-    params_attr.aps.raht_prediction_enabled_flag, true,
-    "Controls the use of transform-domain prediction")
-
-  ("rahtPredictionThreshold0",
-    params_attr.aps.raht_prediction_threshold0, 2,
-    "Grandparent threshold for early transform-domain prediction termination")
-
-  ("rahtPredictionThreshold1",
-    params_attr.aps.raht_prediction_threshold1, 6,
-    "Parent threshold for early transform-domain prediction termination")
-
-  // NB: the cli option sets +1, the minus1 will be applied later
-  ("numberOfNearestNeighborsInPrediction",
-    params_attr.aps.num_pred_nearest_neighbours_minus1, 3,
-    "Attribute's maximum number of nearest neighbors to be used for prediction")
-
-  ("adaptivePredictionThreshold",
-    params_attr.aps.adaptive_prediction_threshold, -1,
-    "Neighbouring attribute value difference that enables choice of "
-    "single|multi predictors. Applies to transformType=2 only.\n"
-    "  -1: auto = 2**(bitdepth-2)")
-
-  ("attributeSearchRange",
-    params_attr.aps.search_range, 128,
-    "Range for nearest neighbor search")
-
-  // NB: the underlying variable is in STV order.
-  //     Conversion happens during argument sanitization.
-  ("lod_neigh_bias",
-    params_attr.aps.lodNeighBias, {1, 1, 1},
-    "Attribute's (x, y, z) component intra prediction weights")
-
-  ("lodDecimation",
-    params_attr.aps.lod_decimation_enabled_flag, false,
-    "Controls LoD generation method:\n"
-    " 0: distance based subsampling\n"
-    " 1: periodic subsampling using lodSamplingPeriod")
-
-  ("max_num_direct_predictors",
-    params_attr.aps.max_num_direct_predictors, 3,
-    "Maximum number of nearest neighbour candidates used in direct"
-    "attribute prediction")
-
-  ("levelOfDetailCount",
-    params_attr.aps.num_detail_levels, 1,
-    "Attribute's number of levels of detail")
-
-  ("dist2",
-    params_attr.aps.dist2, {},
-    "List of per LoD squared distances used in LoD generation.\n"
-    " 0 entries: derive base value automatically\n"
-    ">0 entries: derive subsequent values automatically")
-
-  ("lodSamplingPeriod",
-    params_attr.aps.lodSamplingPeriod, {4},
-    "List of per LoD sampling periods used in LoD generation.\n")
-
-  ("intraLodPredictionEnabled",
-    params_attr.aps.intra_lod_prediction_enabled_flag, false,
-    "Permits referring to points in same LoD")
-
-  ("interComponentPredictionEnabled",
-    params_attr.aps.inter_component_prediction_enabled_flag, false,
-    "Use primary attribute component to predict values of subsequent "
-    "components")
-
-  ("canonical_point_order_flag",
-    params_attr.aps.canonical_point_order_flag, false,
-    "Enable skipping morton sort in case of number of LoD equal to 1")
-
-  ("aps_scalable_enable_flag",
-    params_attr.aps.scalable_lifting_enabled_flag, false,
-    "Enable scalable attritube coding")
-
-  ("max_neigh_range",
-    params_attr.aps.max_neigh_range, 5,
-    "maximum nearest neighbour range for scalable lifting")
-
-  ("qp",
-    // NB: this is adjusted with minus 4 after the arguments are parsed
-    params_attr.aps.init_qp_minus4, 4,
-    "Attribute's luma quantisation parameter")
-
-  ("qpChromaOffset",
-    params_attr.aps.aps_chroma_qp_offset, 0,
-    "Attribute's chroma quantisation parameter offset (relative to luma)")
-
-  ("aps_slice_qp_deltas_present_flag",
-    params_attr.aps.aps_slice_qp_deltas_present_flag, false,
-    "Enable signalling of per-slice QP values")
-
-  ("qpLayerOffsetsLuma",
-    params_attr.encoder.abh.attr_layer_qp_delta_luma, {},
-      "Attribute's per layer luma QP offsets")
-
-  ("qpLayerOffsetsChroma",
-      params_attr.encoder.abh.attr_layer_qp_delta_chroma, {},
-      "Attribute's per layer chroma QP offsets")
-
-  // This section is just dedicated to attribute recolouring (encoder only).
-  // parameters are common to all attributes.
-  (po::Section("Recolouring"))
-
-  ("recolourSearchRange",
-    params.encoder.recolour.searchRange, 1,
-    "")
-
-  ("recolourNumNeighboursFwd",
-    params.encoder.recolour.numNeighboursFwd, 8,
-    "")
-
-  ("recolourNumNeighboursBwd",
-    params.encoder.recolour.numNeighboursBwd, 1,
-    "")
-
-  ("recolourUseDistWeightedAvgFwd",
-    params.encoder.recolour.useDistWeightedAvgFwd, true,
-    "")
-
-  ("recolourUseDistWeightedAvgBwd",
-    params.encoder.recolour.useDistWeightedAvgBwd, true,
-    "")
-
-  ("recolourSkipAvgIfIdenticalSourcePointPresentFwd",
-    params.encoder.recolour.skipAvgIfIdenticalSourcePointPresentFwd, true,
-    "")
-
-  ("recolourSkipAvgIfIdenticalSourcePointPresentBwd",
-    params.encoder.recolour.skipAvgIfIdenticalSourcePointPresentBwd, false,
-    "")
-
-  ("recolourDistOffsetFwd",
-    params.encoder.recolour.distOffsetFwd, 4.,
-    "")
-
-  ("recolourDistOffsetBwd",
-    params.encoder.recolour.distOffsetBwd, 4.,
-    "")
-
-  ("recolourMaxGeometryDist2Fwd",
-    params.encoder.recolour.maxGeometryDist2Fwd, 1000.,
-    "")
-
-  ("recolourMaxGeometryDist2Bwd",
-    params.encoder.recolour.maxGeometryDist2Bwd, 1000.,
-    "")
-
-  ("recolourMaxAttributeDist2Fwd",
-    params.encoder.recolour.maxAttributeDist2Fwd, 1000.,
-    "")
-
-  ("recolourMaxAttributeDist2Bwd",
-    params.encoder.recolour.maxAttributeDist2Bwd, 1000.,
-    "")
-
   ;
   /* clang-format on */
 
+  // The codec options are common to the library interface
+  addCodecOptions(opts, &params.codec);
+  addDecoderOptions(opts, &params.decoder);
+  addEncoderOptions(opts, &params.encoder);
+
   po::setDefaults(opts);
   po::ErrorReporter err;
   const list<const char*>& argv_unhandled =
@@ -921,308 +347,14 @@ ParseParameters(int argc, char* argv[], Parameters& params)
     return false;
   }
 
-  // fix the representation of various options
-  params.encoder.gbh.geom_stream_cnt_minus1--;
-  for (auto& attr_aps : params.encoder.aps) {
-    attr_aps.init_qp_minus4 -= 4;
-    attr_aps.num_pred_nearest_neighbours_minus1--;
-  }
+  applyCodecOptions(params.codec, &params.encoder);
+  applyCodecOptions(params.codec, &params.decoder);
+  sanitiseEncoderOptions(&params.encoder, err);
 
   // set default output resolution (this works for the decoder too)
   if (params.outputResolution < 0)
     params.outputResolution = params.encoder.srcResolution;
 
-  // convert coordinate systems if the coding order is different from xyz
-  convertXyzToStv(&params.encoder.sps);
-  convertXyzToStv(params.encoder.sps, &params.encoder.gps);
-  for (auto& aps : params.encoder.aps)
-    convertXyzToStv(params.encoder.sps, &aps);
-
-  // Certain coding modes are not available when trisoup is enabled.
-  // Disable them, and warn if set (they may be set as defaults).
-  if (params.encoder.gps.trisoup_node_size_log2 > 0) {
-    if (!params.encoder.gps.geom_unique_points_flag)
-      err.warn() << "TriSoup geometry does not preserve duplicated points\n";
-
-    if (params.encoder.gps.inferred_direct_coding_mode_enabled_flag)
-      err.warn() << "TriSoup geometry is incompatable with IDCM\n";
-
-    params.encoder.gps.geom_unique_points_flag = true;
-    params.encoder.gps.inferred_direct_coding_mode_enabled_flag = false;
-  }
-
-  // tweak qtbt generation when trisoup is /isn't enabled
-  params.encoder.geom.qtbt.trisoupNodeSizeLog2 =
-    params.encoder.gps.trisoup_node_size_log2;
-
-  // Planar coding mode is not available for bytewise coding
-  if (!params.encoder.gps.bitwise_occupancy_coding_flag) {
-    if (params.encoder.gps.geom_planar_mode_enabled_flag)
-      err.warn() << "Bytewise geometry coding does not support planar mode\n";
-    params.encoder.gps.geom_planar_mode_enabled_flag = false;
-  }
-
-  // support disabling attribute coding (simplifies configuration)
-  if (params.disableAttributeCoding) {
-    params.encoder.attributeIdxMap.clear();
-    params.encoder.sps.attributeSets.clear();
-    params.encoder.aps.clear();
-  }
-
-  // fixup any per-attribute settings
-  for (const auto& it : params.encoder.attributeIdxMap) {
-    auto& attr_sps = params.encoder.sps.attributeSets[it.second];
-    auto& attr_aps = params.encoder.aps[it.second];
-    auto& attr_enc = params.encoder.attr[it.second];
-
-    // default values for attribute
-    attr_sps.attr_instance_id = 0;
-    attr_sps.cicp_colour_primaries_idx = 2;
-    attr_sps.cicp_transfer_characteristics_idx = 2;
-    attr_sps.cicp_video_full_range_flag = true;
-    attr_sps.cicpParametersPresent = false;
-    attr_sps.source_attr_offset_log2 = 0;
-    attr_sps.source_attr_scale_log2 = 0;
-    attr_sps.scalingParametersPresent = false;
-
-    if (it.first == "reflectance") {
-      // Avoid wasting bits signalling chroma quant step size for reflectance
-      attr_aps.aps_chroma_qp_offset = 0;
-      attr_enc.abh.attr_layer_qp_delta_chroma.clear();
-
-      // There is no matrix for reflectace
-      attr_sps.cicp_matrix_coefficients_idx = ColourMatrix::kUnspecified;
-      attr_sps.attr_num_dimensions_minus1 = 0;
-      attr_sps.attributeLabel = KnownAttributeLabel::kReflectance;
-    }
-
-    if (it.first == "color") {
-      attr_sps.attr_num_dimensions_minus1 = 2;
-      attr_sps.attributeLabel = KnownAttributeLabel::kColour;
-      attr_sps.cicpParametersPresent = true;
-    }
-
-    // Derive the secondary bitdepth
-    // todo(df): this needs to be a command line argument
-    //  -- but there are a few edge cases to handle
-    attr_sps.bitdepthSecondary = attr_sps.bitdepth;
-
-    // Assume that YCgCo is actually YCgCoR for now
-    if (attr_sps.cicp_matrix_coefficients_idx == ColourMatrix::kYCgCo)
-      attr_sps.bitdepthSecondary++;
-
-    // Extend the default attribute value to the correct width if present
-    if (!attr_sps.attr_default_value.empty())
-      attr_sps.attr_default_value.resize(
-        attr_sps.attr_num_dimensions_minus1 + 1,
-        attr_sps.attr_default_value.back());
-
-    // derive the dist2 values based on an initial value
-    if (attr_aps.lodParametersPresent()) {
-      if (attr_aps.dist2.size() > attr_aps.num_detail_levels) {
-        attr_aps.dist2.resize(attr_aps.num_detail_levels);
-      } else if (
-        attr_aps.dist2.size() < attr_aps.num_detail_levels
-        && !attr_aps.dist2.empty()) {
-        if (attr_aps.dist2.size() < attr_aps.num_detail_levels) {
-          attr_aps.dist2.resize(attr_aps.num_detail_levels);
-          const double distRatio = 4.0;
-          uint64_t d2 = attr_aps.dist2[0];
-          for (int i = 0; i < attr_aps.num_detail_levels; ++i) {
-            attr_aps.dist2[i] = d2;
-            d2 = uint64_t(std::round(distRatio * d2));
-          }
-        }
-      }
-    }
-    // In order to simplify specification of dist2 values, which are
-    // depending on the scale of the coded point cloud, the following
-    // adjust the dist2 values according to PQS.  The user need only
-    // specify the unquantised PQS value.
-    if (params.positionQuantizationScaleAdjustsDist2) {
-      double pqs = params.encoder.geomPreScale;
-      double pqs2 = pqs * pqs;
-      for (auto& dist2 : attr_aps.dist2)
-        dist2 = int64_t(std::round(pqs2 * dist2));
-    }
-
-    // derive samplingPeriod values based on initial value
-    if (
-      !attr_aps.lodParametersPresent()
-      || !attr_aps.lod_decimation_enabled_flag) {
-      attr_aps.lodSamplingPeriod.clear();
-    } else if (!attr_aps.lodSamplingPeriod.empty()) {
-      auto i = attr_aps.lodSamplingPeriod.size();
-      attr_aps.lodSamplingPeriod.resize(attr_aps.num_detail_levels);
-      // add any extra values as required
-      for (; i < attr_aps.num_detail_levels; i++)
-        attr_aps.lodSamplingPeriod[i] = attr_aps.lodSamplingPeriod[i - 1];
-    }
-
-    // Set default threshold based on bitdepth
-    if (attr_aps.adaptive_prediction_threshold == -1) {
-      attr_aps.adaptive_prediction_threshold = 1 << (attr_sps.bitdepth - 2);
-    }
-
-    if (attr_aps.attr_encoding == AttributeEncoding::kLiftingTransform) {
-      attr_aps.adaptive_prediction_threshold = 0;
-      attr_aps.intra_lod_prediction_enabled_flag = false;
-    }
-
-    // For RAHT, ensure that the unused lod count = 0 (prevents mishaps)
-    if (attr_aps.attr_encoding == AttributeEncoding::kRAHTransform) {
-      attr_aps.num_detail_levels = 0;
-      attr_aps.adaptive_prediction_threshold = 0;
-    }
-  }
-
-  // convert floating point values of Lasers' Theta and H to fixed point
-  if (params.encoder.gps.geom_angular_mode_enabled_flag) {
-    for (auto val : params.encoder.lasersTheta) {
-      int one = 1 << 18;
-      params.encoder.gps.geom_angular_theta_laser.push_back(round(val * one));
-    }
-
-    for (auto val : params.encoder.lasersZ) {
-      int one = 1 << 3;
-      params.encoder.gps.geom_angular_z_laser.push_back(
-        round(val * params.encoder.geomPreScale * one));
-    }
-
-    if (
-      params.encoder.gps.geom_angular_theta_laser.size()
-      != params.encoder.numLasers)
-      err.error() << "lasersZ.size() != numLasers\n";
-
-    if (
-      params.encoder.gps.geom_angular_z_laser.size()
-      != params.encoder.numLasers)
-      err.error() << "lasersTheta.size() != numLasers\n";
-
-    if (
-      params.encoder.gps.geom_angular_num_phi_per_turn.size()
-      != params.encoder.numLasers)
-      err.error() << "lasersNumPhiPerTurn.size() != numLasers\n";
-
-    if (params.encoder.gps.qtbt_enabled_flag) {
-      params.encoder.geom.qtbt.angularMaxNodeMinDimLog2ToSplitV =
-        std::max<int>(0, 8 + log2(params.encoder.geomPreScale));
-      params.encoder.geom.qtbt.angularMaxDiffToSplitZ =
-        std::max<int>(0, 1 + log2(params.encoder.geomPreScale));
-    }
-  }
-
-  // tweak qtbt when angular is / isn't enabled
-  params.encoder.geom.qtbt.angularTweakEnabled =
-    params.encoder.gps.geom_angular_mode_enabled_flag;
-
-  // sanity checks
-
-  if (
-    params.encoder.gps.planar_buffer_disabled_flag
-    && !params.encoder.gps.geom_angular_mode_enabled_flag)
-    err.error() << "planar buffer can only be disabled with angular mode\n";
-
-  if (
-    params.encoder.partition.sliceMaxPoints
-    < params.encoder.partition.sliceMinPoints)
-    err.error()
-      << "sliceMaxPoints must be greater than or equal to sliceMinPoints\n";
-
-  if (params.encoder.gps.intra_pred_max_node_size_log2)
-    if (!params.encoder.gps.neighbour_avail_boundary_log2)
-      err.error() << "Geometry intra prediction requires finite"
-                     "neighbour_avail_boundary_log2\n";
-
-  for (const auto& it : params.encoder.attributeIdxMap) {
-    const auto& attr_sps = params.encoder.sps.attributeSets[it.second];
-    const auto& attr_aps = params.encoder.aps[it.second];
-    auto& attr_enc = params.encoder.attr[it.second];
-
-    if (it.first == "color") {
-      if (
-        attr_enc.abh.attr_layer_qp_delta_luma.size()
-        != attr_enc.abh.attr_layer_qp_delta_chroma.size()) {
-        err.error() << it.first
-                    << ".qpLayerOffsetsLuma length != .qpLayerOffsetsChroma\n";
-      }
-    }
-
-    if (attr_sps.bitdepth > 16)
-      err.error() << it.first << ".bitdepth must be less than 17\n";
-
-    if (attr_sps.bitdepthSecondary > 16)
-      err.error() << it.first << ".bitdepth_secondary must be less than 17\n";
-
-    if (attr_aps.lodParametersPresent()) {
-      int lod = attr_aps.num_detail_levels;
-      if (lod > 255 || lod < 0) {
-        err.error() << it.first
-                    << ".levelOfDetailCount must be in the range [0,255]\n";
-      }
-
-      // if empty, values are derived automatically
-      if (!attr_aps.dist2.empty() && attr_aps.dist2.size() != lod) {
-        err.error() << it.first << ".dist2 does not have " << lod
-                    << " entries\n";
-      }
-
-      if (lod > 0 && attr_aps.canonical_point_order_flag) {
-        err.error() << it.first
-                    << "when levelOfDetailCount > 0, "
-                       "canonicalPointOrder must be 0\n";
-      }
-
-      if (
-        attr_aps.lod_decimation_enabled_flag
-        && attr_aps.lodSamplingPeriod.empty()) {
-        err.error() << it.first
-                    << ".lodSamplingPeriod must contain at least one entry\n";
-      }
-
-      for (auto samplingPeriod : attr_aps.lodSamplingPeriod) {
-        if (samplingPeriod < 2)
-          err.error() << it.first << ".lodSamplingPeriod values must be > 1\n";
-      }
-
-      if (attr_aps.adaptive_prediction_threshold < 0) {
-        err.error() << it.first
-                    << ".adaptivePredictionThreshold must be positive\n";
-      }
-
-      if (
-        attr_aps.num_pred_nearest_neighbours_minus1
-        >= kAttributePredictionMaxNeighbourCount) {
-        err.error() << it.first
-                    << ".numberOfNearestNeighborsInPrediction must be <= "
-                    << kAttributePredictionMaxNeighbourCount << "\n";
-      }
-      if (attr_aps.scalable_lifting_enabled_flag) {
-        if (attr_aps.attr_encoding != AttributeEncoding::kLiftingTransform) {
-          err.error() << it.first << "AttributeEncoding must be "
-                      << (int)AttributeEncoding::kLiftingTransform << "\n";
-        }
-
-        if (attr_aps.lod_decimation_enabled_flag) {
-          err.error() << it.first
-                      << ".lod_decimation_enabled_flag must be = 0 \n";
-        }
-
-        if (params.encoder.gps.trisoup_node_size_log2 > 0) {
-          err.error() << it.first
-                      << "trisoup_node_size_log2 must be disabled \n";
-        }
-      }
-    }
-
-    if (attr_aps.init_qp_minus4 < 0 || attr_aps.init_qp_minus4 + 4 > 51)
-      err.error() << it.first << ".qp must be in the range [4,51]\n";
-
-    if (std::abs(attr_aps.aps_chroma_qp_offset) > 51 - 4) {
-      err.error() << it.first
-                  << ".qpChromaOffset must be in the range [-47,47]\n";
-    }
-  }
 
   // check required arguments are specified
 
@@ -1235,6 +367,15 @@ ParseParameters(int argc, char* argv[], Parameters& params)
   if (params.compressedStreamPath.empty())
     err.error() << "compressedStreamPath not set\n";
 
+  if (isStdio(params.compressedStreamPath) && !params.isDecoder)
+    if (isStdio(params.reconstructedDataPath))
+      err.error() << "compressedStreamPath and reconstructedDataPath "
+                     "cannot both use stdout\n";
+
+  if (!params.isDecoder && params.frameCount <= 0)
+    if (!isStdio(params.uncompressedDataPath))
+      err.error() << "frameCount must be positive unless reading stdin\n";
+
   // report the current configuration (only in the absence of errors so
   // that errors/warnings are more obvious and in the same place).
   if (err.is_errored)
@@ -1247,18 +388,7 @@ ParseParameters(int argc, char* argv[], Parameters& params)
   if (params.isDecoder) {
     po::dumpCfg(cout, opts, "Decoder", 4);
   } else {
-    po::dumpCfg(cout, opts, "Encoder", 4);
-    po::dumpCfg(cout, opts, "Geometry", 4);
-    po::dumpCfg(cout, opts, "Recolouring", 4);
-
-    for (const auto& it : params.encoder.attributeIdxMap) {
-      // NB: when dumping the config, opts references params_attr
-      params_attr.desc = params.encoder.sps.attributeSets[it.second];
-      params_attr.aps = params.encoder.aps[it.second];
-      params_attr.encoder = params.encoder.attr[it.second];
-      cout << "    " << it.first << "\n";
-      po::dumpCfg(cout, opts, "Attributes", 8);
-    }
+    dumpEncoderOptions(cout, opts, &params.encoder);
   }
 
   cout << endl;
@@ -1299,19 +429,41 @@ SequenceEncoder::outputScale(const SequenceParameterSet& sps)
 int
 SequenceEncoder::compress(Stopwatch* clock)
 {
-  bytestreamFile.open(params->compressedStreamPath, ios::binary);
-  if (!bytestreamFile.is_open()) {
-    return -1;
+  if (isStdio(params->compressedStreamPath)) {
+    bytestreamWriter.reset(new AsyncTlvWriter(stdoutDataStream()));
+  } else {
+    bytestreamFile.open(params->compressedStreamPath, ios::binary);
+    if (!bytestreamFile.is_open()) {
+      return -1;
+    }
+    bytestreamWriter.reset(new AsyncTlvWriter(bytestreamFile));
   }
 
+  // When streaming from stdin, the sequence may be terminated by the input
+  bool streamInput = isStdio(params->uncompressedDataPath);
+  bool untilEndOfInput = streamInput && params->frameCount <= 0;
+
   const int lastFrameNum = params->firstFrameNum + params->frameCount;
-  for (frameNum = params->firstFrameNum; frameNum < lastFrameNum; frameNum++) {
+  for (frameNum = params->firstFrameNum;
+       untilEndOfInput || frameNum < lastFrameNum; frameNum++) {
+    if (streamInput && std::cin.peek() == std::char_traits<char>::eof())
+      break;
+
     if (compressOneFrame(clock))
       return -1;
   }
 
-  std::cout << "Total bitstream size " << bytestreamFile.tellp() << " B\n";
-  bytestreamFile.close();
+  bool writeOk = bytestreamWriter->flush();
+  std::cout << "Total bitstream size " << bytestreamWriter->length()
+            << " B\n";
+  bytestreamWriter.reset();
+  if (bytestreamFile.is_open())
+    bytestreamFile.close();
+
+  if (!writeOk) {
+    cout << "Error: can't write bitstream!" << endl;
+    return -1;
+  }
 
   return 0;
 }
@@ -1321,18 +473,30 @@ SequenceEncoder::compress(Stopwatch* clock)
 int
 SequenceEncoder::compressOneFrame(Stopwatch* clock)
 {
-  std::string srcName{expandNum(params->uncompressedDataPath, frameNum)};
   PCCPointSet3 pointCloud;
-  if (
-    !ply::read(srcName, _plyAttrNames, pointCloud)
-    || pointCloud.getPointCount() == 0) {
-    cout << "Error: can't open input file!" << endl;
-    return -1;
+  if (isStdio(params->uncompressedDataPath)) {
+    if (
+      !readPointFrame(std::cin, _plyAttrNames, &pointCloud)
+      || pointCloud.getPointCount() == 0) {
+      if (std::cin.eof())
+        cout << "Error: can't read point frame from stdin!" << endl;
+      else
+        cout << "Error: invalid point frame on stdin!" << endl;
+      return -1;
+    }
+  } else {
+    std::string srcName{expandNum(params->uncompressedDataPath, frameNum)};
+    if (
+      !ply::read(srcName, _plyAttrNames, pointCloud)
+      || pointCloud.getPointCount() == 0) {
+      cout << "Error: can't open input file!" << endl;
+      return -1;
+    }
   }
 
   // Some evaluations wish to scan the points in azimuth order to simulate
   // real-time acquisition (since the input has lost its original order).
-  if (params->sortInputByAzimuth)
+  if (params->encoder.sortInputByAzimuth)
     sortByAzimuth(pointCloud, 0, pointCloud.getPointCount(), _angularOrigin);
 
   // Sanitise the input point cloud
@@ -1366,7 +530,7 @@ SequenceEncoder::compressOneFrame(Stopwatch* clock)
     reconPointCloud.reset(new PCCPointSet3);
   }
 
-  auto bytestreamLenFrameStart = bytestreamFile.tellp();
+  auto bytestreamLenFrameStart = bytestreamWriter->length();
 
   int ret = encoder.compress(
     pointCloud, &params->encoder, this, reconPointCloud.get());
@@ -1375,11 +539,18 @@ SequenceEncoder::compressOneFrame(Stopwatch* clock)
     return -1;
   }
 
-  auto bytestreamLenFrameEnd = bytestreamFile.tellp();
+  auto bytestreamLenFrameEnd = bytestreamWriter->length();
   int frameLen = bytestreamLenFrameEnd - bytestreamLenFrameStart;
 
   std::cout << "Total frame size " << frameLen << " B" << std::endl;
 
+  // a downstream consumer may be waiting for the complete frame
+  if (isStdio(params->compressedStreamPath))
+    if (!bytestreamWriter->flush()) {
+      cout << "Error: can't write bitstream!" << endl;
+      return -1;
+    }
+
   clock->stop();
 
   if (!params->reconstructedDataPath.empty()) {
@@ -1395,12 +566,20 @@ SequenceEncoder::compressOneFrame(Stopwatch* clock)
       }
     }
 
-    std::string recName{expandNum(params->reconstructedDataPath, frameNum)};
     auto plyScale = outputScale(params->encoder.sps);
     auto plyOrigin = params->encoder.sps.seqBoundingBoxOrigin * plyScale;
-    ply::write(
-      *reconPointCloud, _plyAttrNames, plyScale, plyOrigin, recName,
-      !params->outputBinaryPly);
+
+    if (isStdio(params->reconstructedDataPath)) {
+      auto& os = stdoutDataStream();
+      writePointFrame(
+        *reconPointCloud, _plyAttrNames, plyScale, plyOrigin, os);
+      os.flush();
+    } else {
+      std::string recName{expandNum(params->reconstructedDataPath, frameNum)};
+      ply::write(
+        *reconPointCloud, _plyAttrNames, plyScale, plyOrigin, recName,
+        !params->outputBinaryPly);
+    }
   }
 
   return 0;
@@ -1409,9 +588,9 @@ SequenceEncoder::compressOneFrame(Stopwatch* clock)
 //----------------------------------------------------------------------------
 
 void
-SequenceEncoder::onOutputBuffer(const PayloadBuffer& buf)
+SequenceEncoder::onOutputBuffer(PayloadBuffer&& buf)
 {
-  writeTlv(buf, bytestreamFile);
+  bytestreamWriter->write(std::move(buf));
 }
 
 //----------------------------------------------------------------------------
@@ -1469,11 +648,18 @@ SequenceDecoder::outputScale(const SequenceParameterSet& sps)
 int
 SequenceDecoder::decompress(Stopwatch* clock)
 {
-  ifstream fin(params->compressedStreamPath, ios::binary);
-  if (!fin.is_open()) {
-    return -1;
+  ifstream finFile;
+  if (!isStdio(params->compressedStreamPath)) {
+    finFile.open(params->compressedStreamPath, ios::binary);
+    if (!finFile.is_open()) {
+      return -1;
+    }
   }
 
+  std::istream& fin =
+    isStdio(params->compressedStreamPath) ? std::cin : finFile;
+  size_t bytestreamLen = 0;
+
   frameNum = params->firstFrameNum;
   this->clock = clock;
 
@@ -1488,6 +674,8 @@ SequenceDecoder::decompress(Stopwatch* clock)
     // at end of file (or other error), flush decoder
     if (!fin)
       buf_ptr = nullptr;
+    else
+      bytestreamLen += buf.size() + 5;
 
     if (decoder.decompress(buf_ptr, this)) {
       cout << "Error: can't decompress point cloud!" << endl;
@@ -1498,9 +686,7 @@ SequenceDecoder::decompress(Stopwatch* clock)
       break;
   }
 
-  fin.clear();
-  fin.seekg(0, ios_base::end);
-  std::cout << "Total bitstream size " << fin.tellg() << " B" << std::endl;
+  std::cout << "Total bitstream size " << bytestreamLen << " B" << std::endl;
 
   clock->stop();
 
@@ -1511,11 +697,9 @@ SequenceDecoder::decompress(Stopwatch* clock)
 
 void
 SequenceDecoder::onOutputCloud(
-  const SequenceParameterSet& sps, const PCCPointSet3& decodedPointCloud)
+  const SequenceParameterSet& sps, PCCPointSet3& pointCloud)
 {
-  // copy the point cloud in order to modify it according to the output options
-  PCCPointSet3 pointCloud(decodedPointCloud);
-
+  // NB: the point cloud is modified in place according to the output options
   if (params->convertColourspace)
     convertToGbr(sps, pointCloud);
 
@@ -1543,11 +727,18 @@ SequenceDecoder::onOutputCloud(
 
   auto plyScale = outputScale(sps);
   auto plyOrigin = sps.seqBoundingBoxOrigin * plyScale;
-  std::string decName{expandNum(params->reconstructedDataPath, frameNum)};
-  if (!ply::write(
-        pointCloud, attrNames, plyScale, plyOrigin, decName,
-        !params->outputBinaryPly)) {
-    cout << "Error: can't open output file!" << endl;
+  if (isStdio(params->reconstructedDataPath)) {
+    auto& os = stdoutDataStream();
+    writePointFrame(pointCloud, attrNames, plyScale, plyOrigin, os);
+    if (!os.flush())
+      cout << "Error: can't write to stdout!" << endl;
+  } else {
+    std::string decName{expandNum(params->reconstructedDataPath, frameNum)};
+    if (!ply::write(
+          pointCloud, attrNames, plyScale, plyOrigin, decName,
+          !params->outputBinaryPly)) {
+      cout << "Error: can't open output file!" << endl;
+    }
   }
 
   clock->start();
@@ -1557,58 +748,3 @@ SequenceDecoder::onOutputCloud(
 }
 
 //============================================================================
-
-const AttributeDescription*
-findColourAttrDesc(const SequenceParameterSet& sps)
-{
-  // todo(df): don't assume that there is only one colour attribute in the sps
-  for (const auto& desc : sps.attributeSets) {
-    if (desc.attributeLabel == KnownAttributeLabel::kColour)
-      return &desc;
-  }
-  return nullptr;
-}
-
-//----------------------------------------------------------------------------
-
-void
-convertToGbr(const SequenceParameterSet& sps, PCCPointSet3& cloud)
-{
-  const AttributeDescription* attrDesc = findColourAttrDesc(sps);
-  if (!attrDesc)
-    return;
-
-  switch (attrDesc->cicp_matrix_coefficients_idx) {
-  case ColourMatrix::kBt709: convertYCbCrBt709ToGbr(cloud); break;
-
-  case ColourMatrix::kYCgCo:
-    // todo(df): select YCgCoR vs YCgCo
-    convertYCgCoRToGbr(attrDesc->bitdepth, cloud);
-    break;
-
-  default: break;
-  }
-}
-
-//----------------------------------------------------------------------------
-
-void
-convertFromGbr(const SequenceParameterSet& sps, PCCPointSet3& cloud)
-{
-  const AttributeDescription* attrDesc = findColourAttrDesc(sps);
-  if (!attrDesc)
-    return;
-
-  switch (attrDesc->cicp_matrix_coefficients_idx) {
-  case ColourMatrix::kBt709: convertGbrToYCbCrBt709(cloud); break;
-
-  case ColourMatrix::kYCgCo:
-    // todo(df): select YCgCoR vs YCgCo
-    convertGbrToYCgCoR(attrDesc->bitdepth, cloud);
-    break;
-
-  default: break;
-  }
-}
-
-//============================================================================
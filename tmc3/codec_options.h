@@ -0,0 +1,122 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <ostream>
+
+#include "PCCTMC3Decoder.h"
+#include "PCCTMC3Encoder.h"
+#include "program_options_lite.h"
+
+namespace pcc {
+
+//============================================================================
+// Codec configuration options, shared by the tmc3 application and the
+// library interface.
+
+struct EncoderOptions : EncoderParams {
+  // command line parsing should adjust dist2 values according to PQS
+  bool positionQuantizationScaleAdjustsDist2;
+
+  // when true, configure the encoder as if no attributes are specified
+  bool disableAttributeCoding;
+
+  // resort the input points by azimuth angle
+  bool sortInputByAzimuth;
+
+  // Parameters for the next attribute, staged until the attribute option.
+  // NB: not to be confused with EncoderParams::attr.
+  struct {
+    AttributeDescription desc;
+    AttributeParameterSet aps;
+    EncoderAttributeParams encoder;
+  } stagedAttr;
+};
+
+//----------------------------------------------------------------------------
+// Options common to the encoder and decoder.  They are registered once and
+// then applied to the parameters of either.
+
+struct CodecOptions {
+  // Maximum number of threads used by parallelised coding stages
+  int numThreads;
+
+  // Retain attribute LoDs between slices and reuse them when the geometry
+  // of a slice is unchanged
+  bool attrLodCacheEnabled;
+};
+
+//============================================================================
+
+// Adds the encoder option sections (Encoder, Geometry, Attributes and
+// Recolouring) to opts.
+//
+// NB: opts refers to *params, which must outlive it.
+void addEncoderOptions(
+  df::program_options_lite::Options& opts, EncoderOptions* params);
+
+// Adds the Decoder option section to opts.
+//
+// NB: opts refers to *params, which must outlive it.
+void addDecoderOptions(
+  df::program_options_lite::Options& opts, DecoderParams* params);
+
+// Adds the Codec option section (options common to the encoder and
+// decoder) to opts.
+//
+// NB: opts refers to *params, which must outlive it.
+void addCodecOptions(
+  df::program_options_lite::Options& opts, CodecOptions* params);
+
+// Applies the common options to the encoder or decoder parameters.  This
+// must precede sanitiseEncoderOptions().
+void applyCodecOptions(const CodecOptions& opts, EncoderParams* params);
+void applyCodecOptions(const CodecOptions& opts, DecoderParams* params);
+
+// Derives the encoder configuration from the parsed option values.
+// This must be called exactly once, after all options have been parsed.
+void sanitiseEncoderOptions(
+  EncoderOptions* params, df::program_options_lite::ErrorReporter& err);
+
+// Writes the effective encoder configuration to os.
+void dumpEncoderOptions(
+  std::ostream& os,
+  const df::program_options_lite::Options& opts,
+  EncoderOptions* params);
+
+//============================================================================
+
+}  // namespace pcc
@@ -0,0 +1,107 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cpu_features.h"
+
+#include "TMC3Config.h"
+
+#if HAVE_X86_SIMD && defined(_MSC_VER)
+#  include <immintrin.h>
+#  include <intrin.h>
+#endif
+
+namespace pcc {
+
+//============================================================================
+
+#if HAVE_X86_SIMD && defined(_MSC_VER)
+static SimdLevel
+detectSimdLevel()
+{
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+
+  __cpuid(info, 1);
+  const bool sse41 = info[2] & (1 << 19);
+  const bool osxsave = info[2] & (1 << 27);
+  const bool avx = info[2] & (1 << 28);
+
+  // NB: AVX2 also requires the OS to preserve the ymm registers
+  bool avx2 = false;
+  if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+    __cpuidex(info, 7, 0);
+    avx2 = info[1] & (1 << 5);
+  }
+
+  if (avx2)
+    return SimdLevel::kAvx2;
+  if (sse41)
+    return SimdLevel::kSse41;
+  return SimdLevel::kNone;
+}
+
+#elif HAVE_X86_SIMD
+static SimdLevel
+detectSimdLevel()
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return SimdLevel::kAvx2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return SimdLevel::kSse41;
+  return SimdLevel::kNone;
+}
+
+#else
+static SimdLevel
+detectSimdLevel()
+{
+  return SimdLevel::kNone;
+}
+#endif
+
+//----------------------------------------------------------------------------
+
+SimdLevel
+hostSimdLevel()
+{
+  static const SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+//============================================================================
+
+}  // namespace pcc
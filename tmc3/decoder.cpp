@@ -37,6 +37,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 
 #include "PayloadBuffer.h"
@@ -56,6 +59,8 @@ void
 PCCTMC3Decoder3::init()
 {
   _currentFrameIdx = -1;
+  _prevSliceId = -1;
+  _skipSlice = false;
   _sps = nullptr;
   _gps = nullptr;
   _spss.clear();
@@ -80,14 +85,8 @@ PCCTMC3Decoder3::decompress(
 {
   // Starting a new geometry brick/slice/tile, transfer any
   // finished points to the output accumulator
-  if (!buf || payloadStartsNewSlice(buf->type)) {
-    if (size_t numPoints = _currentPointCloud.getPointCount()) {
-      for (size_t i = 0; i < numPoints; i++)
-        for (int k = 0; k < 3; k++)
-          _currentPointCloud[i][k] += _sliceOrigin[k];
-      _accumCloud.append(_currentPointCloud);
-    }
-  }
+  if (!buf || payloadStartsNewSlice(buf->type))
+    accumulateSlice();
 
   if (!buf) {
     // flush decoder, output pending cloud if any
@@ -134,25 +133,59 @@ PCCTMC3Decoder3::decompress(
     callback->onOutputCloud(*_sps, _accumCloud);
     _accumCloud.clear();
     _currentFrameIdx = -1;
-    _attrDecoder.reset();
+    if (!_params.attrLodCacheEnabled)
+      _attrDecoders.clear();
     return 0;
 
-  case PayloadType::kGeometryBrick:
+  case PayloadType::kGeometryBrick: {
     activateParameterSets(parseGbhIds(*buf));
-    if (frameIdxChanged(parseGbh(*_sps, *_gps, *buf, nullptr))) {
+    auto gbh = parseGbh(*_sps, *_gps, *buf, nullptr);
+    if (frameIdxChanged(gbh)) {
       callback->onOutputCloud(*_sps, _accumCloud);
       _accumCloud.clear();
     }
 
-    // avoid accidents with stale attribute decoder on next slice
-    _attrDecoder.reset();
+    // avoid accidents with stale attribute decoder on next slice.
+    // NB: a retained decoder only reuses its LoDs if the geometry of the
+    //     next slice is identical to that used to generate them
+    if (!_params.attrLodCacheEnabled)
+      _attrDecoders.clear();
+    _attrDecoders.beginSlice();
+
+    // slices outside the region of interest are discarded (along with
+    // their attributes) without being decoded.
+    // NB: when entropy continuation is enabled, the geometry of every slice
+    //     must be decoded to maintain the context state.  The points of
+    //     such slices are then discarded by the region of interest.
+    _skipSlice = !sliceIntersectsRoi(gbh);
+    if (_skipSlice && !_sps->entropy_continuation_enabled_flag) {
+      _currentFrameIdx = gbh.frame_idx;
+      return 0;
+    }
+
     return decodeGeometryBrick(*buf);
+  }
 
-  case PayloadType::kAttributeBrick: decodeAttributeBrick(*buf); return 0;
+  case PayloadType::kAttributeBrick: {
+    // NB: skipped attributes are discarded without being decoded
+    auto abh = parseAbhIds(*buf);
+    assert(abh.attr_sps_attr_idx < _sps->attributeSets.size());
+    if (_skipSlice)
+      return 0;
+    if (!isAttributeSkipped(_sps->attributeSets[abh.attr_sps_attr_idx]))
+      decodeAttributeBrick(*buf);
+    return 0;
+  }
 
-  case PayloadType::kConstantAttribute:
-    decodeConstantAttribute(*buf);
+  case PayloadType::kConstantAttribute: {
+    auto cadu = parseConstantAttribute(*_sps, *buf);
+    assert(cadu.constattr_sps_attr_idx < _sps->attributeSets.size());
+    if (_skipSlice)
+      return 0;
+    if (!isAttributeSkipped(_sps->attributeSets[cadu.constattr_sps_attr_idx]))
+      decodeConstantAttribute(*buf);
     return 0;
+  }
 
   case PayloadType::kTileInventory:
     // NB: the tile inventory is decoded in xyz order.  It may need
@@ -165,6 +198,52 @@ PCCTMC3Decoder3::decompress(
   return 1;
 }
 
+//--------------------------------------------------------------------------
+// Transfer the points of the current slice to their range of the output
+// frame, translating them by the slice origin.  Any points outside the
+// region of interest are discarded.
+//
+// NB: the slice origin cannot be applied earlier since attribute decoding
+//     operates on slice relative positions.
+
+void
+PCCTMC3Decoder3::accumulateSlice()
+{
+  size_t numSlicePoints = _currentPointCloud.getPointCount();
+  if (!numSlicePoints)
+    return;
+
+  const auto& src = _currentPointCloud;
+  auto& dst = _accumCloud;
+
+  // The frame and slice buffers retain their storage between frames, so
+  // they are only reallocated when a frame is larger than any before it.
+  size_t frameStart = dst.getPointCount();
+  if (!frameStart)
+    dst.addRemoveAttributes(src.hasColors(), src.hasReflectances());
+  dst.resize(frameStart + numSlicePoints);
+
+  bool copyColors = dst.hasColors() && src.hasColors();
+  bool copyReflectances = dst.hasReflectances() && src.hasReflectances();
+  bool roi = roiEnabled();
+
+  size_t dstIdx = frameStart;
+  for (size_t i = 0; i < numSlicePoints; i++) {
+    if (roi && !_sliceRoi.contains(src[i]))
+      continue;
+
+    dst[dstIdx] = src[i] + _sliceOrigin;
+    if (copyColors)
+      dst.setColor(dstIdx, src.getColor(i));
+    if (copyReflectances)
+      dst.setReflectance(dstIdx, src.getReflectance(i));
+    dstIdx++;
+  }
+
+  dst.resize(dstIdx);
+  _currentPointCloud.clear();
+}
+
 //--------------------------------------------------------------------------
 
 void
@@ -226,6 +305,78 @@ PCCTMC3Decoder3::activateParameterSets(const GeometryBrickHeader& gbh)
   _gps = &_gpss.cbegin()->second;
 }
 
+//==========================================================================
+
+bool
+PCCTMC3Decoder3::isAttributeSkipped(const AttributeDescription& desc) const
+{
+  if (_params.skipAttributes.empty())
+    return false;
+
+  std::stringstream name;
+  name << desc.attributeLabel;
+
+  const auto& names = _params.skipAttributes;
+  return std::find(names.begin(), names.end(), name.str()) != names.end();
+}
+
+//==========================================================================
+
+bool
+PCCTMC3Decoder3::roiEnabled() const
+{
+  const auto& size = _params.roiSize;
+  return size[0] > 0 || size[1] > 0 || size[2] > 0;
+}
+
+//--------------------------------------------------------------------------
+// The region of interest in the coordinate system of the slice @gbh.
+// An axis with a zero extent is unbounded.
+
+Box3<int32_t>
+PCCTMC3Decoder3::sliceRoi(const GeometryBrickHeader& gbh) const
+{
+  auto origin = fromXyz(_sps->geometry_axis_order, _params.roiOrigin);
+  auto size = fromXyz(_sps->geometry_axis_order, _params.roiSize);
+
+  Box3<int32_t> roi;
+  roi.min = origin - _sps->seqBoundingBoxOrigin - gbh.geomBoxOrigin;
+  roi.max = roi.min + size - 1;
+
+  for (int k = 0; k < 3; k++) {
+    if (size[k] > 0)
+      continue;
+    roi.min[k] = std::numeric_limits<int32_t>::min();
+    roi.max[k] = std::numeric_limits<int32_t>::max();
+  }
+
+  return roi;
+}
+
+//--------------------------------------------------------------------------
+// Determine if the slice @gbh may contain points in the region of interest.
+// NB: the extent of a predictive geometry slice is unknown prior to
+//     decoding, such slices are always considered to intersect.
+
+bool
+PCCTMC3Decoder3::sliceIntersectsRoi(const GeometryBrickHeader& gbh) const
+{
+  if (!roiEnabled() || _gps->predgeom_enabled_flag)
+    return true;
+
+  // the root node size is the sum of the per-level splits
+  Vec3<int> rootNodeSizeLog2 = _gps->trisoup_node_size_log2;
+  for (auto split : gbh.tree_lvl_coded_axis_list)
+    rootNodeSizeLog2 += Vec3<int>{!!(split & 4), !!(split & 2), !!(split & 1)};
+
+  Box3<int32_t> sliceBox;
+  sliceBox.min = 0;
+  for (int k = 0; k < 3; k++)
+    sliceBox.max[k] = (1 << rootNodeSizeLog2[k]) - 1;
+
+  return sliceBox.intersects(sliceRoi(gbh));
+}
+
 //==========================================================================
 // Initialise the point cloud storage and decode a single geometry slice.
 
@@ -233,19 +384,22 @@ int
 PCCTMC3Decoder3::decodeGeometryBrick(const PayloadBuffer& buf)
 {
   assert(buf.type == PayloadType::kGeometryBrick);
-  std::cout << "positions bitstream size " << buf.size() << " B\n";
+  *_log << "positions bitstream size " << buf.size() << " B\n";
 
   // todo(df): replace with attribute mapping
+  // NB: skipped attributes are neither allocated nor initialised
   bool hasColour = std::any_of(
     _sps->attributeSets.begin(), _sps->attributeSets.end(),
-    [](const AttributeDescription& desc) {
-      return desc.attributeLabel == KnownAttributeLabel::kColour;
+    [&](const AttributeDescription& desc) {
+      return desc.attributeLabel == KnownAttributeLabel::kColour
+        && !isAttributeSkipped(desc);
     });
 
   bool hasReflectance = std::any_of(
     _sps->attributeSets.begin(), _sps->attributeSets.end(),
-    [](const AttributeDescription& desc) {
-      return desc.attributeLabel == KnownAttributeLabel::kReflectance;
+    [&](const AttributeDescription& desc) {
+      return desc.attributeLabel == KnownAttributeLabel::kReflectance
+        && !isAttributeSkipped(desc);
     });
 
   _currentPointCloud.clear();
@@ -258,8 +412,22 @@ PCCTMC3Decoder3::decodeGeometryBrick(const PayloadBuffer& buf)
   _gbh = parseGbh(*_sps, *_gps, buf, &gbhSize);
   _sliceId = _gbh.geom_slice_id;
   _sliceOrigin = _gbh.geomBoxOrigin;
+  _sliceRoi = sliceRoi(_gbh);
   _currentFrameIdx = _gbh.frame_idx;
 
+  // Entropy contexts are either continued from the previous slice in
+  // decoding order, or initialised afresh.
+  if (_gbh.entropy_continuation_flag) {
+    if (_gbh.prev_slice_id != _prevSliceId)
+      throw std::runtime_error("entropy continuation of unavailable slice");
+    if (_params.minGeomNodeSizeLog2)
+      throw std::runtime_error("entropy continuation of partial decode");
+  } else {
+    _ctxtMemOctreeGeom.reset();
+    _ctxtMemPredGeom.reset();
+  }
+  _prevSliceId = _sliceId;
+
   // set default attribute values (in case an attribute data unit is lost)
   // NB: it is a requirement that geom_num_points_minus1 is correct
   _currentPointCloud.resize(_gbh.footer.geom_num_points_minus1 + 1);
@@ -315,27 +483,36 @@ PCCTMC3Decoder3::decodeGeometryBrick(const PayloadBuffer& buf)
 
   if (_gps->predgeom_enabled_flag)
     decodePredictiveGeometry(
-      *_gps, _gbh, _currentPointCloud, arithmeticDecoders[0].get());
+      *_gps, _gbh, _currentPointCloud, _ctxtMemPredGeom,
+      arithmeticDecoders[0].get());
   else if (_gps->trisoup_node_size_log2 == 0) {
+    // Points outside the region of interest need not be reconstructed if
+    // there are no attributes to be decoded using them.
+    bool geomOnly = !hasColour && !hasReflectance;
+    const Box3<int32_t>* roi = roiEnabled() && geomOnly ? &_sliceRoi : nullptr;
+
     if (!_params.minGeomNodeSizeLog2) {
       decodeGeometryOctree(
-        *_gps, _gbh, _currentPointCloud, arithmeticDecoders);
+        *_gps, _gbh, _currentPointCloud, _ctxtMemOctreeGeom,
+        arithmeticDecoders, roi);
     } else {
       decodeGeometryOctreeScalable(
         *_gps, _gbh, _params.minGeomNodeSizeLog2, _currentPointCloud,
-        arithmeticDecoders);
+        _ctxtMemOctreeGeom, arithmeticDecoders);
     }
   } else {
-    decodeGeometryTrisoup(*_gps, _gbh, _currentPointCloud, arithmeticDecoders);
+    decodeGeometryTrisoup(
+      *_gps, _gbh, _currentPointCloud, _ctxtMemOctreeGeom,
+      arithmeticDecoders);
   }
 
   clock_user.stop();
 
   auto total_user =
     std::chrono::duration_cast<std::chrono::milliseconds>(clock_user.count());
-  std::cout << "positions processing time (user): "
-            << total_user.count() / 1000.0 << " s\n";
-  std::cout << std::endl;
+  *_log << "positions processing time (user): "
+        << total_user.count() / 1000.0 << " s\n";
+  *_log << std::endl;
 
   return 0;
 }
@@ -366,24 +543,23 @@ PCCTMC3Decoder3::decodeAttributeBrick(const PayloadBuffer& buf)
 
   pcc::chrono::Stopwatch<pcc::chrono::utime_inc_children_clock> clock_user;
 
-  // replace the attribute decoder if not compatible
-  if (!_attrDecoder || !_attrDecoder->isReusable(attr_aps))
-    _attrDecoder = makeAttributeDecoder();
+  // use an attribute decoder compatible with the aps
+  auto& attrDecoder = _attrDecoders.get(
+    attr_aps, [&] { return makeAttributeDecoder(_params.numThreads); });
 
   clock_user.start();
-  _attrDecoder->decode(
+  attrDecoder.decode(
     *_sps, attr_sps, attr_aps, _gbh.footer.geom_num_points_minus1,
     _params.minGeomNodeSizeLog2, buf, _currentPointCloud);
   clock_user.stop();
 
-  std::cout << label << "s bitstream size " << buf.size() << " B\n";
+  *_log << label << "s bitstream size " << buf.size() << " B\n";
 
   auto total_user =
     std::chrono::duration_cast<std::chrono::milliseconds>(clock_user.count());
-  std::cout << label
-            << "s processing time (user): " << total_user.count() / 1000.0
-            << " s\n";
-  std::cout << std::endl;
+  *_log << label << "s processing time (user): "
+        << total_user.count() / 1000.0 << " s\n";
+  *_log << std::endl;
 }
 
 //--------------------------------------------------------------------------
@@ -36,6 +36,8 @@
 #include "PCCTMC3Encoder.h"
 
 #include <cassert>
+#include <iostream>
+#include <numeric>
 #include <set>
 #include <stdexcept>
 
@@ -55,7 +57,11 @@ namespace pcc {
 
 //============================================================================
 
-PCCTMC3Encoder3::PCCTMC3Encoder3() : _frameCounter(-1)
+PCCTMC3Encoder3::PCCTMC3Encoder3()
+  : _prevSliceId(-1)
+  , _frameCounter(-1)
+  , _streamFrameStarted(false)
+  , _log(&std::cout)
 {}
 
 //============================================================================
@@ -67,56 +73,8 @@ PCCTMC3Encoder3::compress(
   PCCTMC3Encoder3::Callbacks* callback,
   PCCPointSet3* reconstructedCloud)
 {
-  // start of frame
-  _frameCounter++;
-
-  if (_frameCounter == 0) {
-    deriveParameterSets(params);
-    fixupParameterSets(params);
-
-    // Save encoder parameters
-    _geomPreScale = params->geomPreScale;
-
-    // Determine input bounding box (for SPS metadata) if not manually set
-    Box3<int> bbox;
-    if (params->sps.seqBoundingBoxSize == Vec3<int>{0})
-      bbox = inputPointCloud.computeBoundingBox();
-    else {
-      bbox.min = params->sps.seqBoundingBoxOrigin;
-      bbox.max = bbox.min + params->sps.seqBoundingBoxSize - 1;
-    }
-
-    // Then scale the bounding box to match the reconstructed output
-    for (int k = 0; k < 3; k++) {
-      auto min_k = bbox.min[k];
-      auto max_k = bbox.max[k];
-
-      // the sps bounding box is in terms of the conformance scale
-      // not the source scale.
-      // NB: plus one to convert to range
-      min_k = std::round(min_k * params->geomPreScale);
-      max_k = std::round(max_k * params->geomPreScale);
-      params->sps.seqBoundingBoxOrigin[k] = min_k;
-      params->sps.seqBoundingBoxSize[k] = max_k - min_k + 1;
-    }
-
-    // Determine the lidar head position relative to the sequence bounding box
-    params->gps.geomAngularOrigin *= params->geomPreScale;
-    params->gps.geomAngularOrigin -= params->sps.seqBoundingBoxOrigin;
-  }
-
-  // placeholder to "activate" the parameter sets
-  _sps = &params->sps;
-  _gps = &params->gps;
-  _aps.clear();
-  for (const auto& aps : params->aps) {
-    _aps.push_back(&aps);
-  }
-
-  // initial geometry IDs
-  _tileId = 0;
-  _sliceId = 0;
-  _sliceOrigin = Vec3<int>{0};
+  PCCPointSet3 quantizedInputCloud =
+    beginFrame(inputPointCloud, params, callback);
 
   // Partition the input point cloud into tiles
   //  - quantize the input point cloud (without duplicate point removal)
@@ -128,44 +86,6 @@ PCCTMC3Encoder3::compress(
   //    slice partitioning subsequent
   //  todo(df):
   PartitionSet partitions;
-  PCCPointSet3 quantizedInputCloud;
-  quantizedInputCloud = quantization(inputPointCloud);
-
-  // determine the dist2 parameters based upon the quantized point cloud
-  // todo(df): do this only if no dist2 value is set but should be
-  bool calcDist2 = false;
-  for (auto& aps : params->aps)
-    calcDist2 |= aps.num_detail_levels > 0;
-
-  if (calcDist2) {
-    int maxNodeSizeLog2 = ceillog2(std::max(
-      {params->sps.seqBoundingBoxSize[0], params->sps.seqBoundingBoxSize[1],
-       params->sps.seqBoundingBoxSize[1]}));
-
-    // workout an intrinsic dist2
-    int baseDist2 = estimateDist2(quantizedInputCloud, maxNodeSizeLog2);
-
-    // generate dist2 series for each aps
-    for (auto& aps : params->aps) {
-      if (aps.num_detail_levels == 0)
-        continue;
-
-      aps.dist2.resize(aps.num_detail_levels);
-
-      int64_t d2 = baseDist2;
-      for (int i = 0; i < aps.num_detail_levels; ++i) {
-        aps.dist2[i] = d2;
-        d2 = 4 * d2;
-      }
-    }
-  }
-
-  // write out all parameter sets prior to encoding
-  callback->onOutputBuffer(write(*_sps));
-  callback->onOutputBuffer(write(*_sps, *_gps));
-  for (const auto aps : _aps) {
-    callback->onOutputBuffer(write(*_sps, *aps));
-  }
 
   std::vector<std::vector<int32_t>> tileMaps;
   if (params->partition.tileSize) {
@@ -275,13 +195,13 @@ PCCTMC3Encoder3::compress(
       partitions.slices.insert(
         partitions.slices.end(), curSlices.begin(), curSlices.end());
     }
-    std::cout << "Slice number: " << partitions.slices.size() << std::endl;
+    *_log << "Slice number: " << partitions.slices.size() << std::endl;
   } while (0);
 
   if (partitions.tileInventory.tiles.size() > 1) {
     auto& inventory = partitions.tileInventory;
     assert(inventory.tiles.size() == tileMaps.size());
-    std::cout << "Tile number: " << tileMaps.size() << std::endl;
+    *_log << "Tile number: " << tileMaps.size() << std::endl;
     inventory.ti_seq_parameter_set_id = _sps->sps_seq_parameter_set_id;
     inventory.origin = _sps->seqBoundingBoxOrigin;
     callback->onOutputBuffer(write(*_sps, partitions.tileInventory));
@@ -322,6 +242,220 @@ PCCTMC3Encoder3::compress(
 
 //----------------------------------------------------------------------------
 
+int
+PCCTMC3Encoder3::pushPoints(
+  const PCCPointSet3& points,
+  EncoderParams* params,
+  PCCTMC3Encoder3::Callbacks* callback,
+  PCCPointSet3* reconstructedCloud)
+{
+  // Without the complete frame, the sequence bounding box cannot be derived
+  if (params->sps.seqBoundingBoxSize == Vec3<int>{0})
+    throw std::runtime_error("streaming requires a sequence bounding box");
+
+  int sliceMaxPoints = params->partition.sliceMaxPoints;
+  if (sliceMaxPoints <= 0)
+    throw std::runtime_error("streaming requires a positive sliceMaxPoints");
+
+  if (!_streamCloud.getPointCount())
+    _streamSliceStart = std::chrono::steady_clock::now();
+
+  _streamCloud.append(points);
+
+  // extract a slice each time the point count limit is reached
+  int numPoints = _streamCloud.getPointCount();
+  int numSlices = numPoints / sliceMaxPoints;
+  std::vector<PCCPointSet3> sliceClouds(numSlices);
+  std::vector<int32_t> indexes(sliceMaxPoints);
+  for (int i = 0; i < numSlices; i++) {
+    std::iota(indexes.begin(), indexes.end(), i * sliceMaxPoints);
+    getSrcPartition(_streamCloud, sliceClouds[i], indexes);
+  }
+
+  // retain only the remaining points
+  if (numSlices) {
+    PCCPointSet3 remaining;
+    indexes.resize(numPoints - numSlices * sliceMaxPoints);
+    std::iota(indexes.begin(), indexes.end(), numSlices * sliceMaxPoints);
+    getSrcPartition(_streamCloud, remaining, indexes);
+    swap(_streamCloud, remaining);
+  }
+
+  for (auto& sliceCloud : sliceClouds) {
+    compressStreamSlice(sliceCloud, params, callback, reconstructedCloud);
+    _streamSliceStart = std::chrono::steady_clock::now();
+  }
+
+  // and when the oldest buffered point exceeds the time budget
+  auto maxDuration =
+    std::chrono::milliseconds(params->partition.sliceMaxDurationMs);
+  auto duration = std::chrono::steady_clock::now() - _streamSliceStart;
+  if (maxDuration.count() && duration >= maxDuration)
+    return endSlice(params, callback, reconstructedCloud);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+
+int
+PCCTMC3Encoder3::endSlice(
+  EncoderParams* params,
+  PCCTMC3Encoder3::Callbacks* callback,
+  PCCPointSet3* reconstructedCloud)
+{
+  if (!_streamCloud.getPointCount())
+    return 0;
+
+  PCCPointSet3 sliceCloud;
+  swap(sliceCloud, _streamCloud);
+  compressStreamSlice(sliceCloud, params, callback, reconstructedCloud);
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+
+int
+PCCTMC3Encoder3::endFrame(
+  EncoderParams* params,
+  PCCTMC3Encoder3::Callbacks* callback,
+  PCCPointSet3* reconstructedCloud)
+{
+  int ret = endSlice(params, callback, reconstructedCloud);
+  _streamFrameStarted = false;
+  return ret;
+}
+
+//----------------------------------------------------------------------------
+// Code the buffered points of a stream as a single slice.  The first
+// slice of each frame starts the frame.
+
+void
+PCCTMC3Encoder3::compressStreamSlice(
+  const PCCPointSet3& sliceCloud,
+  EncoderParams* params,
+  PCCTMC3Encoder3::Callbacks* callback,
+  PCCPointSet3* reconstructedCloud)
+{
+  PCCPointSet3 quantizedSliceCloud;
+  if (!_streamFrameStarted) {
+    quantizedSliceCloud = beginFrame(sliceCloud, params, callback);
+    _streamFrameStarted = true;
+  } else
+    quantizedSliceCloud = quantization(sliceCloud);
+
+  _sliceOrigin = quantizedSliceCloud.computeBoundingBox().min;
+  compressPartition(
+    quantizedSliceCloud, sliceCloud, params, callback, reconstructedCloud);
+}
+
+//----------------------------------------------------------------------------
+// Starts coding a new frame, returning the quantised inputPointCloud.
+// Per-frame parameters are derived from inputPointCloud, which need not
+// be the complete frame, and the parameter sets are written.
+
+PCCPointSet3
+PCCTMC3Encoder3::beginFrame(
+  const PCCPointSet3& inputPointCloud,
+  EncoderParams* params,
+  PCCTMC3Encoder3::Callbacks* callback)
+{
+  // start of frame
+  _frameCounter++;
+
+  if (_frameCounter == 0) {
+    deriveParameterSets(params);
+    fixupParameterSets(params);
+
+    // Save encoder parameters
+    _geomPreScale = params->geomPreScale;
+
+    // Determine input bounding box (for SPS metadata) if not manually set
+    Box3<int> bbox;
+    if (params->sps.seqBoundingBoxSize == Vec3<int>{0})
+      bbox = inputPointCloud.computeBoundingBox();
+    else {
+      bbox.min = params->sps.seqBoundingBoxOrigin;
+      bbox.max = bbox.min + params->sps.seqBoundingBoxSize - 1;
+    }
+
+    // Then scale the bounding box to match the reconstructed output
+    for (int k = 0; k < 3; k++) {
+      auto min_k = bbox.min[k];
+      auto max_k = bbox.max[k];
+
+      // the sps bounding box is in terms of the conformance scale
+      // not the source scale.
+      // NB: plus one to convert to range
+      min_k = std::round(min_k * params->geomPreScale);
+      max_k = std::round(max_k * params->geomPreScale);
+      params->sps.seqBoundingBoxOrigin[k] = min_k;
+      params->sps.seqBoundingBoxSize[k] = max_k - min_k + 1;
+    }
+
+    // Determine the lidar head position relative to the sequence bounding box
+    params->gps.geomAngularOrigin *= params->geomPreScale;
+    params->gps.geomAngularOrigin -= params->sps.seqBoundingBoxOrigin;
+  }
+
+  // placeholder to "activate" the parameter sets
+  _sps = &params->sps;
+  _gps = &params->gps;
+  _aps.clear();
+  for (const auto& aps : params->aps) {
+    _aps.push_back(&aps);
+  }
+
+  // initial geometry IDs
+  _tileId = 0;
+  _sliceId = 0;
+  _sliceOrigin = Vec3<int>{0};
+  _firstSliceInFrame = true;
+
+  PCCPointSet3 quantizedInputCloud;
+  quantizedInputCloud = quantization(inputPointCloud);
+
+  // determine the dist2 parameters based upon the quantized point cloud
+  // todo(df): do this only if no dist2 value is set but should be
+  bool calcDist2 = false;
+  for (auto& aps : params->aps)
+    calcDist2 |= aps.num_detail_levels > 0;
+
+  if (calcDist2) {
+    int maxNodeSizeLog2 = ceillog2(std::max(
+      {params->sps.seqBoundingBoxSize[0], params->sps.seqBoundingBoxSize[1],
+       params->sps.seqBoundingBoxSize[1]}));
+
+    // workout an intrinsic dist2
+    int baseDist2 = estimateDist2(quantizedInputCloud, maxNodeSizeLog2);
+
+    // generate dist2 series for each aps
+    for (auto& aps : params->aps) {
+      if (aps.num_detail_levels == 0)
+        continue;
+
+      aps.dist2.resize(aps.num_detail_levels);
+
+      int64_t d2 = baseDist2;
+      for (int i = 0; i < aps.num_detail_levels; ++i) {
+        aps.dist2[i] = d2;
+        d2 = 4 * d2;
+      }
+    }
+  }
+
+  // write out all parameter sets prior to encoding
+  callback->onOutputBuffer(write(*_sps));
+  callback->onOutputBuffer(write(*_sps, *_gps));
+  for (const auto aps : _aps) {
+    callback->onOutputBuffer(write(*_sps, *aps));
+  }
+
+  return quantizedInputCloud;
+}
+
+//----------------------------------------------------------------------------
+
 void
 PCCTMC3Encoder3::deriveParameterSets(EncoderParams* params)
 {
@@ -445,15 +579,15 @@ PCCTMC3Encoder3::compressPartition(
     clock_user.stop();
 
     double bpp = double(8 * payload.size()) / inputPointCloud.getPointCount();
-    std::cout << "positions bitstream size " << payload.size() << " B (" << bpp
-              << " bpp)\n";
+    *_log << "positions bitstream size " << payload.size() << " B (" << bpp
+          << " bpp)\n";
 
     auto total_user = std::chrono::duration_cast<std::chrono::milliseconds>(
       clock_user.count());
-    std::cout << "positions processing time (user): "
-              << total_user.count() / 1000.0 << " s" << std::endl;
+    *_log << "positions processing time (user): "
+          << total_user.count() / 1000.0 << " s" << std::endl;
 
-    callback->onOutputBuffer(payload);
+    callback->onOutputBuffer(std::move(payload));
   }
 
   // verify that the per-level slice constraint has been met
@@ -468,9 +602,13 @@ PCCTMC3Encoder3::compressPartition(
   // NB: recolouring is required if points are added / removed
   if (_gps->geom_unique_points_flag || _gps->trisoup_node_size_log2 > 0) {
     for (const auto& attr_sps : _sps->attributeSets) {
-      recolour(
+      int err = recolour(
         attr_sps, params->recolour, originPartCloud, params->geomPreScale,
         _sps->seqBoundingBoxOrigin + _sliceOrigin, &pointCloud);
+
+      if (err)
+        *_log << "Error: can't transfer " << attr_sps.attributeLabel << "s!"
+              << std::endl;
     }
   }
 
@@ -479,7 +617,11 @@ PCCTMC3Encoder3::compressPartition(
   callback->onPostRecolour(pointCloud);
 
   // attributeCoding
-  auto attrEncoder = makeAttributeEncoder();
+  // NB: a retained attribute encoder only reuses its LoDs if the geometry
+  //     of this slice is identical to that used to generate them
+  if (!params->attrLodCacheEnabled)
+    _attrEncoders.clear();
+  _attrEncoders.beginSlice();
 
   // for each attribute
   for (const auto& it : params->attributeIdxMap) {
@@ -517,29 +659,30 @@ PCCTMC3Encoder3::compressPartition(
 
     write(*_sps, attr_aps, abh, &payload);
 
-    // replace the attribute encoder if not compatible
-    if (!attrEncoder->isReusable(attr_aps))
-      attrEncoder = makeAttributeEncoder();
+    // use an attribute encoder compatible with the aps
+    auto& attrEncoder = _attrEncoders.get(
+      attr_aps, [&] { return makeAttributeEncoder(params->numThreads); });
 
-    attrEncoder->encode(*_sps, attr_sps, attr_aps, abh, pointCloud, &payload);
+    attrEncoder.encode(*_sps, attr_sps, attr_aps, abh, pointCloud, &payload);
     clock_user.stop();
 
     int coded_size = int(payload.size());
     double bpp = double(8 * coded_size) / inputPointCloud.getPointCount();
-    std::cout << label << "s bitstream size " << coded_size << " B (" << bpp
-              << " bpp)\n";
+    *_log << label << "s bitstream size " << coded_size << " B (" << bpp
+          << " bpp)\n";
 
     auto time_user = std::chrono::duration_cast<std::chrono::milliseconds>(
       clock_user.count());
-    std::cout << label
-              << "s processing time (user): " << time_user.count() / 1000.0
-              << " s" << std::endl;
+    *_log << label << "s processing time (user): "
+          << time_user.count() / 1000.0 << " s" << std::endl;
 
-    callback->onOutputBuffer(payload);
+    callback->onOutputBuffer(std::move(payload));
   }
 
   // prevent re-use of this sliceId:  the next slice (geometry + attributes)
   // should be distinguishable from the current slice.
+  _prevSliceId = _sliceId;
+  _firstSliceInFrame = false;
   _sliceId++;
 
   appendReconstructedPoints(reconstructedCloud);
@@ -556,11 +699,24 @@ PCCTMC3Encoder3::encodeGeometryBrick(
   gbh.geom_slice_id = _sliceId;
   gbh.geom_tile_id = std::max(0, _tileId);
   gbh.frame_idx = _frameCounter & ((1 << _sps->log2_max_frame_idx) - 1);
+  gbh.prev_slice_id = _prevSliceId;
+
+  // all but the first slice of a frame continue with the entropy contexts
+  // at the end of the previous slice (if permitted)
+  gbh.entropy_continuation_flag =
+    _sps->entropy_continuation_enabled_flag && !_firstSliceInFrame;
+
+  if (!gbh.entropy_continuation_flag) {
+    _ctxtMemOctreeGeom.reset();
+    _ctxtMemPredGeom.reset();
+  }
   gbh.geomBoxOrigin = _sliceOrigin;
   gbh.geom_box_log2_scale = 0;
   gbh.geom_slice_qp_offset = params->gbh.geom_slice_qp_offset;
   gbh.geom_octree_qp_offset_depth = params->gbh.geom_octree_qp_offset_depth;
   gbh.geom_stream_cnt_minus1 = params->gbh.geom_stream_cnt_minus1;
+  if (_gps->predgeom_enabled_flag)
+    gbh.geom_stream_cnt_minus1 = 0;
 
   // inform the geometry coder what the root node size is
   gbh.maxRootNodeDimLog2 = 0;
@@ -589,16 +745,19 @@ PCCTMC3Encoder3::encodeGeometryBrick(
 
   if (_gps->predgeom_enabled_flag)
     encodePredictiveGeometry(
-      params->predGeom, *_gps, gbh, pointCloud, arithmeticEncoders[0].get());
+      params->predGeom, *_gps, gbh, pointCloud, _ctxtMemPredGeom,
+      arithmeticEncoders[0].get());
   else if (_gps->trisoup_node_size_log2 == 0)
     encodeGeometryOctree(
-      params->geom, *_gps, gbh, pointCloud, arithmeticEncoders);
+      params->geom, *_gps, gbh, pointCloud, _ctxtMemOctreeGeom,
+      arithmeticEncoders);
   else {
     // limit the number of points to the slice limit
     // todo(df): this should be derived from the level
     gbh.footer.geom_num_points_minus1 = params->partition.sliceMaxPoints - 1;
     encodeGeometryTrisoup(
-      params->geom, *_gps, gbh, pointCloud, arithmeticEncoders);
+      params->geom, *_gps, gbh, pointCloud, _ctxtMemOctreeGeom,
+      arithmeticEncoders);
   }
 
   // signal the actual number of points coded
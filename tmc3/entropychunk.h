@@ -61,6 +61,7 @@ public:
   size_t size() const;
   void writeAecByte(uint8_t byte);
   void writeBypassBit(bool bit);
+  void writeBypassBits(uint32_t value, int numBits);
   void flush();
 
 private:
@@ -144,6 +145,37 @@ ChunkStreamBuilder::writeBypassBit(bool bit)
   *_bypassPtr = (*_bypassPtr << 1) | bit;
 }
 
+//-----------------------------------------------------------------------------
+// Writes the numBits least significant bits of value, msb first.  The
+// result is identical to numBits calls to writeBypassBit(), but bits are
+// packed into the current byte as many at a time as the byte and the
+// chunk allocation permit.
+
+inline void
+ChunkStreamBuilder::writeBypassBits(uint32_t value, int numBits)
+{
+  while (numBits > 0) {
+    if (_bypassByteAllocCounter < 1) {
+      reserveChunkByte();
+      _bypassByteAllocCounter += 8;
+    }
+
+    if (!_bypassBitIdx) {
+      _bypassPtr--;
+      _bypassBitIdx = 8;
+    }
+
+    int n = std::min(_bypassBitIdx, _bypassByteAllocCounter);
+    n = std::min(n, numBits);
+    numBits -= n;
+    _bypassByteAllocCounter -= n;
+    _bypassBitIdx -= n;
+
+    uint32_t bits = (value >> numBits) & ((1u << n) - 1);
+    *_bypassPtr = (*_bypassPtr << n) | bits;
+  }
+}
+
 //-----------------------------------------------------------------------------
 
 inline void
@@ -261,6 +293,7 @@ public:
 
   uint8_t readAecByte();
   bool readBypassBit();
+  uint32_t readBypassBits(int numBits);
 
 private:
   static const int kChunkSize = 256;
@@ -363,6 +396,31 @@ ChunkStreamReader::readBypassBit()
   return readBypassBit();
 }
 
+//-----------------------------------------------------------------------------
+// Reads numBits bits, msb first, equivalently to numBits calls to
+// readBypassBit().  Bits are extracted from the accumulator as many at a
+// time as are available; refills fall back to the single bit path.
+
+inline uint32_t
+ChunkStreamReader::readBypassBits(int numBits)
+{
+  uint32_t value = 0;
+  while (numBits > 0) {
+    if (_bypassAccumBitsRemaining <= 0) {
+      value = (value << 1) | readBypassBit();
+      numBits--;
+      continue;
+    }
+
+    int n = std::min(numBits, _bypassAccumBitsRemaining);
+    value = (value << n) | (_bypassAccum >> (8 - n));
+    _bypassAccum <<= n;
+    _bypassAccumBitsRemaining -= n;
+    numBits -= n;
+  }
+  return value;
+}
+
 //=============================================================================
 
 }  // namespace pcc
@@ -169,6 +169,23 @@ namespace dirac {
       _chunkStream.writeBypassBit(bit);
     }
 
+    //------------------------------------------------------------------------
+    // Encodes the numBits least significant bits of value (msb first) as
+    // equiprobable bins.
+
+    void encodeBypass(uint32_t value, int numBits)
+    {
+      if (!_cabac_bypass_stream_enabled_flag) {
+        while (numBits-- > 0) {
+          uint16_t probability = 0x8000;  // p=0.5
+          schro_arith_encode_bit(&impl, &probability, (value >> numBits) & 1);
+        }
+        return;
+      }
+
+      _chunkStream.writeBypassBits(value, numBits);
+    }
+
     //------------------------------------------------------------------------
 
     void encode(int data, SchroMAryContext& model);
@@ -254,12 +271,29 @@ namespace dirac {
     {
       if (!_cabac_bypass_stream_enabled_flag) {
         uint16_t probability = 0x8000;  // p=0.5
-        return schro_arith_decode_bit(&impl, &probability);
+        return decodeBin(probability);
       }
 
       return _chunkReader.readBypassBit();
     }
 
+    //------------------------------------------------------------------------
+    // Decodes numBits equiprobable bins, msb first.
+
+    uint32_t decodeBypass(int numBits)
+    {
+      if (!_cabac_bypass_stream_enabled_flag) {
+        uint32_t value = 0;
+        while (numBits-- > 0) {
+          uint16_t probability = 0x8000;  // p=0.5
+          value = (value << 1) | decodeBin(probability);
+        }
+        return value;
+      }
+
+      return _chunkReader.readBypassBits(numBits);
+    }
+
     //------------------------------------------------------------------------
 
     int decode(SchroMAryContext& model);
@@ -274,13 +308,69 @@ namespace dirac {
 
     //------------------------------------------------------------------------
 
-    int decode(SchroContext& model)
+    int decode(SchroContext& model) { return decodeBin(model.probability); }
+
+    //------------------------------------------------------------------------
+  private:
+    // Decodes a single bin, updating the adaptive probability.
+    //
+    // This is equivalent to schro_arith_decode_bit(), but renormalises
+    // the range by the required number of bits at once (found by table
+    // lookup), refilling the code register a word at a time.
+    int decodeBin(uint16_t& probability)
     {
-      return schro_arith_decode_bit(&impl, &model.probability);
+      uint32_t range = impl.range[1];
+      uint32_t code = impl.code;
+
+      // NB: ranges less than 2^24 are rare and may need multiple steps
+      int shift;
+      do {
+        shift = kRenormShift[(range - 1) >> 24];
+        range <<= shift;
+        code <<= shift;
+        impl.cntr -= shift;
+        if (impl.cntr <= 0) {
+          code |= readWord() << -impl.cntr;
+          impl.cntr += 16;
+        }
+      } while (range <= 0x40000000);
+
+      uint32_t rangeXprob = ((range >> 16) * probability) & 0xffff0000;
+      int bin = code >= rangeXprob;
+      probability += impl.lut[(probability >> 7 & ~1) | bin];
+
+      // NB: written to favour conditional moves over branches
+      code -= rangeXprob & -uint32_t(bin);
+      range = bin ? range - rangeXprob : rangeXprob;
+
+      impl.range[1] = range;
+      impl.code = code;
+      return bin;
+    }
+
+    //------------------------------------------------------------------------
+    // Reads the next 16 bits of arithmetic coded data.
+
+    uint32_t readWord()
+    {
+      uint32_t word;
+      if (_cabac_bypass_stream_enabled_flag) {
+        word = _chunkReader.readAecByte() << 8;
+        return word | _chunkReader.readAecByte();
+      }
+
+      if (_bufferLen >= 2) {
+        word = (_buffer[0] << 8) | _buffer[1];
+        _buffer += 2;
+        _bufferLen -= 2;
+        return word;
+      }
+
+      word = readByteCallback(this) << 8;
+      return word | readByteCallback(this);
     }
 
     //------------------------------------------------------------------------
-  private:
     static uint8_t readByteCallback(void* thisptr)
     {
       auto _this = reinterpret_cast<ArithmeticDecoder*>(thisptr);
@@ -303,6 +393,10 @@ namespace dirac {
   private:
     ::SchroArith impl;
 
+    // Number of bits required to renormalise a range r, indexed by
+    // (r - 1) >> 24.  Ranges r <= 2^24 are only partially renormalised.
+    static const uint8_t kRenormShift[256];
+
     // the user supplied buffer.
     const uint8_t* _buffer;
 
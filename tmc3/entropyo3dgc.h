@@ -93,6 +93,13 @@ namespace o3dgc {
     {
       ::o3dgc::Arithmetic_Codec::encode(data, model);
     }
+
+    void encodeBypass(uint32_t value, int numBits)
+    {
+      ::o3dgc::Static_Bit_Model model;
+      while (numBits-- > 0)
+        ::o3dgc::Arithmetic_Codec::encode((value >> numBits) & 1, model);
+    }
   };
 
   //============================================================================
@@ -132,6 +139,15 @@ namespace o3dgc {
     {
       return ::o3dgc::Arithmetic_Codec::decode(model);
     }
+
+    uint32_t decodeBypass(int numBits)
+    {
+      ::o3dgc::Static_Bit_Model model;
+      uint32_t value = 0;
+      while (numBits-- > 0)
+        value = (value << 1) | ::o3dgc::Arithmetic_Codec::decode(model);
+      return value;
+    }
   };
 
   //============================================================================
@@ -0,0 +1,101 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "entropydirac.h"
+
+namespace pcc {
+
+//============================================================================
+// Fixed-point estimation of the rate of entropy coded symbols, for use
+// by encoder decisions.
+//
+// Rates are expressed in units of 2^-kRateFracBits bits.  Probabilities
+// are expressed in units of 2^-kRateProbBits.
+
+const int kRateFracBits = 10;
+const int kRateProbBits = 12;
+
+//----------------------------------------------------------------------------
+// Mapping of probability to rate, rate[p] = -log2(p / 2^kRateProbBits).
+
+struct RateTable {
+  RateTable();
+
+  uint16_t rate[(1 << kRateProbBits) + 1];
+};
+
+extern const RateTable kRateTable;
+
+//----------------------------------------------------------------------------
+// The rate of a symbol with probability prob / 2^kRateProbBits.
+
+inline int
+rateFromProb(int prob)
+{
+  return kRateTable.rate[prob];
+}
+
+//----------------------------------------------------------------------------
+// The rate of a symbol that has occurred count times out of total.
+// NB: the probability is limited to the range [2^-10, 1 - 2^-10].
+
+inline int
+rateFromFreq(size_t count, size_t total)
+{
+  const int kMinProb = 1 << (kRateProbBits - 10);
+  const int kMaxProb = (1 << kRateProbBits) - kMinProb;
+  int prob = int((uint64_t(count) << kRateProbBits) / total);
+  return rateFromProb(std::max(kMinProb, std::min(kMaxProb, prob)));
+}
+
+//----------------------------------------------------------------------------
+// The rate of coding bit using an adaptive binary context model.
+
+inline int
+rateOfBit(int bit, const dirac::SchroContext& model)
+{
+  int prob0 = std::max(1, model.probability >> (16 - kRateProbBits));
+  return rateFromProb(bit ? (1 << kRateProbBits) - prob0 : prob0);
+}
+
+//============================================================================
+
+}  // namespace pcc
@@ -51,6 +51,7 @@ namespace pcc {
 //  - void encode(int symbol, AdaptiveBitModel&);
 //  - void encode(int symbol, AdaptiveBitModelFast&);
 //  - void encode(int symbol, AdaptiveMAryModel&);
+//  - void encodeBypass(uint32_t value, int numBits);
 
 template<class Base>
 class EntropyEncoderWrapper : protected Base {
@@ -59,6 +60,7 @@ public:
   using Base::buffer;
   using Base::enableBypassStream;
   using Base::encode;
+  using Base::encodeBypass;
   using Base::setBuffer;
   using Base::start;
   using Base::stop;
@@ -99,6 +101,7 @@ public:
 //  - int decode(AdaptiveBitModel&);
 //  - int decode(AdaptiveBitModelFast&);
 //  - int decode(AdaptiveMAryModel&);
+//  - uint32_t decodeBypass(int numBits);
 
 template<class Base>
 class EntropyDecoderWrapper : protected Base {
@@ -106,6 +109,7 @@ public:
   EntropyDecoderWrapper() : Base() {}
 
   using Base::decode;
+  using Base::decodeBypass;
   using Base::enableBypassStream;
   using Base::setBuffer;
   using Base::start;
@@ -167,11 +171,8 @@ EntropyEncoderWrapper<Base>::encodeExpGolomb(
       symbol = symbol - (1 << k);
       k++;
     } else {
-      encode(0, bModel1);  // now terminated zero of unary part
-      while (k--)          // next binary part
-      {
-        encode(static_cast<signed short>((symbol >> k) & 1), bModel0);
-      }
+      encode(0, bModel1);      // now terminated zero of unary part
+      encodeBypass(symbol, k);  // next binary part
       break;
     }
   }
@@ -194,10 +195,7 @@ EntropyDecoderWrapper<Base>::decodeExpGolomb(
       k++;
     }
   } while (l != 0);
-  while (k--)  //next binary part
-    if (decode(bModel0) == 1) {
-      binary_symbol |= (1 << k);
-    }
+  binary_symbol = decodeBypass(k);  //next binary part
   return static_cast<unsigned int>(symbol + binary_symbol);
 }
 
@@ -48,24 +48,34 @@ namespace pcc {
 
 //============================================================================
 
+class GeometryOctreeContexts;
+struct PredGeomContexts;
+
+//============================================================================
+
 void encodeGeometryOctree(
   const OctreeEncOpts& opt,
   const GeometryParameterSet& gps,
   GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyEncoder>>& arithmeticEncoder);
 
+// NB: if @roi is not null, only points within @roi are output.
 void decodeGeometryOctree(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
-  std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoder);
+  GeometryOctreeContexts& ctxtMem,
+  std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoder,
+  const Box3<int32_t>* roi = nullptr);
 
 void decodeGeometryOctreeScalable(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   int minGeomNodeSizeLog2,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoder);
 
 //----------------------------------------------------------------------------
@@ -75,12 +85,14 @@ void encodeGeometryTrisoup(
   const GeometryParameterSet& gps,
   GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyEncoder>>& arithmeticEncoder);
 
 void decodeGeometryTrisoup(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoder);
 
 //----------------------------------------------------------------------------
@@ -90,12 +102,14 @@ void encodePredictiveGeometry(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  PredGeomContexts& ctxtMem,
   EntropyEncoder* arithmeticEncoder);
 
 void decodePredictiveGeometry(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  PredGeomContexts& ctxtMem,
   EntropyDecoder* arithmeticDecoder);
 
 //============================================================================
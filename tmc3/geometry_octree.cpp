@@ -37,6 +37,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
 
 #include "PCCMisc.h"
 #include "geometry_params.h"
@@ -373,12 +374,30 @@ CtxMapOctreeOccupancy::CtxMapOctreeOccupancy()
   fill(begin(map->b7), end(map->b7), 127);
 }
 
+//============================================================================
+
+GeometryOctreeContexts::GeometryOctreeContexts()
+{
+  // NB: the bytewise coders are unused if bitwise occupancy coding is used
+  for (int i = 0; i < 10; i++)
+    _bytewiseOccupancyCoder[i].init(kDualLutOccupancyCoderInit[i]);
+}
+
+//----------------------------------------------------------------------------
+
+void
+GeometryOctreeContexts::reset()
+{
+  *this = GeometryOctreeContexts();
+}
+
 //============================================================================
 // determine if a 222 block is planar
 
 void
 isPlanarNode(
   const PCCPointSet3& pointCloud,
+  const std::vector<uint32_t>& pointIdx,
   const PCCOctree3Node& node0,
   const Vec3<int>& nodeSizeLog2Minus1,
   uint8_t& planarMode,
@@ -392,9 +411,10 @@ isPlanarNode(
   point_t occup = 0;
   // find occupancy N xyz-planes
   for (int k = node0.start; k < node0.end; k++) {
-    occup[0] |= planarEligible[0] << bool(pointCloud[k][0] & occupMask[0]);
-    occup[1] |= planarEligible[1] << bool(pointCloud[k][1] & occupMask[1]);
-    occup[2] |= planarEligible[2] << bool(pointCloud[k][2] & occupMask[2]);
+    const auto& pos = pointCloud[pointIdx[k]];
+    occup[0] |= planarEligible[0] << bool(pos[0] & occupMask[0]);
+    occup[1] |= planarEligible[1] << bool(pos[1] & occupMask[1]);
+    occup[2] |= planarEligible[2] << bool(pos[2] & occupMask[2]);
   }
 
   // determine planar
@@ -601,64 +621,64 @@ OctreePlanarState::operator=(OctreePlanarState&& rhs)
 // directional mask depending on the planarity
 
 int
-maskPlanarX(const PCCOctree3Node& node0, bool implicitSkip)
+maskPlanarX(const OctreeNodePlanar& planar, bool implicitSkip)
 {
   if (implicitSkip)
     return 0xf0;
 
-  if ((node0.planarMode & 1) == 0)
+  if ((planar.planarMode & 1) == 0)
     return 0;
 
-  return (node0.planePosBits & 1) ? 0x0f : 0xf0;
+  return (planar.planePosBits & 1) ? 0x0f : 0xf0;
 }
 
 //----------------------------------------------------------------------------
 
 int
-maskPlanarY(const PCCOctree3Node& node0, bool implicitSkip)
+maskPlanarY(const OctreeNodePlanar& planar, bool implicitSkip)
 {
   if (implicitSkip)
     return 0xcc;
 
-  if ((node0.planarMode & 2) == 0)
+  if ((planar.planarMode & 2) == 0)
     return 0;
 
-  return (node0.planePosBits & 2) ? 0x33 : 0xcc;
+  return (planar.planePosBits & 2) ? 0x33 : 0xcc;
 }
 
 //----------------------------------------------------------------------------
 
 int
-maskPlanarZ(const PCCOctree3Node& node0, bool implicitSkip)
+maskPlanarZ(const OctreeNodePlanar& planar, bool implicitSkip)
 {
   // QTBT does not split in this direction
   //   => infer the mask low for occupancy bit coding
   if (implicitSkip)
     return 0xaa;
 
-  if ((node0.planarMode & 4) == 0)
+  if ((planar.planarMode & 4) == 0)
     return 0;
 
-  return (node0.planePosBits & 4) ? 0x55 : 0xaa;
+  return (planar.planePosBits & 4) ? 0x55 : 0xaa;
 }
 
 //----------------------------------------------------------------------------
 
 // three direction mask
 void
-maskPlanar(PCCOctree3Node& node0, int mask[3], const int occupancySkip)
+maskPlanar(OctreeNodePlanar& planar, int mask[3], const int occupancySkip)
 {
   static const uint8_t kPossibleMask[3] = {6, 5, 3};
   for (int k = 0; k <= 2; k++)
     if (occupancySkip & (4 >> k)) {
-      node0.planarPossible = node0.planarPossible | (1 << k);
-      node0.planePosBits = node0.planePosBits & kPossibleMask[k];
-      node0.planarMode = node0.planarMode | (1 << k);
+      planar.planarPossible = planar.planarPossible | (1 << k);
+      planar.planePosBits = planar.planePosBits & kPossibleMask[k];
+      planar.planarMode = planar.planarMode | (1 << k);
     }
 
-  mask[0] = maskPlanarX(node0, occupancySkip & 4);
-  mask[1] = maskPlanarY(node0, occupancySkip & 2);
-  mask[2] = maskPlanarZ(node0, occupancySkip & 1);
+  mask[0] = maskPlanarX(planar, occupancySkip & 4);
+  mask[1] = maskPlanarY(planar, occupancySkip & 2);
+  mask[2] = maskPlanarZ(planar, occupancySkip & 1);
 }
 
 //----------------------------------------------------------------------------
@@ -666,15 +686,17 @@ maskPlanar(PCCOctree3Node& node0, int mask[3], const int occupancySkip)
 
 int
 determineContextAngleForPlanar(
-  PCCOctree3Node& child,
+  const PCCOctree3Node& child,
+  OctreeNodePlanar& childPlanar,
   const Vec3<int>& headPos,
   Vec3<int> childSizeLog2,
   const int* zLaser,
   const int* thetaLaser,
-  const int numLasers,
+  const AngularLaserLut& laserLut,
   int deltaAngle,
   const AzimuthalPhiZi& phiZi,
   int* phiBuffer,
+  AngularPlanarColumn* column,
   int* contextAnglePhiX,
   int* contextAnglePhiY)
 {
@@ -696,9 +718,28 @@ determineContextAngleForPlanar(
   if (deltaAngleR <= (midNode[2] << 26))
     return -1;
 
-  // determine inverse of r  (1/sqrt(r2) = irsqrt(r2))
-  uint64_t r2 = xLidar * xLidar + yLidar * yLidar;
-  uint64_t rInv = irsqrt(r2);
+  // the radius and azimuth are shared by all nodes in a column
+  int posx = absPos[0] - headPos[0];
+  int posy = absPos[1] - headPos[1];
+  if (
+    !column->valid || column->posx != posx || column->posy != posy
+    || column->midx != midNode[0] || column->midy != midNode[1]) {
+    column->valid = true;
+    column->posx = posx;
+    column->posy = posy;
+    column->midx = midNode[0];
+    column->midy = midNode[1];
+
+    // determine inverse of r  (1/sqrt(r2) = irsqrt(r2))
+    uint64_t r2 = xLidar * xLidar + yLidar * yLidar;
+    column->rInv = irsqrt(r2);
+
+    //angles
+    column->phiNode = iatan2(posy + midNode[1], posx + midNode[0]);
+    column->phiNode0 = iatan2(posy, posx);
+  }
+
+  uint64_t rInv = column->rInv;
 
   // determine non-corrected theta
   int64_t zLidar = ((absPos[2] - headPos[2] + midNode[2]) << 1) - 1;
@@ -706,26 +747,15 @@ determineContextAngleForPlanar(
   int theta32 = theta >= 0 ? theta >> 15 : -((-theta) >> 15);
 
   // determine laser
-  int laserIndex = int(child.laserIndex);
+  int laserIndex = int(childPlanar.laserIndex);
   if (laserIndex == 255 || deltaAngleR <= (midNode[2] << (26 + 2))) {
-    int delta = std::abs(thetaLaser[0] - theta32);
-    laserIndex = 0;
-    for (int j = 1; j < numLasers; j++) {
-      int temp = std::abs(thetaLaser[j] - theta32);
-      if (temp < delta) {
-        delta = temp;
-        laserIndex = j;
-      }
-    }
-    child.laserIndex = uint8_t(laserIndex);
+    laserIndex = laserLut.closest(theta32);
+    childPlanar.laserIndex = uint8_t(laserIndex);
   }
 
   // -- PHI  --
-  //angles
-  int posx = absPos[0] - headPos[0];
-  int posy = absPos[1] - headPos[1];
-  int phiNode = iatan2(posy + midNode[1], posx + midNode[0]);
-  int phiNode0 = iatan2(posy, posx);
+  int phiNode = column->phiNode;
+  int phiNode0 = column->phiNode0;
 
   // find predictor
   int predPhi = phiBuffer[laserIndex];
@@ -784,14 +814,11 @@ determineContextAngleForPlanar(
 
 //============================================================================
 
-int
-findLaser(pcc::point_t point, const int* thetaList, const int numTheta)
-{
-  int64_t xLidar = int64_t(point[0]) << 8;
-  int64_t yLidar = int64_t(point[1]) << 8;
-  int64_t rInv = irsqrt(xLidar * xLidar + yLidar * yLidar);
-  int theta32 = (point[2] * rInv) >> 14;
+// The laser index for the angle @theta32, as determined by findLaser.
 
+static int
+findLaserTheta(int theta32, const int* thetaList, int numTheta)
+{
   // determine theta
   int start = 0;
   int end = numTheta - 1;
@@ -816,6 +843,155 @@ findLaser(pcc::point_t point, const int* thetaList, const int numTheta)
   return laser;
 }
 
+//----------------------------------------------------------------------------
+// The index of the laser with the angle closest to @theta32.
+
+static int
+findClosestLaserTheta(int theta32, const int* thetaList, int numTheta)
+{
+  int delta = std::abs(thetaList[0] - theta32);
+  int laser = 0;
+  for (int j = 1; j < numTheta; j++) {
+    int temp = std::abs(thetaList[j] - theta32);
+    if (temp < delta) {
+      delta = temp;
+      laser = j;
+    }
+  }
+
+  return laser;
+}
+
+//----------------------------------------------------------------------------
+
+static int
+laserTheta(pcc::point_t point)
+{
+  int64_t xLidar = int64_t(point[0]) << 8;
+  int64_t yLidar = int64_t(point[1]) << 8;
+  int64_t rInv = irsqrt(xLidar * xLidar + yLidar * yLidar);
+  return (point[2] * rInv) >> 14;
+}
+
+//----------------------------------------------------------------------------
+
+int
+findLaser(pcc::point_t point, const int* thetaList, const int numTheta)
+{
+  return findLaserTheta(laserTheta(point), thetaList, numTheta);
+}
+
+//============================================================================
+
+AngularLaserLut::AngularLaserLut(int numLasers, const int* thetaLaser)
+  : _theta(thetaLaser, thetaLaser + numLasers)
+{
+  _find.init(_theta, findLaserTheta);
+  _closest.init(_theta, findClosestLaserTheta);
+}
+
+//----------------------------------------------------------------------------
+
+int
+AngularLaserLut::find(point_t point) const
+{
+  return _find.lookup(laserTheta(point), _theta);
+}
+
+//----------------------------------------------------------------------------
+
+void
+AngularLaserLut::Table::init(const std::vector<int>& theta, SearchFn search)
+{
+  this->search = search;
+
+  int numTheta = theta.size();
+  if (!numTheta) {
+    thetaMin = thetaMax = 0;
+    laserBelow = laserAbove = 0;
+    return;
+  }
+
+  // The searches only compare an angle with each laser angle and the
+  // distances to pairs of laser angles.  The result may therefore only
+  // change at a laser angle or at the mid point of two laser angles.
+  std::vector<int> candidates;
+  for (int i = 0; i < numTheta; i++) {
+    candidates.push_back(theta[i]);
+    candidates.push_back(theta[i] + 1);
+    for (int j = i + 1; j < numTheta; j++) {
+      int mid = (int64_t(theta[i]) + theta[j]) >> 1;
+      candidates.push_back(mid);
+      candidates.push_back(mid + 1);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(
+    std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  // The result is constant between candidates; keep those where it changes.
+  std::vector<int> bounds;
+  int prevLaser = search(candidates[0] - 1, theta.data(), numTheta);
+  laserBelow = prevLaser;
+  for (int candidate : candidates) {
+    int laserIdx = search(candidate, theta.data(), numTheta);
+    if (laserIdx != prevLaser)
+      bounds.push_back(candidate);
+    prevLaser = laserIdx;
+  }
+  laserAbove = prevLaser;
+
+  if (bounds.empty()) {
+    thetaMin = thetaMax = std::numeric_limits<int>::min();
+    laserBelow = laserAbove;
+    return;
+  }
+
+  thetaMin = bounds.front();
+  thetaMax = bounds.back();
+
+  // quantise the range of angles to at most 2^12 intervals
+  int64_t range = int64_t(thetaMax) - thetaMin;
+  shift = 0;
+  while ((range >> shift) >= (1 << 12))
+    shift++;
+
+  laser.resize((range >> shift) + 1);
+  auto boundIt = bounds.begin();
+  for (int i = 0; i < int(laser.size()); i++) {
+    int64_t first = thetaMin + (int64_t(i) << shift);
+    int64_t last = first + (1 << shift) - 1;
+
+    // the interval maps to a single laser if no boundary lies in (first,last]
+    while (boundIt != bounds.end() && *boundIt <= first)
+      ++boundIt;
+
+    if (boundIt != bounds.end() && *boundIt <= last)
+      laser[i] = kUnresolved;
+    else
+      laser[i] = search(first, theta.data(), numTheta);
+  }
+}
+
+//============================================================================
+
+unsigned
+octreeTools(const GeometryParameterSet& gps)
+{
+  unsigned tools = 0;
+  if (gps.neighbour_avail_boundary_log2)
+    tools |= kOctreeToolNeighAvail;
+  if (gps.geom_planar_mode_enabled_flag)
+    tools |= kOctreeToolPlanar;
+  if (gps.geom_angular_mode_enabled_flag)
+    tools |= kOctreeToolAngular;
+  if (gps.inferred_direct_coding_mode_enabled_flag)
+    tools |= kOctreeToolIdcm;
+  if (gps.geom_scaling_enabled_flag)
+    tools |= kOctreeToolInTreeQuant;
+  return tools;
+}
+
 //============================================================================
 
 }  // namespace pcc
@@ -36,7 +36,9 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
+#include "DualLutCoder.h"
 #include "PCCMath.h"
 #include "PCCPointSet.h"
 #include "entropy.h"
@@ -53,12 +55,14 @@ const int MAX_NUM_DM_LEAF_POINTS = 2;
 
 //============================================================================
 
+// The state of a node that is used by every traversal.
+//
+// NB: state that is only used by some coding tools is held separately
+//     (eg, OctreeNodePlanar) so as to keep the traversal fifo compact.
+
 struct PCCOctree3Node {
   // 3D position of the current node's origin (local x,y,z = 0).
   Vec3<int32_t> pos;
-  // 3D position of the current node's origin (local x,y,z = 0) for decoder
-  // reconstruction with in-tree geometry quantization.
-  Vec3<int32_t> posQ;
 
   // Range of point indexes spanned by node
   uint32_t start;
@@ -84,7 +88,13 @@ struct PCCOctree3Node {
 
   // The qp used for geometry quantisation
   int qp;
+};
+
+//---------------------------------------------------------------------------
+// Planar and angular coding state of a node.  This is only maintained
+// for each node in the tree when either mode is enabled.
 
+struct OctreeNodePlanar {
   // planar; first bit for x, second bit for y, third bit for z
   uint8_t planarPossible = 7;
   uint8_t planePosBits = 0;
@@ -107,6 +117,10 @@ void updateGeometryNeighState(
   uint8_t neighPattern,
   uint8_t parentOccupancy);
 
+//---------------------------------------------------------------------------
+
+class GeometryOctreeContexts;
+
 //---------------------------------------------------------------------------
 // :: octree encoder exposing internal ringbuffer
 
@@ -115,6 +129,7 @@ void encodeGeometryOctree(
   const GeometryParameterSet& gps,
   GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyEncoder>>& arithmeticEncoders,
   pcc::ringbuf<PCCOctree3Node>* nodesRemaining);
 
@@ -123,8 +138,10 @@ void decodeGeometryOctree(
   const GeometryBrickHeader& gbh,
   int minNodeSizeLog2,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoders,
-  pcc::ringbuf<PCCOctree3Node>* nodesRemaining);
+  pcc::ringbuf<PCCOctree3Node>* nodesRemaining,
+  const Box3<int32_t>* roi);
 
 //---------------------------------------------------------------------------
 // Determine if a node is a leaf node based on size.
@@ -227,6 +244,55 @@ CtxMapOctreeOccupancy::evolve(bool bit, uint8_t* ctxIdx)
   return retval;
 }
 
+//============================================================================
+// The adaptive entropy coding contexts of the octree geometry coder.
+//
+// NB: the context state may be carried from the end of one slice to the
+//     start of another (gbh.entropy_continuation_flag).
+
+class GeometryOctreeContexts {
+public:
+  GeometryOctreeContexts();
+
+  // Restore the initial context state
+  void reset();
+
+protected:
+  AdaptiveBitModel _ctxSingleChild;
+  AdaptiveBitModel _ctxSinglePointPerBlock;
+  AdaptiveBitModel _ctxSingleIdcmDupPoint;
+  AdaptiveBitModel _ctxPointCountPerBlock;
+  AdaptiveBitModel _ctxBlockSkipTh;
+  AdaptiveBitModel _ctxNumIdcmPointsGt1;
+  AdaptiveBitModel _ctxQpOffsetIsZero;
+  AdaptiveBitModel _ctxQpOffsetSign;
+  AdaptiveBitModel _ctxQpOffsetAbsEgl;
+
+  // residual laser index
+  AdaptiveBitModel _ctxThetaResIsZero;
+  AdaptiveBitModel _ctxThetaResSign;
+  AdaptiveBitModel _ctxThetaResIsOne;
+  AdaptiveBitModel _ctxThetaResIsTwo;
+  AdaptiveBitModel _ctxThetaResExp;
+
+  // for planar mode xyz
+  AdaptiveBitModel _ctxPlanarMode[3][2][2];
+  AdaptiveBitModel _ctxPlanarPlaneLastIndex[3][2][8][2];
+  AdaptiveBitModel _ctxPlanarPlaneLastIndexZ[3];
+  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngular[4];
+  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularIdcm[4];
+
+  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularPhi[16];
+  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularPhiIDCM[16];
+
+  // For bitwise occupancy coding
+  CtxModelOctreeOccupancy _ctxOccupancy;
+  CtxMapOctreeOccupancy _ctxIdxMaps[18];
+
+  // For bytewise occupancy coding
+  DualLutCoder<true> _bytewiseOccupancyCoder[10];
+};
+
 //---------------------------------------------------------------------------
 // generate an array of node sizes according to subsequent qtbt decisions
 
@@ -358,38 +424,181 @@ struct OctreePlanarState {
   void isEligible(bool eligible[3]);
 };
 
-// determine if a 222 block is planar
+// determine if a 222 block is planar.
+// The points of @node0 are pointCloud[pointIdx[node0.start..node0.end-1]].
 void isPlanarNode(
   const PCCPointSet3& pointCloud,
+  const std::vector<uint32_t>& pointIdx,
   const PCCOctree3Node& node0,
   const Vec3<int>& sizeLog2,
   uint8_t& planarMode,
   uint8_t& planePosBits,
   const bool planarEligible[3]);
 
-int maskPlanarX(const PCCOctree3Node& node0, bool activatable);
-int maskPlanarY(const PCCOctree3Node& node0, bool activatable);
-int maskPlanarZ(const PCCOctree3Node& node0, bool activatable);
+int maskPlanarX(const OctreeNodePlanar& planar, bool activatable);
+int maskPlanarY(const OctreeNodePlanar& planar, bool activatable);
+int maskPlanarZ(const OctreeNodePlanar& planar, bool activatable);
+
+void maskPlanar(
+  OctreeNodePlanar& planar, int mask[3], const int occupancySkip);
+
+//----------------------------------------------------------------------------
+
+int findLaser(point_t point, const int* thetaList, const int numTheta);
+
+//============================================================================
+// Determines the laser associated with an elevation angle, tan(theta),
+// expressed using the same fixed-point representation as the laser angles.
+//
+// A table indexed by quantised angle records the laser for each interval
+// of angles that maps to a single laser.  Angles in intervals that
+// straddle a decision boundary are resolved by searching the laser angles.
+// The results are identical to those of the search.
+
+class AngularLaserLut {
+public:
+  typedef int (*SearchFn)(int theta32, const int* thetaList, int numTheta);
+
+  AngularLaserLut(int numLasers, const int* thetaLaser);
+
+  // The laser index, as determined by findLaser, for a head relative point.
+  int find(point_t point) const;
+
+  // The laser index with the angle closest to @theta32, ties being resolved
+  // to the lowest index.
+  int closest(int theta32) const { return _closest.lookup(theta32, _theta); }
+
+private:
+  struct Table {
+    SearchFn search;
+
+    // The first and last decision boundaries
+    int thetaMin;
+    int thetaMax;
+
+    // The quantisation of an angle (relative to thetaMin) to a table index
+    int shift;
+
+    // Laser indexes for angles below thetaMin or from thetaMax
+    int laserBelow;
+    int laserAbove;
+
+    // Laser index of each interval, or kUnresolved
+    std::vector<uint8_t> laser;
+
+    void init(const std::vector<int>& theta, SearchFn search);
+    int lookup(int theta32, const std::vector<int>& theta) const;
+  };
+
+  static const uint8_t kUnresolved = 0xff;
+
+  std::vector<int> _theta;
+  Table _find;
+  Table _closest;
+};
+
+//----------------------------------------------------------------------------
+
+inline int
+AngularLaserLut::Table::lookup(
+  int theta32, const std::vector<int>& theta) const
+{
+  if (theta32 < thetaMin)
+    return laserBelow;
+
+  if (theta32 >= thetaMax)
+    return laserAbove;
+
+  int laserIdx = laser[(theta32 - thetaMin) >> shift];
+  if (laserIdx != kUnresolved)
+    return laserIdx;
+
+  return search(theta32, theta.data(), theta.size());
+}
+
+//============================================================================
+// The radius and azimuth of the last column of nodes (ie, nodes that
+// differ only in z) for which the angular planar contexts were determined.
+// Siblings in the same column share these.
+
+struct AngularPlanarColumn {
+  bool valid = false;
+
+  // position of the column relative to the head and its half size
+  int posx;
+  int posy;
+  int midx;
+  int midy;
+
+  uint64_t rInv;
+  int phiNode;
+  int phiNode0;
+};
 
-void maskPlanar(PCCOctree3Node& node0, int mask[3], const int occupancySkip);
+//----------------------------------------------------------------------------
 
 int determineContextAngleForPlanar(
-  PCCOctree3Node& child,
+  const PCCOctree3Node& child,
+  OctreeNodePlanar& childPlanar,
   const Vec3<int>& headPos,
   Vec3<int> childSizeLog2,
   const int* zLaser,
   const int* thetaLaser,
-  const int numLasers,
+  const AngularLaserLut& laserLut,
   int deltaAngle,
   const AzimuthalPhiZi& phiZi,
   int* phiBuffer,
+  AngularPlanarColumn* column,
   int* contextAnglePhiX,
   int* contextAnglePhiY);
-;
+
+//============================================================================
+// Coding tools upon which the octree coding loops may be specialised.
+
+enum OctreeTool : unsigned
+{
+  kOctreeToolNeighAvail = 1,
+  kOctreeToolPlanar = 2,
+  kOctreeToolAngular = 4,
+  kOctreeToolIdcm = 8,
+  kOctreeToolInTreeQuant = 16,
+  kOctreeToolsAll = 31,
+};
+
+// Tool combinations that have specialised coding loops.  These correspond
+// to the octree and trisoup common test conditions.
+const unsigned kOctreeToolsCtcOctree =
+  kOctreeToolNeighAvail | kOctreeToolPlanar | kOctreeToolIdcm;
+
+const unsigned kOctreeToolsCtcOctreeAngular =
+  kOctreeToolNeighAvail | kOctreeToolPlanar | kOctreeToolIdcm
+  | kOctreeToolAngular;
+
+const unsigned kOctreeToolsCtcTrisoup =
+  kOctreeToolNeighAvail | kOctreeToolPlanar;
+
+// The set of octree coding tools enabled by @gps.
+unsigned octreeTools(const GeometryParameterSet& gps);
 
 //----------------------------------------------------------------------------
+// Determines if a coding tool is used.  Tools in kFixed are known at
+// compile time to be used if they are present in kEnabled.  The use of
+// any other tool is as indicated at runtime.
 
-int findLaser(point_t point, const int* thetaList, const int numTheta);
+template<unsigned kFixed, unsigned kEnabled>
+struct OctreeToolSet {
+  static bool enabled(OctreeTool tool, bool runtimeEnabled)
+  {
+    return kFixed & tool ? kEnabled & tool : runtimeEnabled;
+  }
+};
+
+// All tools are determined at runtime
+typedef OctreeToolSet<0, 0> OctreeToolsAny;
+
+// All tools are determined at compile time
+template<unsigned kEnabled>
+using OctreeToolsFixed = OctreeToolSet<kOctreeToolsAll, kEnabled>;
 
 //============================================================================
 
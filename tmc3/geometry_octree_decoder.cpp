@@ -47,10 +47,12 @@ namespace pcc {
 
 //============================================================================
 
-class GeometryOctreeDecoder {
+class GeometryOctreeDecoder : protected GeometryOctreeContexts {
 public:
   GeometryOctreeDecoder(
-    const GeometryParameterSet& gps, EntropyDecoder* arithmeticDecoder);
+    const GeometryParameterSet& gps,
+    const GeometryOctreeContexts& ctxtMem,
+    EntropyDecoder* arithmeticDecoder);
 
   GeometryOctreeDecoder(const GeometryOctreeDecoder&) = default;
   GeometryOctreeDecoder(GeometryOctreeDecoder&&) = default;
@@ -114,7 +116,7 @@ public:
   int decodeOccupancyBytewise(int neighPattern);
 
   int decodePlanarMode(
-    PCCOctree3Node& node0,
+    OctreeNodePlanar& planar,
     int planeZ,
     int posz,
     int dist,
@@ -125,7 +127,7 @@ public:
 
   void determinePlanarMode(
     int planeId,
-    PCCOctree3Node& child,
+    OctreeNodePlanar& childPlanar,
     OctreePlanarBuffer::Row* planeBuffer,
     int coord1,
     int coord2,
@@ -138,7 +140,8 @@ public:
 
   void determinePlanarMode(
     const bool planarEligible[3],
-    PCCOctree3Node& child,
+    const PCCOctree3Node& child,
+    OctreeNodePlanar& childPlanar,
     uint8_t neighPattern,
     int x,
     int y,
@@ -171,6 +174,7 @@ public:
     uint8_t planarMode,
     uint8_t planePosBits,
     const PCCOctree3Node& node,
+    const OctreeNodePlanar& planar,
     const Vec3<int>& headPos,
     const int* zLaser,
     const int* thetaLaser,
@@ -182,16 +186,18 @@ public:
   int decodeDirectPosition(
     bool geom_unique_points_flag,
     const Vec3<int>& nodeSizeLog2,
-    PCCOctree3Node& node,
+    const PCCOctree3Node& node,
+    OctreeNodePlanar& planar,
     OutputIt outputPoints,
     bool angularIdcm,
     const Vec3<int>& headPos,
     const int* zLaser,
-    const int* thetaLaser,
-    int numLasers);
+    const int* thetaLaser);
 
   int decodeThetaRes();
 
+  const GeometryOctreeContexts& getCtx() const { return *this; }
+
 public:
   // selects between the bitwise and bytewise occupancy coders
   bool _useBitwiseOccupancyCoder;
@@ -200,39 +206,6 @@ public:
 
   EntropyDecoder* _arithmeticDecoder;
   StaticBitModel _ctxEquiProb;
-  AdaptiveBitModel _ctxSingleChild;
-  AdaptiveBitModel _ctxSinglePointPerBlock;
-  AdaptiveBitModel _ctxSingleIdcmDupPoint;
-  AdaptiveBitModel _ctxPointCountPerBlock;
-  AdaptiveBitModel _ctxBlockSkipTh;
-  AdaptiveBitModel _ctxNumIdcmPointsGt1;
-  AdaptiveBitModel _ctxQpOffsetIsZero;
-  AdaptiveBitModel _ctxQpOffsetSign;
-  AdaptiveBitModel _ctxQpOffsetAbsEgl;
-
-  // residual laser index
-  AdaptiveBitModel _ctxThetaResIsZero;
-  AdaptiveBitModel _ctxThetaResSign;
-  AdaptiveBitModel _ctxThetaResIsOne;
-  AdaptiveBitModel _ctxThetaResIsTwo;
-  AdaptiveBitModel _ctxThetaResExp;
-
-  // for planar mode xyz
-  AdaptiveBitModel _ctxPlanarMode[3][2][2];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndex[3][2][8][2];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexZ[3];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngular[4];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularIdcm[4];
-
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularPhi[16];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularPhiIDCM[16];
-
-  // For bitwise occupancy coding
-  CtxModelOctreeOccupancy _ctxOccupancy;
-  CtxMapOctreeOccupancy _ctxIdxMaps[18];
-
-  // For bytewise occupancy coding
-  DualLutCoder<true> _bytewiseOccupancyCoder[10];
 
   // Planar state
   OctreePlanarState _planar;
@@ -242,25 +215,31 @@ public:
 
   // azimuthal elementary shifts
   AzimuthalPhiZi _phiZi;
+
+  // laser determination
+  AngularLaserLut _laserLut;
+
+  // Column shared by successive angular planar context derivations
+  AngularPlanarColumn _angularColumn;
 };
 
 //============================================================================
 
 GeometryOctreeDecoder::GeometryOctreeDecoder(
-  const GeometryParameterSet& gps, EntropyDecoder* arithmeticDecoder)
-  : _useBitwiseOccupancyCoder(gps.bitwise_occupancy_coding_flag)
+  const GeometryParameterSet& gps,
+  const GeometryOctreeContexts& ctxtMem,
+  EntropyDecoder* arithmeticDecoder)
+  : GeometryOctreeContexts(ctxtMem)
+  , _useBitwiseOccupancyCoder(gps.bitwise_occupancy_coding_flag)
   , _neighPattern64toR1(neighPattern64toR1(gps))
   , _arithmeticDecoder(arithmeticDecoder)
   , _planar(gps)
   , _phiBuffer(gps.geom_angular_num_lidar_lasers(), 0x80000000)
   , _phiZi(
       gps.geom_angular_num_lidar_lasers(), gps.geom_angular_num_phi_per_turn)
-{
-  if (!_useBitwiseOccupancyCoder) {
-    for (int i = 0; i < 10; i++)
-      _bytewiseOccupancyCoder[i].init(kDualLutOccupancyCoderInit[i]);
-  }
-}
+  , _laserLut(
+      gps.geom_angular_num_lidar_lasers(), gps.geom_angular_theta_laser.data())
+{}
 //============================================================================
 
 void
@@ -296,7 +275,7 @@ GeometryOctreeDecoder::decodePositionLeafNumPoints()
 
 int
 GeometryOctreeDecoder::decodePlanarMode(
-  PCCOctree3Node& node0,
+  OctreeNodePlanar& planar,
   int planeZ,
   int posz,
   int dist,
@@ -312,10 +291,10 @@ GeometryOctreeDecoder::decodePlanarMode(
   int discreteDist = (dist <= (2 >> OctreePlanarBuffer::shiftAb) ? 0 : 1);
   bool isPlanar =
     _arithmeticDecoder->decode(_ctxPlanarMode[planeId][neighb][discreteDist]);
-  node0.planarMode |= isPlanar ? mask0 : 0;
+  planar.planarMode |= isPlanar ? mask0 : 0;
 
   if (!isPlanar) {
-    node0.planarPossible &= mask1[planeId];
+    planar.planarPossible &= mask1[planeId];
     return -1;
   }
 
@@ -350,7 +329,7 @@ GeometryOctreeDecoder::decodePlanarMode(
     }
   }
 
-  node0.planePosBits |= (planeBit << planeId);
+  planar.planePosBits |= (planeBit << planeId);
   return planeBit;
 }
 
@@ -359,7 +338,7 @@ GeometryOctreeDecoder::decodePlanarMode(
 void
 GeometryOctreeDecoder::determinePlanarMode(
   int planeId,
-  PCCOctree3Node& child,
+  OctreeNodePlanar& childPlanar,
   OctreePlanarBuffer::Row* planeBuffer,
   int coord1,
   int coord2,
@@ -417,10 +396,10 @@ GeometryOctreeDecoder::determinePlanarMode(
   }
   int adjNeigh = (neighPattern >> kAdjNeighIdxFromPlanePos[planeId][pos]) & 1;
   int planeBit = decodePlanarMode(
-    child, closestPlanarFlag, pos, closestDist, adjNeigh, planarProb[planeId],
-    planeId, contextAngle);
+    childPlanar, closestPlanarFlag, pos, closestDist, adjNeigh,
+    planarProb[planeId], planeId, contextAngle);
 
-  bool isPlanar = (child.planarMode & planeSelector)
+  bool isPlanar = (childPlanar.planarMode & planeSelector)
     && planarProb[planeId] > kPlanarChildThreshold;
 
   planarRate[planeId] =
@@ -436,7 +415,8 @@ GeometryOctreeDecoder::determinePlanarMode(
 void
 GeometryOctreeDecoder::determinePlanarMode(
   const bool planarEligible[3],
-  PCCOctree3Node& child,
+  const PCCOctree3Node& child,
+  OctreeNodePlanar& childPlanar,
   uint8_t neighPattern,
   int x,
   int y,
@@ -455,19 +435,19 @@ GeometryOctreeDecoder::determinePlanarMode(
   // planar x
   if (planarEligible[0]) {
     determinePlanarMode(
-      0, child, planeBuffer.getBuffer(0), yy, zz, xx, neighPattern, x,
+      0, childPlanar, planeBuffer.getBuffer(0), yy, zz, xx, neighPattern, x,
       planarProb, _planar._rate.data(), contextAnglePhiX);
   }
   // planar y
   if (planarEligible[1]) {
     determinePlanarMode(
-      1, child, planeBuffer.getBuffer(1), xx, zz, yy, neighPattern, y,
+      1, childPlanar, planeBuffer.getBuffer(1), xx, zz, yy, neighPattern, y,
       planarProb, _planar._rate.data(), contextAnglePhiY);
   }
   // planar z
   if (planarEligible[2]) {
     determinePlanarMode(
-      2, child, planeBuffer.getBuffer(2), xx, yy, zz, neighPattern, z,
+      2, childPlanar, planeBuffer.getBuffer(2), xx, yy, zz, neighPattern, z,
       planarProb, _planar._rate.data(), contextAngle);
   }
 }
@@ -877,10 +857,8 @@ GeometryOctreeDecoder::decodePointPosition(
     if (nodeSizeLog2[k] <= 0)
       continue;
 
-    for (int i = nodeSizeLog2[k]; i > 0; i--) {
-      delta[k] <<= 1;
-      delta[k] |= _arithmeticDecoder->decode(_ctxEquiProb);
-    }
+    delta[k] <<= nodeSizeLog2[k];
+    delta[k] |= _arithmeticDecoder->decodeBypass(nodeSizeLog2[k]);
   }
 
   return delta;
@@ -910,6 +888,7 @@ GeometryOctreeDecoder::decodePointPositionAngular(
   uint8_t planarMode,
   uint8_t planePosBits,
   const PCCOctree3Node& child,
+  const OctreeNodePlanar& childPlanar,
   const Vec3<int>& headPos,
   const int* zLaser,
   const int* thetaLaser,
@@ -924,26 +903,26 @@ GeometryOctreeDecoder::decodePointPositionAngular(
   // code x or y directly and compute phi of node
   bool codeXorY = std::abs(posXyz[0]) <= std::abs(posXyz[1]);
   if (codeXorY) {  // direct code y
-    if (nodeSizeLog2AfterPlanar[1])
-      for (int i = nodeSizeLog2AfterPlanar[1]; i > 0; i--) {
-        delta[1] <<= 1;
-        delta[1] |= _arithmeticDecoder->decode(_ctxEquiProb);
-      }
+    if (nodeSizeLog2AfterPlanar[1] > 0) {
+      delta[1] <<= nodeSizeLog2AfterPlanar[1];
+      delta[1] |=
+        _arithmeticDecoder->decodeBypass(nodeSizeLog2AfterPlanar[1]);
+    }
     posXyz[1] += delta[1];
     posXyz[0] += delta[0] << nodeSizeLog2AfterPlanar[0];
   } else {  //direct code x
-    if (nodeSizeLog2AfterPlanar[0])
-      for (int i = nodeSizeLog2AfterPlanar[0]; i > 0; i--) {
-        delta[0] <<= 1;
-        delta[0] |= _arithmeticDecoder->decode(_ctxEquiProb);
-      }
+    if (nodeSizeLog2AfterPlanar[0] > 0) {
+      delta[0] <<= nodeSizeLog2AfterPlanar[0];
+      delta[0] |=
+        _arithmeticDecoder->decodeBypass(nodeSizeLog2AfterPlanar[0]);
+    }
     posXyz[0] += delta[0];
     posXyz[1] += delta[1] << nodeSizeLog2AfterPlanar[1];
   }
 
   // find predictor
   int phiNode = iatan2(posXyz[1], posXyz[0]);
-  int laserNode = int(child.laserIndex);
+  int laserNode = int(childPlanar.laserIndex);
 
   // laser residual
   int laserIndex = laserNode + decodeThetaRes();
@@ -1064,13 +1043,13 @@ int
 GeometryOctreeDecoder::decodeDirectPosition(
   bool geom_unique_points_flag,
   const Vec3<int>& nodeSizeLog2,
-  PCCOctree3Node& node,
+  const PCCOctree3Node& node,
+  OctreeNodePlanar& planar,
   OutputIt outputPoints,
   bool angularIdcm,
   const Vec3<int>& headPos,
   const int* zLaser,
-  const int* thetaLaser,
-  int numLasers)
+  const int* thetaLaser)
 {
   bool isDirectMode = _arithmeticDecoder->decode(_ctxBlockSkipTh);
   if (!isDirectMode) {
@@ -1097,26 +1076,31 @@ GeometryOctreeDecoder::decodeDirectPosition(
   Vec3<int32_t> deltaPlanar{0, 0, 0};
   Vec3<int> nodeSizeLog2AfterPlanar = nodeSizeLog2;
   for (int k = 0; k < 3; k++)
-    if (nodeSizeLog2AfterPlanar[k] > 0 && (node.planarMode & (1 << k))) {
-      deltaPlanar[k] |= (node.planePosBits & (1 << k) ? 1 : 0);
+    if (nodeSizeLog2AfterPlanar[k] > 0 && (planar.planarMode & (1 << k))) {
+      deltaPlanar[k] |= (planar.planePosBits & (1 << k) ? 1 : 0);
       nodeSizeLog2AfterPlanar[k]--;
     }
 
+  // laser of the node centre, common to all points
+  if (angularIdcm) {
+    point_t posNodeLidar =
+      point_t(
+        node.pos[0] << nodeSizeLog2[0], node.pos[1] << nodeSizeLog2[1],
+        node.pos[2] << nodeSizeLog2[2])
+      - headPos;
+    posNodeLidar += point_t(
+      (1 << nodeSizeLog2[0]) >> 1, (1 << nodeSizeLog2[1]) >> 1,
+      (1 << nodeSizeLog2[2]) >> 1);
+    planar.laserIndex = _laserLut.find(posNodeLidar);
+  }
+
   Vec3<int32_t> pos;
   for (int i = 0; i < numPoints; i++) {
     if (angularIdcm) {
-      point_t posNodeLidar =
-        point_t(
-          node.pos[0] << nodeSizeLog2[0], node.pos[1] << nodeSizeLog2[1],
-          node.pos[2] << nodeSizeLog2[2])
-        - headPos;
-      posNodeLidar += point_t(
-        (1 << nodeSizeLog2[0]) >> 1, (1 << nodeSizeLog2[1]) >> 1,
-        (1 << nodeSizeLog2[2]) >> 1);
-      node.laserIndex = findLaser(posNodeLidar, thetaLaser, numLasers);
       *(outputPoints++) = pos = decodePointPositionAngular(
-        nodeSizeLog2, nodeSizeLog2AfterPlanar, node.planarMode,
-        node.planePosBits, node, headPos, zLaser, thetaLaser, deltaPlanar);
+        nodeSizeLog2, nodeSizeLog2AfterPlanar, planar.planarMode,
+        planar.planePosBits, node, planar, headPos, zLaser, thetaLaser,
+        deltaPlanar);
     } else
       *(outputPoints++) = pos =
         decodePointPosition(nodeSizeLog2AfterPlanar, deltaPlanar);
@@ -1175,20 +1159,41 @@ invQuantPosition(int qp, Vec3<uint32_t> quantMasks, const Vec3<int32_t>& pos)
 }
 
 //-------------------------------------------------------------------------
+// NB: the octree coding loop is specialised upon the set of coding @Tools.
 
-void
+template<typename Tools>
+static void
 decodeGeometryOctree(
+  Tools,
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   int minNodeSizeLog2,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoders,
-  pcc::ringbuf<PCCOctree3Node>* nodesRemaining)
+  pcc::ringbuf<PCCOctree3Node>* nodesRemaining,
+  const Box3<int32_t>* roi)
 {
+  // the coding tools in use
+  // NB: these are compile time constants in specialised instances
+  const bool useNeighAvail =
+    Tools::enabled(kOctreeToolNeighAvail, gps.neighbour_avail_boundary_log2);
+  const bool usePlanar =
+    Tools::enabled(kOctreeToolPlanar, gps.geom_planar_mode_enabled_flag);
+  const bool useAngular =
+    Tools::enabled(kOctreeToolAngular, gps.geom_angular_mode_enabled_flag);
+  const bool useIdcm = Tools::enabled(
+    kOctreeToolIdcm, gps.inferred_direct_coding_mode_enabled_flag);
+  const bool useInTreeQuant =
+    Tools::enabled(kOctreeToolInTreeQuant, gps.geom_scaling_enabled_flag);
+
   // init main fifo
+  //  -- the fifo is grown at the start of each level to hold the level
+  //     and all of its (at most eight per node) children.
   //  -- worst case size is the last level containing every input poit
   //     and each point being isolated in the previous level.
-  pcc::ringbuf<PCCOctree3Node> fifo(gbh.footer.geom_num_points_minus1 + 2);
+  pcc::ringbuf<PCCOctree3Node> fifo(1);
+  size_t maxFifoSize = gbh.footer.geom_num_points_minus1 + 2;
 
   // push the first node
   fifo.emplace_back();
@@ -1196,17 +1201,29 @@ decodeGeometryOctree(
   node00.start = uint32_t(0);
   node00.end = uint32_t(0);
   node00.pos = int32_t(0);
-  node00.posQ = int32_t(0);
   node00.neighPattern = 0;
   node00.numSiblingsPlus1 = 8;
   node00.siblingOccupancy = 0;
   node00.qp = 0;
-  node00.planarMode = 0;
+
+  // planar and angular state of the nodes in the current and next levels,
+  // indexed by the node's order in its level.
+  //  -- only maintained if either mode is enabled.
+  const bool usePlanarState = usePlanar || useAngular;
+  std::vector<OctreeNodePlanar> planarLvl(usePlanarState ? 1 : 0);
+  std::vector<OctreeNodePlanar> planarNextLvl;
+
+  // node positions for reconstruction with in-tree geometry quantisation,
+  // indexed by the node's order in its level.
+  //  -- only maintained if in-tree quantisation is enabled, otherwise
+  //     the node position is used.
+  std::vector<Vec3<int32_t>> posQLvl(useInTreeQuant ? 1 : 0, int32_t(0));
+  std::vector<Vec3<int32_t>> posQNextLvl;
 
   size_t processedPointCount = 0;
   std::vector<uint32_t> values;
 
-  const int idcmThreshold = gps.geom_planar_mode_enabled_flag
+  const int idcmThreshold = usePlanar
     ? gps.geom_planar_idcm_threshold * 127 * 127
     : 127 * 127 * 127;
 
@@ -1228,7 +1245,7 @@ decodeGeometryOctree(
   }
 
   MortonMap3D occupancyAtlas;
-  if (gps.neighbour_avail_boundary_log2) {
+  if (useNeighAvail) {
     occupancyAtlas.resize(gps.neighbour_avail_boundary_log2);
     occupancyAtlas.clear();
   }
@@ -1237,7 +1254,7 @@ decodeGeometryOctree(
   int idcmQp = 0;
   int sliceQp = gps.geom_base_qp + gbh.geom_slice_qp_offset;
   int numLvlsUntilQpOffset = 0;
-  if (gps.geom_scaling_enabled_flag)
+  if (useInTreeQuant)
     numLvlsUntilQpOffset = gbh.geom_octree_qp_offset_depth + 1;
 
   // generate the list of the node size for each level in the tree
@@ -1265,13 +1282,18 @@ decodeGeometryOctree(
   // NB: this needs to be after the root node size is determined to
   //     allocate the planar buffer
   auto arithmeticDecoderIt = arithmeticDecoders.begin();
-  GeometryOctreeDecoder decoder(gps, arithmeticDecoderIt->get());
+  GeometryOctreeDecoder decoder(gps, ctxtMem, arithmeticDecoderIt->get());
 
   // saved state for use with parallel bistream coding.
   // the saved state is restored at the start of each parallel octree level
   std::unique_ptr<GeometryOctreeDecoder> savedState;
 
   for (int depth = 0; depth < maxDepth; depth++) {
+    // size the fifo to hold the current level and all of its children
+    fifo.reserve(std::min(9 * fifo.size(), maxFifoSize));
+    planarNextLvl.clear();
+    posQNextLvl.clear();
+
     // setup at the start of each level
     auto fifoCurrLvlEnd = fifo.end();
     int numNodesNextLvl = 0;
@@ -1297,7 +1319,7 @@ decodeGeometryOctree(
       // If planar is enabled, the planar bits are not quantised (since
       // the planar mode is determined before quantisation)
       auto quantNodeSizeLog2 = childSizeLog2;
-      if (gps.geom_planar_mode_enabled_flag)
+      if (usePlanar)
         quantNodeSizeLog2 -= 1;
 
       for (int k = 0; k < 3; k++)
@@ -1337,13 +1359,22 @@ decodeGeometryOctree(
     decoder.beginOctreeLevel(planarDepth);
 
     // process all nodes within a single level
-    for (; fifo.begin() != fifoCurrLvlEnd; fifo.pop_front()) {
+    for (int nodeIdx = 0; fifo.begin() != fifoCurrLvlEnd;
+         fifo.pop_front(), nodeIdx++) {
       PCCOctree3Node& node0 = fifo.front();
 
-      if (numLvlsUntilQpOffset == 0)
+      // planar state of node0, or the initial state if not maintained
+      OctreeNodePlanar planarDefault;
+      OctreeNodePlanar& planar0 =
+        usePlanarState ? planarLvl[nodeIdx] : planarDefault;
+
+      const Vec3<int32_t>& posQ0 =
+        useInTreeQuant ? posQLvl[nodeIdx] : node0.pos;
+
+      if (useInTreeQuant && numLvlsUntilQpOffset == 0)
         node0.qp = decoder.decodeQpOffset() + sliceQp;
 
-      int shiftBits = node0.qp >> 2;
+      int shiftBits = useInTreeQuant ? node0.qp >> 2 : 0;
       auto effectiveNodeSizeLog2 = nodeSizeLog2 - shiftBits;
       auto effectiveChildSizeLog2 = childSizeLog2 - shiftBits;
 
@@ -1363,9 +1394,9 @@ decodeGeometryOctree(
       int occupancyAdjacencyGt1 = 0;
       int occupancyAdjacencyUnocc = 0;
 
-      if (gps.neighbour_avail_boundary_log2) {
+      if (useNeighAvail) {
         updateGeometryOccupancyAtlas(
-          node0.pos, atlasShift, fifo, fifoCurrLvlEnd, &occupancyAtlas,
+          node0.pos, atlasShift, fifo.begin(), fifoCurrLvlEnd, &occupancyAtlas,
           &occupancyAtlasOrigin);
 
         GeometryNeighPattern gnp = makeGeometryNeighPattern(
@@ -1396,20 +1427,20 @@ decodeGeometryOctree(
         // mask to be used for the occupancy coding
         // (bit =1 => occupancy bit not coded due to not belonging to the plane)
         int mask_planar[3] = {0, 0, 0};
-        maskPlanar(node0, mask_planar, occupancySkip);
+        maskPlanar(planar0, mask_planar, occupancySkip);
 
         occupancy = decoder.decodeOccupancy(
           node0.neighPattern, occupancyIsPredicted, occupancyPrediction,
           occupancyAdjacencyGt0, occupancyAdjacencyGt1,
           occupancyAdjacencyUnocc, mask_planar[0], mask_planar[1],
-          mask_planar[2], node0.planarPossible & 1, node0.planarPossible & 2,
-          node0.planarPossible & 4);
+          mask_planar[2], planar0.planarPossible & 1,
+          planar0.planarPossible & 2, planar0.planarPossible & 4);
       }
 
       assert(occupancy > 0);
 
       // update atlas for advanced neighbours
-      if (gps.neighbour_avail_boundary_log2) {
+      if (useNeighAvail) {
         updateGeometryOccupancyAtlasOccChild(
           node0.pos, occupancy, &occupancyAtlas);
       }
@@ -1419,7 +1450,7 @@ decodeGeometryOctree(
 
       // planar eligibility
       bool planarEligible[3] = {false, false, false};
-      if (gps.geom_planar_mode_enabled_flag) {
+      if (usePlanar) {
         // update the plane rate depending on the occupancy and local density
         decoder._planar.updateRate(occupancy, numOccupied);
         decoder._planar.isEligible(planarEligible);
@@ -1431,7 +1462,7 @@ decodeGeometryOctree(
           planarEligible[2] = false;
 
         // avoid mismatch when the next level will apply quantization
-        if (numLvlsUntilQpOffset == 1) {
+        if (useInTreeQuant && numLvlsUntilQpOffset == 1) {
           planarEligible[0] = false;
           planarEligible[1] = false;
           planarEligible[2] = false;
@@ -1463,12 +1494,16 @@ decodeGeometryOctree(
           }
 
           // the final bits from the leaf:
-          Vec3<int32_t> point{(node0.posQ[0] << !(occupancySkip & 4)) + x,
-                              (node0.posQ[1] << !(occupancySkip & 2)) + y,
-                              (node0.posQ[2] << !(occupancySkip & 1)) + z};
+          Vec3<int32_t> point{(posQ0[0] << !(occupancySkip & 4)) + x,
+                              (posQ0[1] << !(occupancySkip & 2)) + y,
+                              (posQ0[2] << !(occupancySkip & 1)) + z};
 
           point = invQuantPosition(node0.qp, posQuantBitMasks, point);
 
+          // points outside the region of interest are not output
+          if (roi && !roi->contains(point))
+            continue;
+
           for (int i = 0; i < numPoints; ++i)
             pointCloud[processedPointCount++] = point;
 
@@ -1480,27 +1515,36 @@ decodeGeometryOctree(
         fifo.emplace_back();
         auto& child = fifo.back();
 
+        OctreeNodePlanar childPlanarDefault;
+        if (usePlanarState)
+          planarNextLvl.emplace_back();
+        OctreeNodePlanar& childPlanar =
+          usePlanarState ? planarNextLvl.back() : childPlanarDefault;
+
         child.qp = node0.qp;
         // only shift position if an occupancy bit was coded for the axis
         child.pos[0] = (node0.pos[0] << !(occupancySkipLevel & 4)) + x;
         child.pos[1] = (node0.pos[1] << !(occupancySkipLevel & 2)) + y;
         child.pos[2] = (node0.pos[2] << !(occupancySkipLevel & 1)) + z;
-        child.posQ[0] = (node0.posQ[0] << !(occupancySkip & 4)) + x;
-        child.posQ[1] = (node0.posQ[1] << !(occupancySkip & 2)) + y;
-        child.posQ[2] = (node0.posQ[2] << !(occupancySkip & 1)) + z;
         child.numSiblingsPlus1 = numOccupied;
         child.siblingOccupancy = occupancy;
-        child.laserIndex = node0.laserIndex;
+        childPlanar.laserIndex = planar0.laserIndex;
+
+        Vec3<int32_t> childPosQ;
+        childPosQ[0] = (posQ0[0] << !(occupancySkip & 4)) + x;
+        childPosQ[1] = (posQ0[1] << !(occupancySkip & 2)) + y;
+        childPosQ[2] = (posQ0[2] << !(occupancySkip & 1)) + z;
+        if (useInTreeQuant)
+          posQNextLvl.push_back(childPosQ);
 
         int contextAngle = -1;
         int contextAnglePhiX = -1;
         int contextAnglePhiY = -1;
-        if (
-          gps.geom_angular_mode_enabled_flag
-          && gps.geom_planar_mode_enabled_flag) {
+        if (useAngular && usePlanar) {
           contextAngle = determineContextAngleForPlanar(
-            child, headPos, childSizeLog2, zLaser, thetaLaser, numLasers,
-            deltaAngle, decoder._phiZi, decoder._phiBuffer.data(),
+            child, childPlanar, headPos, childSizeLog2, zLaser, thetaLaser,
+            decoder._laserLut, deltaAngle, decoder._phiZi,
+            decoder._phiBuffer.data(), &decoder._angularColumn,
             &contextAnglePhiX, &contextAnglePhiY);
 
           if (contextAngle != -1)
@@ -1513,10 +1557,10 @@ decodeGeometryOctree(
         int planarProb[3] = {127, 127, 127};
         if (planarEligible[0] || planarEligible[1] || planarEligible[2])
           decoder.determinePlanarMode(
-            planarEligible, child, node0.neighPattern, x, y, z, planarProb,
-            contextAngle, contextAnglePhiX, contextAnglePhiY);
+            planarEligible, child, childPlanar, node0.neighPattern, x, y, z,
+            planarProb, contextAngle, contextAnglePhiX, contextAnglePhiY);
 
-        bool idcmEnabled = gps.inferred_direct_coding_mode_enabled_flag
+        bool idcmEnabled = useIdcm
           && planarProb[0] * planarProb[1] * planarProb[2] <= idcmThreshold;
 
         if (isDirectModeEligible(idcmEnabled, nodeMaxDimLog2, node0, child)) {
@@ -1526,28 +1570,35 @@ decodeGeometryOctree(
             idcmSize = childSizeLog2 - idcmShiftBits;
           }
 
+          auto* idcmPoints = &pointCloud[processedPointCount];
           int numPoints = decoder.decodeDirectPosition(
-            gps.geom_unique_points_flag, idcmSize, child,
-            &pointCloud[processedPointCount],
-            gps.geom_angular_mode_enabled_flag, headPos, zLaser, thetaLaser,
-            numLasers);
+            gps.geom_unique_points_flag, idcmSize, child, childPlanar,
+            idcmPoints, useAngular, headPos, zLaser, thetaLaser);
 
           if (numPoints && idcmQp)
             child.qp = idcmQp;
 
+          // NB: points outside the region of interest are not output.
+          //     The output position never exceeds that being read.
           for (int j = 0; j < numPoints; j++) {
-            auto& point = pointCloud[processedPointCount++];
+            auto point = idcmPoints[j];
             for (int k = 0; k < 3; k++) {
               int shift = std::max(0, idcmSize[k]);
-              point[k] += child.posQ[k] << shift;
+              point[k] += childPosQ[k] << shift;
             }
 
             point = invQuantPosition(child.qp, posQuantBitMasks, point);
+            if (!roi || roi->contains(point))
+              pointCloud[processedPointCount++] = point;
           }
 
           if (numPoints > 0) {
             // node fully decoded, do not split: discard child
             fifo.pop_back();
+            if (usePlanarState)
+              planarNextLvl.pop_back();
+            if (useInTreeQuant)
+              posQNextLvl.pop_back();
 
             // NB: no further siblings to decode by definition of IDCM
             assert(child.numSiblingsPlus1 == 1);
@@ -1557,15 +1608,21 @@ decodeGeometryOctree(
 
         numNodesNextLvl++;
 
-        if (!gps.neighbour_avail_boundary_log2) {
+        if (!useNeighAvail) {
           updateGeometryNeighState(
             gps.neighbour_context_restriction_flag, fifo.end(),
             numNodesNextLvl, child, i, node0.neighPattern, occupancy);
         }
       }
     }
+
+    std::swap(planarLvl, planarNextLvl);
+    std::swap(posQLvl, posQNextLvl);
   }
 
+  // save the context state for possible use by a later slice
+  ctxtMem = decoder.getCtx();
+
   // NB: the point cloud needs to be resized if partially decoded
   // OR: if geometry quantisation has changed the number of points
   pointCloud.resize(processedPointCount);
@@ -1591,10 +1648,53 @@ void
 decodeGeometryOctree(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
+  int minNodeSizeLog2,
   PCCPointSet3& pointCloud,
-  std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoders)
+  GeometryOctreeContexts& ctxtMem,
+  std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoders,
+  pcc::ringbuf<PCCOctree3Node>* nodesRemaining,
+  const Box3<int32_t>* roi)
 {
-  decodeGeometryOctree(gps, gbh, 0, pointCloud, arithmeticDecoders, nullptr);
+  switch (octreeTools(gps)) {
+  case kOctreeToolsCtcOctree:
+    decodeGeometryOctree(
+      OctreeToolsFixed<kOctreeToolsCtcOctree>(), gps, gbh, minNodeSizeLog2,
+      pointCloud, ctxtMem, arithmeticDecoders, nodesRemaining, roi);
+    break;
+
+  case kOctreeToolsCtcOctreeAngular:
+    decodeGeometryOctree(
+      OctreeToolsFixed<kOctreeToolsCtcOctreeAngular>(), gps, gbh,
+      minNodeSizeLog2, pointCloud, ctxtMem, arithmeticDecoders,
+      nodesRemaining, roi);
+    break;
+
+  case kOctreeToolsCtcTrisoup:
+    decodeGeometryOctree(
+      OctreeToolsFixed<kOctreeToolsCtcTrisoup>(), gps, gbh, minNodeSizeLog2,
+      pointCloud, ctxtMem, arithmeticDecoders, nodesRemaining, roi);
+    break;
+
+  default:
+    decodeGeometryOctree(
+      OctreeToolsAny(), gps, gbh, minNodeSizeLog2, pointCloud, ctxtMem,
+      arithmeticDecoders, nodesRemaining, roi);
+  }
+}
+
+//-------------------------------------------------------------------------
+
+void
+decodeGeometryOctree(
+  const GeometryParameterSet& gps,
+  const GeometryBrickHeader& gbh,
+  PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
+  std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoders,
+  const Box3<int32_t>* roi)
+{
+  decodeGeometryOctree(
+    gps, gbh, 0, pointCloud, ctxtMem, arithmeticDecoders, nullptr, roi);
 }
 
 //-------------------------------------------------------------------------
@@ -1605,11 +1705,13 @@ decodeGeometryOctreeScalable(
   const GeometryBrickHeader& gbh,
   int minGeomNodeSizeLog2,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoders)
 {
   pcc::ringbuf<PCCOctree3Node> nodes;
   decodeGeometryOctree(
-    gps, gbh, minGeomNodeSizeLog2, pointCloud, arithmeticDecoders, &nodes);
+    gps, gbh, minGeomNodeSizeLog2, pointCloud, ctxtMem, arithmeticDecoders,
+    &nodes, nullptr);
 
   if (minGeomNodeSizeLog2 > 0) {
     size_t size =
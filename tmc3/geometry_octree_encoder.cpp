@@ -40,9 +40,12 @@
 #include "geometry_octree.h"
 #include "geometry_intra_pred.h"
 #include "io_hls.h"
+#include "parallel.h"
 #include "tables.h"
 #include "quantization.h"
 
+#include <algorithm>
+#include <numeric>
 #include <set>
 
 namespace pcc {
@@ -56,10 +59,12 @@ enum class DirectMode
   kTwoPoints
 };
 
-class GeometryOctreeEncoder {
+class GeometryOctreeEncoder : protected GeometryOctreeContexts {
 public:
   GeometryOctreeEncoder(
-    const GeometryParameterSet& gps, EntropyEncoder* arithmeticEncoder);
+    const GeometryParameterSet& gps,
+    const GeometryOctreeContexts& ctxtMem,
+    EntropyEncoder* arithmeticEncoder);
 
   GeometryOctreeEncoder(const GeometryOctreeEncoder&) = default;
   GeometryOctreeEncoder(GeometryOctreeEncoder&&) = default;
@@ -71,7 +76,7 @@ public:
   int encodePositionLeafNumPoints(int count);
 
   int encodePlanarMode(
-    PCCOctree3Node& node0,
+    OctreeNodePlanar& planar,
     int plane,
     int posxyz,
     int dist,
@@ -82,7 +87,7 @@ public:
 
   void determinePlanarMode(
     int planeId,
-    PCCOctree3Node& child,
+    OctreeNodePlanar& childPlanar,
     uint8_t planarMode,
     uint8_t planePosBits,
     OctreePlanarBuffer::Row* planeBuffer,
@@ -96,10 +101,11 @@ public:
     int contextAngle);
 
   void determinePlanarMode(
-    PCCPointSet3& pointCloud,
+    uint8_t planarMode,
+    uint8_t planePosBits,
     const bool planarEligible[3],
-    const Vec3<int>& childSizeLog2,
-    PCCOctree3Node& child,
+    const PCCOctree3Node& child,
+    OctreeNodePlanar& childPlanar,
     uint8_t neighPattern,
     int x,
     int y,
@@ -188,10 +194,10 @@ public:
     const Vec3<int32_t>& pos,
     uint8_t planarMode,
     const PCCOctree3Node& node,
+    const OctreeNodePlanar& planar,
     const Vec3<int>& headPos,
     const int* zLaser,
-    const int* thetaLaser,
-    int numLasers);
+    const int* thetaLaser);
 
   void encodeQpOffset(int dqp);
 
@@ -200,16 +206,19 @@ public:
     bool geom_unique_points_flag,
     const Vec3<int>& nodeSizeLog2,
     int shiftBits,
-    PCCOctree3Node& node,
-    PCCPointSet3& pointCloud,
+    const PCCOctree3Node& node,
+    OctreeNodePlanar& planar,
+    const PCCPointSet3& pointCloud,
+    const std::vector<uint32_t>& pointIdx,
     bool angularIdcm,
     const Vec3<int>& headPos,
     const int* zLaser,
-    const int* thetaLaser,
-    int numLasers);
+    const int* thetaLaser);
 
   void encodeThetaRes(int ThetaRes);
 
+  const GeometryOctreeContexts& getCtx() const { return *this; }
+
 public:
   // selects between the bitwise and bytewise occupancy coders
   bool _useBitwiseOccupancyCoder;
@@ -218,40 +227,6 @@ public:
 
   EntropyEncoder* _arithmeticEncoder;
   StaticBitModel _ctxEquiProb;
-  AdaptiveBitModel _ctxSingleChild;
-  AdaptiveBitModel _ctxSinglePointPerBlock;
-  AdaptiveBitModel _ctxSingleIdcmDupPoint;
-  AdaptiveBitModel _ctxPointCountPerBlock;
-  AdaptiveBitModel _ctxBlockSkipTh;
-  AdaptiveBitModel _ctxNumIdcmPointsGt1;
-
-  // residual laser index
-  AdaptiveBitModel _ctxThetaResIsZero;
-  AdaptiveBitModel _ctxThetaSign;
-  AdaptiveBitModel _ctxThetaResIsOne;
-  AdaptiveBitModel _ctxThetaResIsTwo;
-  AdaptiveBitModel _ctxThetaResExp;
-
-  AdaptiveBitModel _ctxQpOffsetIsZero;
-  AdaptiveBitModel _ctxQpOffsetSign;
-  AdaptiveBitModel _ctxQpOffsetAbsEgl;
-
-  // for planar mode xyz
-  AdaptiveBitModel _ctxPlanarMode[3][2][2];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndex[3][2][6][2];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexZ[3];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngular[4];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularIdcm[4];
-
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularPhi[16];
-  AdaptiveBitModel _ctxPlanarPlaneLastIndexAngularPhiIDCM[16];
-
-  // For bitwise occupancy coding
-  CtxModelOctreeOccupancy _ctxOccupancy;
-  CtxMapOctreeOccupancy _ctxIdxMaps[18];
-
-  // For bytewise occupancy coding
-  DualLutCoder<true> _bytewiseOccupancyCoder[10];
 
   // Planar state
   OctreePlanarState _planar;
@@ -261,25 +236,31 @@ public:
 
   // azimuthal elementary shifts
   AzimuthalPhiZi _phiZi;
+
+  // laser determination
+  AngularLaserLut _laserLut;
+
+  // Column shared by successive angular planar context derivations
+  AngularPlanarColumn _angularColumn;
 };
 
 //============================================================================
 
 GeometryOctreeEncoder::GeometryOctreeEncoder(
-  const GeometryParameterSet& gps, EntropyEncoder* arithmeticEncoder)
-  : _useBitwiseOccupancyCoder(gps.bitwise_occupancy_coding_flag)
+  const GeometryParameterSet& gps,
+  const GeometryOctreeContexts& ctxtMem,
+  EntropyEncoder* arithmeticEncoder)
+  : GeometryOctreeContexts(ctxtMem)
+  , _useBitwiseOccupancyCoder(gps.bitwise_occupancy_coding_flag)
   , _neighPattern64toR1(neighPattern64toR1(gps))
   , _arithmeticEncoder(arithmeticEncoder)
   , _planar(gps)
   , _phiBuffer(gps.geom_angular_num_lidar_lasers(), 0x80000000)
   , _phiZi(
       gps.geom_angular_num_lidar_lasers(), gps.geom_angular_num_phi_per_turn)
-{
-  if (!_useBitwiseOccupancyCoder) {
-    for (int i = 0; i < 10; i++)
-      _bytewiseOccupancyCoder[i].init(kDualLutOccupancyCoderInit[i]);
-  }
-}
+  , _laserLut(
+      gps.geom_angular_num_lidar_lasers(), gps.geom_angular_theta_laser.data())
+{}
 
 //============================================================================
 
@@ -314,7 +295,7 @@ GeometryOctreeEncoder::encodePositionLeafNumPoints(int count)
 
 int
 GeometryOctreeEncoder::encodePlanarMode(
-  PCCOctree3Node& node0,
+  OctreeNodePlanar& planar,
   int plane,
   int posxyz,
   int dist,
@@ -326,15 +307,15 @@ GeometryOctreeEncoder::encodePlanarMode(
   const int mask0 = (1 << planeId);
   const int mask1[3] = {6, 5, 3};
 
-  bool isPlanar = node0.planarMode & mask0;
-  int planeBit = (node0.planePosBits & mask0) == 0 ? 0 : 1;
+  bool isPlanar = planar.planarMode & mask0;
+  int planeBit = (planar.planePosBits & mask0) == 0 ? 0 : 1;
 
   int discreteDist = (dist <= (2 >> OctreePlanarBuffer::shiftAb) ? 0 : 1);
   _arithmeticEncoder->encode(
     isPlanar, _ctxPlanarMode[planeId][neighb][discreteDist]);
 
   if (!isPlanar) {
-    node0.planarPossible &= mask1[planeId];
+    planar.planarPossible &= mask1[planeId];
     return -1;
   }
 
@@ -376,7 +357,7 @@ GeometryOctreeEncoder::encodePlanarMode(
 void
 GeometryOctreeEncoder::determinePlanarMode(
   int planeId,
-  PCCOctree3Node& child,
+  OctreeNodePlanar& childPlanar,
   uint8_t planarMode,
   uint8_t planePosBits,
   OctreePlanarBuffer::Row* planeBuffer,
@@ -393,8 +374,8 @@ GeometryOctreeEncoder::determinePlanarMode(
   const int kAdjNeighIdxFromPlanePos[3][2] = {1, 0, 2, 3, 4, 5};
   const int planeSelector = 1 << planeId;
 
-  child.planarMode |= planarMode & planeSelector;
-  child.planePosBits |= planePosBits & planeSelector;
+  childPlanar.planarMode |= planarMode & planeSelector;
+  childPlanar.planePosBits |= planePosBits & planeSelector;
 
   OctreePlanarBuffer::Elmt* row;
   int rowLen = OctreePlanarBuffer::rowSize;
@@ -439,10 +420,10 @@ GeometryOctreeEncoder::determinePlanarMode(
   }
   int adjNeigh = (neighPattern >> kAdjNeighIdxFromPlanePos[planeId][pos]) & 1;
   int planeBit = encodePlanarMode(
-    child, closestPlanarFlag, pos, closestDist, adjNeigh, planarProb[planeId],
-    planeId, contextAngle);
+    childPlanar, closestPlanarFlag, pos, closestDist, adjNeigh,
+    planarProb[planeId], planeId, contextAngle);
 
-  bool isPlanar = (child.planarMode & planeSelector)
+  bool isPlanar = (childPlanar.planarMode & planeSelector)
     && planarProb[planeId] > kPlanarChildThreshold;
 
   planarRate[planeId] =
@@ -454,14 +435,15 @@ GeometryOctreeEncoder::determinePlanarMode(
 }
 
 //============================================================================
-// determine Planar mode for all directions
+// determine Planar mode for all directions, given the planarity of child
 
 void
 GeometryOctreeEncoder::determinePlanarMode(
-  PCCPointSet3& pointCloud,
+  uint8_t planarMode,
+  uint8_t planePosBits,
   const bool planarEligible[3],
-  const Vec3<int>& childSizeLog2,
-  PCCOctree3Node& child,
+  const PCCOctree3Node& child,
+  OctreeNodePlanar& childPlanar,
   uint8_t neighPattern,
   int x,
   int y,
@@ -473,12 +455,6 @@ GeometryOctreeEncoder::determinePlanarMode(
 {
   auto& planeBuffer = _planar._planarBuffer;
 
-  // planarity
-  uint8_t planarMode, planePosBits;
-  isPlanarNode(
-    pointCloud, child, childSizeLog2 - 1, planarMode, planePosBits,
-    planarEligible);
-
   int xx = child.pos[0];
   int yy = child.pos[1];
   int zz = child.pos[2];
@@ -486,20 +462,23 @@ GeometryOctreeEncoder::determinePlanarMode(
   // planar x
   if (planarEligible[0]) {
     determinePlanarMode(
-      0, child, planarMode, planePosBits, planeBuffer.getBuffer(0), yy, zz, xx,
-      neighPattern, x, planarProb, _planar._rate.data(), contextAnglePhiX);
+      0, childPlanar, planarMode, planePosBits, planeBuffer.getBuffer(0),
+      yy, zz, xx, neighPattern, x, planarProb, _planar._rate.data(),
+      contextAnglePhiX);
   }
   // planar y
   if (planarEligible[1]) {
     determinePlanarMode(
-      1, child, planarMode, planePosBits, planeBuffer.getBuffer(1), xx, zz, yy,
-      neighPattern, y, planarProb, _planar._rate.data(), contextAnglePhiY);
+      1, childPlanar, planarMode, planePosBits, planeBuffer.getBuffer(1),
+      xx, zz, yy, neighPattern, y, planarProb, _planar._rate.data(),
+      contextAnglePhiY);
   }
   // planar z
   if (planarEligible[2]) {
     determinePlanarMode(
-      2, child, planarMode, planePosBits, planeBuffer.getBuffer(2), xx, yy, zz,
-      neighPattern, z, planarProb, _planar._rate.data(), contextAngle);
+      2, childPlanar, planarMode, planePosBits, planeBuffer.getBuffer(2),
+      xx, yy, zz, neighPattern, z, planarProb, _planar._rate.data(),
+      contextAngle);
   }
 }
 
@@ -871,9 +850,7 @@ GeometryOctreeEncoder::encodePointPosition(
     if (nodeSizeLog2AfterPlanar[k] <= 0)
       continue;
 
-    for (int mask = 1 << (nodeSizeLog2AfterPlanar[k] - 1); mask; mask >>= 1) {
-      _arithmeticEncoder->encode(!!(pos[k] & mask), _ctxEquiProb);
-    }
+    _arithmeticEncoder->encodeBypass(pos[k], nodeSizeLog2AfterPlanar[k]);
   }
 }
 
@@ -887,10 +864,10 @@ GeometryOctreeEncoder::encodePointPositionAngular(
   const Vec3<int32_t>& pos,
   uint8_t planarMode,
   const PCCOctree3Node& child,
+  const OctreeNodePlanar& childPlanar,
   const Vec3<int>& headPos,
   const int* zLaser,
-  const int* thetaLaser,
-  int numLasers)
+  const int* thetaLaser)
 {
   Vec3<int> posXyz = {(child.pos[0] << nodeSizeLog2[0]) - headPos[0],
                       (child.pos[1] << nodeSizeLog2[1]) - headPos[1],
@@ -900,23 +877,19 @@ GeometryOctreeEncoder::encodePointPositionAngular(
   // code x or y directly and compute phi of node
   bool codeXorY = std::abs(posXyz[0]) <= std::abs(posXyz[1]);
   if (codeXorY) {  // direct code y
-    if (nodeSizeLog2AfterPlanar[1])
-      for (int mask = 1 << (nodeSizeLog2AfterPlanar[1] - 1); mask; mask >>= 1)
-        _arithmeticEncoder->encode(!!(pos[1] & mask), _ctxEquiProb);
+    _arithmeticEncoder->encodeBypass(pos[1], nodeSizeLog2AfterPlanar[1]);
 
     posXyz[1] = pos[1] - headPos[1];
-    if (child.planarMode & 1) {
+    if (childPlanar.planarMode & 1) {
       int mask = 1 << (nodeSizeLog2[0] - 1);
       if (pos[0] & mask)
         posXyz[0] += mask;
     }
   } else {  //direct code x
-    if (nodeSizeLog2AfterPlanar[0])
-      for (int mask = 1 << (nodeSizeLog2AfterPlanar[0] - 1); mask; mask >>= 1)
-        _arithmeticEncoder->encode(!!(pos[0] & mask), _ctxEquiProb);
+    _arithmeticEncoder->encodeBypass(pos[0], nodeSizeLog2AfterPlanar[0]);
 
     posXyz[0] = pos[0] - headPos[0];
-    if (child.planarMode & 2) {
+    if (childPlanar.planarMode & 2) {
       int mask = 1 << (nodeSizeLog2[1] - 1);
       if (pos[1] & mask)
         posXyz[1] += mask;
@@ -924,10 +897,10 @@ GeometryOctreeEncoder::encodePointPositionAngular(
   }
 
   // Laser
-  int laserNode = int(child.laserIndex);
+  int laserNode = int(childPlanar.laserIndex);
   point_t posPointLidar =
     point_t(pos[0] - headPos[0], pos[1] - headPos[1], pos[2] - headPos[2]);
-  int laserIndex = findLaser(posPointLidar, thetaLaser, numLasers);
+  int laserIndex = _laserLut.find(posPointLidar);
   encodeThetaRes(laserIndex - laserNode);
 
   // find predictor
@@ -995,7 +968,7 @@ GeometryOctreeEncoder::encodePointPositionAngular(
   if (!maskz)
     return;
 
-  if (child.planarMode & 4) {
+  if (childPlanar.planarMode & 4) {
     int mask = 1 << (nodeSizeLog2[2] - 1);
     if (pos[2] & mask)
       posXyz[2] += mask;
@@ -1096,11 +1069,255 @@ calculateNodeQps(
   }
 }
 
+//-------------------------------------------------------------------------
+// The index of the child node containing @point, given the child node
+// size (or zero if the axis is not split) for each axis.
+
+static inline int
+childIdxOf(const point_t& point, const Vec3<int>& sortMask)
+{
+  return !!(int(point[2]) & sortMask[2])
+    | (!!(int(point[1]) & sortMask[1]) << 1)
+    | (!!(int(point[0]) & sortMask[0]) << 2);
+}
+
+//-------------------------------------------------------------------------
+// An octree key is the sequence of child indexes that locate a point in
+// up to kMaxLvls consecutive levels of the tree, starting with level lvl0
+// in the most significant bits.  The encoder partitions points by key
+// rather than reading each point's position at every level.
+
+struct OctreeKeys {
+  static const int kMaxLvls = 21;
+
+  // the child size (as used by childIdxOf) of each level
+  std::vector<Vec3<int>> sortMasks;
+
+  // the first level described by the keys
+  int lvl0 = 0;
+
+  OctreeKeys(const std::vector<Vec3<int>>& lvlNodeSizeLog2, int maxDepth)
+  {
+    for (int lvl = 0; lvl < maxDepth; lvl++)
+      sortMasks.push_back(
+        qtBtChildSize(lvlNodeSizeLog2[lvl], lvlNodeSizeLog2[lvl + 1]));
+  }
+
+  uint64_t key(const point_t& point) const
+  {
+    int lvlEnd = std::min(lvl0 + kMaxLvls, int(sortMasks.size()));
+    uint64_t key = 0;
+    for (int lvl = lvl0; lvl < lvlEnd; lvl++)
+      key = (key << 3) | childIdxOf(point, sortMasks[lvl]);
+    return key << 3 * (kMaxLvls - (lvlEnd - lvl0));
+  }
+
+  int childIdx(uint64_t key, int lvl) const
+  {
+    return (key >> 3 * (kMaxLvls - 1 - (lvl - lvl0))) & 7;
+  }
+};
+
+//-------------------------------------------------------------------------
+// Split the points [start, end) of a node between its children according
+// to the child index at level @lvl of each key.  @pointIdx is permuted
+// identically to @keys.
+//
+// NB: the order is the same as that produced by countingSort().
+
+static void
+partitionOctreePoints(
+  const OctreeKeys& keyCoder,
+  int lvl,
+  uint64_t* keys,
+  uint32_t* pointIdx,
+  int start,
+  int end,
+  std::array<int, 8>& counts)
+{
+  for (int i = start; i < end; i++)
+    counts[keyCoder.childIdx(keys[i], lvl)]++;
+
+  std::array<int, 8> ptrs;
+  ptrs[0] = start;
+  for (int i = 1; i < 8; i++)
+    ptrs[i] = ptrs[i - 1] + counts[i - 1];
+
+  // re-order, completing each child in turn
+  int childEnd = start;
+  for (int i = 0; i < 8; i++) {
+    childEnd += counts[i];
+    while (ptrs[i] != childEnd) {
+      int childIdx = keyCoder.childIdx(keys[ptrs[i]], lvl);
+      std::swap(keys[ptrs[i]], keys[ptrs[childIdx]]);
+      std::swap(pointIdx[ptrs[i]], pointIdx[ptrs[childIdx]]);
+      ptrs[childIdx]++;
+    }
+  }
+}
+
+//-------------------------------------------------------------------------
+// Determine if the points of @node, at level @lvl, lie in a single plane
+// along each eligible axis (see isPlanarNode).  The child indexes in the
+// keys are used in place of the point positions where they describe the
+// required split of each eligible axis.
+
+static void
+isPlanarNode(
+  const OctreeKeys& keyCoder,
+  int lvl,
+  const std::vector<uint64_t>& keys,
+  const PCCPointSet3& pointCloud,
+  const std::vector<uint32_t>& pointIdx,
+  const PCCOctree3Node& node,
+  const Vec3<int>& nodeSizeLog2,
+  uint8_t& planarMode,
+  uint8_t& planePosBits,
+  const bool planarEligible[3])
+{
+  bool useKeys = lvl < keyCoder.lvl0 + OctreeKeys::kMaxLvls
+    && lvl < int(keyCoder.sortMasks.size());
+  for (int k = 0; useKeys && k < 3; k++) {
+    if (planarEligible[k])
+      useKeys = nodeSizeLog2[k] > 0
+        && keyCoder.sortMasks[lvl][k] == 1 << (nodeSizeLog2[k] - 1);
+  }
+
+  if (!useKeys) {
+    isPlanarNode(
+      pointCloud, pointIdx, node, nodeSizeLog2 - 1, planarMode, planePosBits,
+      planarEligible);
+    return;
+  }
+
+  int occupancy = 0;
+  for (int i = node.start; i < node.end; i++)
+    occupancy |= 1 << keyCoder.childIdx(keys[i], lvl);
+
+  // the occupied planes of each axis, as per isPlanarNode()
+  static const uint8_t kPlaneMask[3][2] = {
+    {0x0f, 0xf0}, {0x33, 0xcc}, {0x55, 0xaa}};
+
+  planarMode = 0;
+  planePosBits = 0;
+  for (int k = 0; k < 3; k++) {
+    int occup = 0;
+    if (planarEligible[k])
+      occup = !!(occupancy & kPlaneMask[k][0])
+        | !!(occupancy & kPlaneMask[k][1]) << 1;
+    planarMode |= (occup != 3) << k;
+    planePosBits |= (occup == 2) << k;
+  }
+}
+
+//-------------------------------------------------------------------------
+// The points sorted by octree key, and, for each level, the boundaries
+// between the children of every node, found from the common prefix of
+// adjacent keys.
+
+struct OctreePresort {
+  // the end of the levels ordered by the sort
+  int lvlEnd = 0;
+
+  // for each level, the index of the first point of each child that
+  // does not start a node at that level, in increasing order
+  std::vector<std::vector<int>> childStarts;
+
+  // Determine the number of points in each child of the node
+  // [start, end) at level @lvl
+  void childCounts(
+    const OctreeKeys& keyCoder,
+    const std::vector<uint64_t>& keys,
+    int lvl,
+    int start,
+    int end,
+    std::array<int, 8>& counts) const
+  {
+    const auto& starts = childStarts[lvl];
+    auto it = std::upper_bound(starts.begin(), starts.end(), start);
+    int childStart = start;
+    while (childStart < end) {
+      int childEnd = end;
+      if (it != starts.end() && *it < end)
+        childEnd = *it++;
+      counts[keyCoder.childIdx(keys[childStart], lvl)] = childEnd - childStart;
+      childStart = childEnd;
+    }
+  }
+};
+
+//-------------------------------------------------------------------------
+// Sort the points by the child indexes of the levels [lvl0, @lvlEnd) of
+// their keys, such that the children of every node are contiguous.  The
+// sort is a stable radix sort: points that are not distinguished by the
+// sorted levels retain their relative order.
+//
+// @pointIdx is permuted identically to @keys.
+
+static OctreePresort
+presortOctreePoints(
+  const OctreeKeys& keyCoder,
+  int lvlEnd,
+  std::vector<uint64_t>& keys,
+  std::vector<uint32_t>& pointIdx)
+{
+  const int kKeyBits = 3 * OctreeKeys::kMaxLvls;
+  const int kDigitBits = 11;
+  int lsb = kKeyBits - 3 * (lvlEnd - keyCoder.lvl0);
+
+  std::vector<uint64_t> keysTmp(keys.size());
+  std::vector<uint32_t> pointIdxTmp(pointIdx.size());
+  std::vector<int> offsets(1 << kDigitBits);
+  for (int shift = lsb; shift < kKeyBits; shift += kDigitBits) {
+    int mask = (1 << std::min(kDigitBits, kKeyBits - shift)) - 1;
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (auto key : keys)
+      offsets[(key >> shift) & mask]++;
+
+    // skip digits that are common to all points
+    if (offsets[(keys.front() >> shift) & mask] == int(keys.size()))
+      continue;
+
+    int offset = 0;
+    for (auto& count : offsets) {
+      std::swap(offset, count);
+      offset += count;
+    }
+
+    for (size_t i = 0; i < keys.size(); i++) {
+      int dst = offsets[(keys[i] >> shift) & mask]++;
+      keysTmp[dst] = keys[i];
+      pointIdxTmp[dst] = pointIdx[i];
+    }
+    std::swap(keys, keysTmp);
+    std::swap(pointIdx, pointIdxTmp);
+  }
+
+  // a child starts wherever adjacent keys first differ at its parent level
+  OctreePresort presort;
+  presort.lvlEnd = lvlEnd;
+  presort.childStarts.resize(lvlEnd);
+
+  uint64_t sortMask = ~uint64_t(0) << lsb;
+  for (size_t i = 1; i < keys.size(); i++) {
+    uint64_t diff = (keys[i - 1] ^ keys[i]) & sortMask;
+    if (diff) {
+      int lvl = keyCoder.lvl0 + (kKeyBits - 1 - ilog2(diff)) / 3;
+      presort.childStarts[lvl].push_back(i);
+    }
+  }
+
+  return presort;
+}
+
 //-------------------------------------------------------------------------
 
 void
 geometryQuantization(
-  PCCPointSet3& pointCloud, PCCOctree3Node& node, Vec3<int> nodeSizeLog2)
+  PCCPointSet3& pointCloud,
+  const std::vector<uint32_t>& pointIdx,
+  PCCOctree3Node& node,
+  Vec3<int> nodeSizeLog2)
 {
   QuantizerGeom quantizer = QuantizerGeom(node.qp);
   int qpShift = node.qp >> 2;
@@ -1110,13 +1327,13 @@ geometryQuantization(
     int32_t clipMax = quantBitsMask >> qpShift;
 
     for (int i = node.start; i < node.end; i++) {
-      int32_t pos = int32_t(pointCloud[i][k]);
+      int32_t& pos = pointCloud[pointIdx[i]][k];
       int32_t quantPos = quantizer.quantize(pos & quantBitsMask);
       quantPos = PCCClip(quantPos, 0, clipMax);
 
       // NB: this representation is: |ppppppqqq00|, which, except for
       // the zero padding, is the same as the decoder.
-      pointCloud[i][k] = (pos & ~quantBitsMask) | (quantPos << qpShift);
+      pos = (pos & ~quantBitsMask) | (quantPos << qpShift);
     }
   }
 }
@@ -1125,7 +1342,10 @@ geometryQuantization(
 
 void
 geometryScale(
-  PCCPointSet3& pointCloud, PCCOctree3Node& node, Vec3<int> quantNodeSizeLog2)
+  PCCPointSet3& pointCloud,
+  const std::vector<uint32_t>& pointIdx,
+  PCCOctree3Node& node,
+  Vec3<int> quantNodeSizeLog2)
 {
   QuantizerGeom quantizer = QuantizerGeom(node.qp);
   int qpShift = node.qp >> 2;
@@ -1133,11 +1353,11 @@ geometryScale(
   for (int k = 0; k < 3; k++) {
     int quantBitsMask = (1 << quantNodeSizeLog2[k]) - 1;
     for (int i = node.start; i < node.end; i++) {
-      int pos = pointCloud[i][k];
+      int32_t& pos = pointCloud[pointIdx[i]][k];
       int lowPart = (pos & quantBitsMask) >> qpShift;
       int lowPartScaled = PCCClip(quantizer.scale(lowPart), 0, quantBitsMask);
       int highPartScaled = pos & ~quantBitsMask;
-      pointCloud[i][k] = highPartScaled | lowPartScaled;
+      pos = highPartScaled | lowPartScaled;
     }
   }
 }
@@ -1146,17 +1366,17 @@ geometryScale(
 
 void
 checkDuplicatePoints(
-  PCCPointSet3& pointCloud,
+  const PCCPointSet3& pointCloud,
+  std::vector<uint32_t>& pointIdx,
   PCCOctree3Node& node,
   std::vector<int>& pointIdxToDmIdx)
 {
-  auto first = PCCPointSet3::iterator(&pointCloud, node.start);
-  auto last = PCCPointSet3::iterator(&pointCloud, node.end);
+  auto first = pointIdx.begin() + node.start;
+  auto last = pointIdx.begin() + node.end;
 
   std::set<Vec3<int32_t>> uniquePointsSet;
   for (auto i = first; i != last;) {
-    if (uniquePointsSet.find(**i) == uniquePointsSet.end()) {
-      uniquePointsSet.insert(**i);
+    if (uniquePointsSet.insert(pointCloud[*i]).second) {
       i++;
     } else {
       std::iter_swap(i, last - 1);
@@ -1172,7 +1392,8 @@ DirectMode
 canEncodeDirectPosition(
   bool geom_unique_points_flag,
   const PCCOctree3Node& node,
-  const PCCPointSet3& pointCloud)
+  const PCCPointSet3& pointCloud,
+  const std::vector<uint32_t>& pointIdx)
 {
   int numPoints = node.end - node.start;
   // Check for duplicated points only if there are less than 10.
@@ -1181,8 +1402,9 @@ canEncodeDirectPosition(
     return DirectMode::kUnavailable;
 
   bool allPointsAreEqual = numPoints > 1 && !geom_unique_points_flag;
+  const auto& pos0 = pointCloud[pointIdx[node.start]];
   for (auto idx = node.start + 1; allPointsAreEqual && idx < node.end; idx++)
-    allPointsAreEqual &= pointCloud[node.start] == pointCloud[idx];
+    allPointsAreEqual &= pos0 == pointCloud[pointIdx[idx]];
 
   if (allPointsAreEqual)
     return DirectMode::kAllPointSame;
@@ -1201,13 +1423,14 @@ GeometryOctreeEncoder::encodeDirectPosition(
   bool geom_unique_points_flag,
   const Vec3<int>& nodeSizeLog2,
   int shiftBits,
-  PCCOctree3Node& node,
-  PCCPointSet3& pointCloud,
+  const PCCOctree3Node& node,
+  OctreeNodePlanar& planar,
+  const PCCPointSet3& pointCloud,
+  const std::vector<uint32_t>& pointIdx,
   bool angularIdcm,
   const Vec3<int>& headPos,
   const int* zLaser,
-  const int* thetaLaser,
-  int numLasers)
+  const int* thetaLaser)
 {
   int numPoints = node.end - node.start;
 
@@ -1239,28 +1462,31 @@ GeometryOctreeEncoder::encodeDirectPosition(
   // update node size after planar
   Vec3<int> nodeSizeLog2AfterPlanar = nodeSizeLog2;
   for (int k = 0; k < 3; k++)
-    if (nodeSizeLog2AfterPlanar[k] > 0 && (node.planarMode & (1 << k)))
+    if (nodeSizeLog2AfterPlanar[k] > 0 && (planar.planarMode & (1 << k)))
       nodeSizeLog2AfterPlanar[k]--;
 
+  // laser of the node centre, common to all points
+  if (angularIdcm) {
+    point_t posNodeLidar =
+      point_t(
+        node.pos[0] << nodeSizeLog2[0], node.pos[1] << nodeSizeLog2[1],
+        node.pos[2] << nodeSizeLog2[2])
+      - headPos;
+    posNodeLidar += point_t(
+      (1 << nodeSizeLog2[0]) >> 1, (1 << nodeSizeLog2[1]) >> 1,
+      (1 << nodeSizeLog2[2]) >> 1);
+    planar.laserIndex = _laserLut.find(posNodeLidar);
+  }
+
   // code points after planar
   for (auto idx = node.start; idx < node.start + numPoints; idx++) {
-    if (angularIdcm) {
-      point_t posNodeLidar =
-        point_t(
-          node.pos[0] << nodeSizeLog2[0], node.pos[1] << nodeSizeLog2[1],
-          node.pos[2] << nodeSizeLog2[2])
-        - headPos;
-      posNodeLidar += point_t(
-        (1 << nodeSizeLog2[0]) >> 1, (1 << nodeSizeLog2[1]) >> 1,
-        (1 << nodeSizeLog2[2]) >> 1);
-      node.laserIndex = findLaser(posNodeLidar, thetaLaser, numLasers);
-
+    auto pos = pointCloud[pointIdx[idx]] >> shiftBits;
+    if (angularIdcm)
       encodePointPositionAngular(
-        nodeSizeLog2, nodeSizeLog2AfterPlanar, pointCloud[idx] >> shiftBits,
-        node.planarMode, node, headPos, zLaser, thetaLaser, numLasers);
-    } else
-      encodePointPosition(
-        nodeSizeLog2AfterPlanar, pointCloud[idx] >> shiftBits);
+        nodeSizeLog2, nodeSizeLog2AfterPlanar, pos, planar.planarMode, node,
+        planar, headPos, zLaser, thetaLaser);
+    else
+      encodePointPosition(nodeSizeLog2AfterPlanar, pos);
   }
 }
 
@@ -1272,7 +1498,7 @@ GeometryOctreeEncoder::encodeThetaRes(int thetaRes)
   _arithmeticEncoder->encode(thetaRes == 0 ? 1 : 0, _ctxThetaResIsZero);
 
   if (thetaRes) {
-    _arithmeticEncoder->encode(thetaRes > 0 ? 1 : 0, _ctxThetaSign);
+    _arithmeticEncoder->encode(thetaRes > 0 ? 1 : 0, _ctxThetaResSign);
     int absThetaRes = std::abs(thetaRes);
     _arithmeticEncoder->encode(absThetaRes == 1 ? 1 : 0, _ctxThetaResIsOne);
     if (absThetaRes >= 2)
@@ -1284,27 +1510,75 @@ GeometryOctreeEncoder::encodeThetaRes(int thetaRes)
 }
 
 //-------------------------------------------------------------------------
+// Per node state, derived for all nodes in a tree level prior to the
+// entropy coding of the level.  Indexed by the node's order in the level.
+
+struct OctreeLevelContexts {
+  std::vector<std::array<int, 8>> childCounts;
+  std::vector<uint8_t> occupancy;
+  std::vector<uint8_t> numSiblings;
+
+  // external child adjacency, if neighbour_avail_boundary_log2 > 0
+  std::vector<uint8_t> adjacencyGt0;
+  std::vector<uint8_t> adjacencyGt1;
+  std::vector<uint8_t> adjacencyUnocc;
+
+  // intra occupancy prediction, if enabled for the level
+  std::vector<uint8_t> occupancyIsPredicted;
+  std::vector<uint8_t> occupancyPrediction;
+
+  void reset(int numNodes)
+  {
+    childCounts.assign(numNodes, {});
+    occupancy.resize(numNodes);
+    numSiblings.resize(numNodes);
+    adjacencyGt0.assign(numNodes, 0);
+    adjacencyGt1.assign(numNodes, 0);
+    adjacencyUnocc.assign(numNodes, 0);
+    occupancyIsPredicted.assign(numNodes, 0);
+    occupancyPrediction.assign(numNodes, 0);
+  }
+};
 
-void
+//-------------------------------------------------------------------------
+// NB: the octree coding loop is specialised upon the set of coding @Tools.
+
+template<typename Tools>
+static void
 encodeGeometryOctree(
+  Tools,
   const OctreeEncOpts& params,
   const GeometryParameterSet& gps,
   GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyEncoder>>& arithmeticEncoders,
   pcc::ringbuf<PCCOctree3Node>* nodesRemaining)
 {
+  // the coding tools in use
+  // NB: these are compile time constants in specialised instances
+  const bool useNeighAvail =
+    Tools::enabled(kOctreeToolNeighAvail, gps.neighbour_avail_boundary_log2);
+  const bool usePlanar =
+    Tools::enabled(kOctreeToolPlanar, gps.geom_planar_mode_enabled_flag);
+  const bool useAngular =
+    Tools::enabled(kOctreeToolAngular, gps.geom_angular_mode_enabled_flag);
+  const bool useIdcm = Tools::enabled(
+    kOctreeToolIdcm, gps.inferred_direct_coding_mode_enabled_flag);
+  const bool useInTreeQuant =
+    Tools::enabled(kOctreeToolInTreeQuant, gps.geom_scaling_enabled_flag);
+
   auto arithmeticEncoderIt = arithmeticEncoders.begin();
-  GeometryOctreeEncoder encoder(gps, arithmeticEncoderIt->get());
+  GeometryOctreeEncoder encoder(gps, ctxtMem, arithmeticEncoderIt->get());
 
   // saved state for use with parallel bistream coding.
   // the saved state is restored at the start of each parallel octree level
   std::unique_ptr<GeometryOctreeEncoder> savedState;
 
   // init main fifo
-  //  -- worst case size is the last level containing every input poit
-  //     and each point being isolated in the previous level.
-  pcc::ringbuf<PCCOctree3Node> fifo(pointCloud.getPointCount() + 1);
+  //  -- the fifo is grown at the start of each level to hold the level
+  //     and all of its children.
+  pcc::ringbuf<PCCOctree3Node> fifo(1);
 
   // push the first node
   fifo.emplace_back();
@@ -1316,9 +1590,23 @@ encodeGeometryOctree(
   node00.numSiblingsPlus1 = 8;
   node00.siblingOccupancy = 0;
   node00.qp = 0;
-  node00.planarMode = 0;
 
-  // map of pointCloud idx to DM idx, used to reorder the points
+  // planar and angular state of the nodes in the current and next levels,
+  // indexed by the node's order in its level.
+  //  -- only maintained if either mode is enabled.
+  const bool usePlanarState = usePlanar || useAngular;
+  std::vector<OctreeNodePlanar> planarLvl(usePlanarState ? 1 : 0);
+  std::vector<OctreeNodePlanar> planarNextLvl;
+
+  // indexes of the points to be coded in pointCloud, and their keys.
+  //  - the octree partitions these compact arrays rather than pointCloud,
+  //    which is only reordered once coding is complete.  Positions are
+  //    read through the index (and quantised in place) as required.
+  std::vector<uint32_t> pointIdx(pointCloud.getPointCount());
+  std::iota(pointIdx.begin(), pointIdx.end(), 0);
+  std::vector<uint64_t> pointKeys(pointCloud.getPointCount());
+
+  // map of points idx to DM idx, used to reorder the points
   // after coding.
   std::vector<int> pointIdxToDmIdx(int(pointCloud.getPointCount()), -1);
   int nextDmIdx = 0;
@@ -1327,7 +1615,7 @@ encodeGeometryOctree(
   auto lvlNodeSizeLog2 = mkQtBtNodeSizeList(gps, params.qtbt, gbh);
   auto nodeSizeLog2 = lvlNodeSizeLog2[0];
 
-  const int idcmThreshold = gps.geom_planar_mode_enabled_flag
+  const int idcmThreshold = usePlanar
     ? gps.geom_planar_idcm_threshold * 127 * 127
     : 127 * 127 * 127;
 
@@ -1348,7 +1636,7 @@ encodeGeometryOctree(
   }
 
   MortonMap3D occupancyAtlas;
-  if (gps.neighbour_avail_boundary_log2) {
+  if (useNeighAvail) {
     occupancyAtlas.resize(gps.neighbour_avail_boundary_log2);
     occupancyAtlas.clear();
   }
@@ -1384,21 +1672,39 @@ encodeGeometryOctree(
       ~nonSplitQtBtAxes(lvlNodeSizeLog2[lvl - 1], lvlNodeSizeLog2[lvl]));
   }
 
+  OctreeKeys keyCoder(lvlNodeSizeLog2, maxDepth);
+  for (size_t i = 0; i < pointIdx.size(); i++)
+    pointKeys[i] = keyCoder.key(pointCloud[i]);
+
   // the node size where quantisation is performed
   Vec3<int> quantNodeSizeLog2 = 0;
   int idcmQp = 0;
   int sliceQp = gps.geom_base_qp + gbh.geom_slice_qp_offset;
   int numLvlsUntilQuantization = 0;
-  if (gps.geom_scaling_enabled_flag) {
+  if (useInTreeQuant) {
     // if an invalid depth is set, use tree height instead
     if (gbh.geom_octree_qp_offset_depth < 0)
       gbh.geom_octree_qp_offset_depth = maxDepth;
     numLvlsUntilQuantization = gbh.geom_octree_qp_offset_depth + 1;
   }
 
+  // optionally order the points such that each node's children are
+  // contiguous at every level described by the keys.  This holds until
+  // in-tree quantisation modifies the point positions.
+  OctreePresort presort;
+  if (params.presortPoints && !pointIdx.empty()) {
+    int lvlEnd = std::min(maxDepth, int(OctreeKeys::kMaxLvls));
+    if (useInTreeQuant)
+      lvlEnd = std::min(lvlEnd, int(gbh.geom_octree_qp_offset_depth));
+    presort = presortOctreePoints(keyCoder, lvlEnd, pointKeys, pointIdx);
+  }
+
   // represents the largest dimension of the current node
   int nodeMaxDimLog2;
 
+  // per node state for the current level, derived prior to coding
+  OctreeLevelContexts lvlCtx;
+
   for (int depth = 0; depth < maxDepth; depth++) {
     // setyo at the start of each level
     auto fifoCurrLvlEnd = fifo.end();
@@ -1420,14 +1726,19 @@ encodeGeometryOctree(
     int childOccupancySkipLevel =
       nonSplitQtBtAxes(childSizeLog2, grandchildSizeLog2);
 
-    auto pointSortMask = qtBtChildSize(nodeSizeLog2, childSizeLog2);
+    // the keys only describe a limited number of levels
+    if (depth == keyCoder.lvl0 + OctreeKeys::kMaxLvls) {
+      keyCoder.lvl0 = depth;
+      for (size_t i = 0; i < pointIdx.size(); i++)
+        pointKeys[i] = keyCoder.key(pointCloud[pointIdx[i]]);
+    }
 
     // Idcm quantisation applies to child nodes before per node qps
     if (--numLvlsUntilQuantization > 0) {
       // If planar is enabled, the planar bits are not quantised (since
       // the planar mode is determined before quantisation)
       quantNodeSizeLog2 = childSizeLog2;
-      if (gps.geom_planar_mode_enabled_flag)
+      if (usePlanar)
         quantNodeSizeLog2 -= 1;
 
       for (int k = 0; k < 3; k++)
@@ -1466,49 +1777,40 @@ encodeGeometryOctree(
     auto planarDepth = gbh.rootNodeSizeLog2 - childSizeLog2;
     encoder.beginOctreeLevel(planarDepth);
 
-    // process all nodes within a single level
-    for (; fifo.begin() != fifoCurrLvlEnd; fifo.pop_front()) {
-      PCCOctree3Node& node0 = fifo.front();
-
-      // encode delta qp for each octree block
-      if (numLvlsUntilQuantization == 0)
-        encoder.encodeQpOffset(node0.qp - sliceQp);
+    // derive, for all nodes in the level, the per node state that does
+    // not depend upon the entropy coder prior to coding any node:
+    //  - split each node's points between its children (in parallel)
+    //  - determine the neighbour patterns and occupancy predictions
+    int numNodesLvl = fifoCurrLvlEnd - fifo.begin();
+    auto fifoCurrLvlBegin = fifo.begin();
+    lvlCtx.reset(numNodesLvl);
 
-      int shiftBits = node0.qp >> 2;
-      auto effectiveNodeSizeLog2 = nodeSizeLog2 - shiftBits;
-      auto effectiveChildSizeLog2 = childSizeLog2 - shiftBits;
-
-      // make quantisation work with qtbt and planar.
-      int occupancySkip = occupancySkipLevel;
-      int childOccupancySkip = childOccupancySkipLevel;
-      if (shiftBits != 0) {
-        for (int k = 0; k < 3; k++) {
-          if (effectiveChildSizeLog2[k] < 0)
-            occupancySkip |= (4 >> k);
-          if (effectiveChildSizeLog2[k] < 1)
-            childOccupancySkip |= (4 >> k);
-        }
-      }
+    parallelFor(params.numThreads, 0, numNodesLvl, [&](int nodeIdx) {
+      PCCOctree3Node& node0 = *(fifoCurrLvlBegin + nodeIdx);
 
-      if (numLvlsUntilQuantization == 0) {
-        geometryQuantization(pointCloud, node0, quantNodeSizeLog2);
+      if (useInTreeQuant && numLvlsUntilQuantization == 0) {
+        geometryQuantization(pointCloud, pointIdx, node0, quantNodeSizeLog2);
         if (gps.geom_unique_points_flag)
-          checkDuplicatePoints(pointCloud, node0, pointIdxToDmIdx);
+          checkDuplicatePoints(pointCloud, pointIdx, node0, pointIdxToDmIdx);
+
+        // the keys must describe the quantised positions
+        for (int i = node0.start; i < node0.end; i++)
+          pointKeys[i] = keyCoder.key(pointCloud[pointIdx[i]]);
       }
 
       // split the current node into 8 children
-      //  - perform an 8-way counting sort of the current node's points
+      //  - perform an 8-way counting sort of the current node's points,
+      //    or, if presorted, find the boundaries between each child
       //  - (later) map to child nodes
-      std::array<int, 8> childCounts = {};
-      countingSort(
-        PCCPointSet3::iterator(&pointCloud, node0.start),
-        PCCPointSet3::iterator(&pointCloud, node0.end), childCounts,
-        [=](const PCCPointSet3::Proxy& proxy) {
-          const auto& point = *proxy;
-          return !!(int(point[2]) & pointSortMask[2])
-            | (!!(int(point[1]) & pointSortMask[1]) << 1)
-            | (!!(int(point[0]) & pointSortMask[0]) << 2);
-        });
+      auto& childCounts = lvlCtx.childCounts[nodeIdx];
+      if (depth < presort.lvlEnd) {
+        presort.childCounts(
+          keyCoder, pointKeys, depth, node0.start, node0.end, childCounts);
+      } else {
+        partitionOctreePoints(
+          keyCoder, depth, pointKeys.data(), pointIdx.data(), node0.start,
+          node0.end, childCounts);
+      }
 
       // generate the bitmap of child occupancy and count
       // the number of occupied children in node0.
@@ -1521,13 +1823,29 @@ encodeGeometryOctree(
         }
       }
 
-      int occupancyAdjacencyGt0 = 0;
-      int occupancyAdjacencyGt1 = 0;
-      int occupancyAdjacencyUnocc = 0;
+      lvlCtx.occupancy[nodeIdx] = occupancy;
+      lvlCtx.numSiblings[nodeIdx] = numSiblings;
+    });
 
-      if (gps.neighbour_avail_boundary_log2) {
+    // size the fifo to hold the current level and all of its children
+    int numChildrenLvl = std::accumulate(
+      lvlCtx.numSiblings.begin(), lvlCtx.numSiblings.end(), 0);
+    fifo.reserve(numNodesLvl + numChildrenLvl);
+    fifoCurrLvlBegin = fifo.begin();
+    fifoCurrLvlEnd = fifo.end();
+
+    if (usePlanarState) {
+      planarNextLvl.clear();
+      planarNextLvl.reserve(numChildrenLvl);
+    }
+
+    for (int nodeIdx = 0; nodeIdx < numNodesLvl; nodeIdx++) {
+      auto fifoCurr = fifoCurrLvlBegin + nodeIdx;
+      PCCOctree3Node& node0 = *fifoCurr;
+
+      if (useNeighAvail) {
         updateGeometryOccupancyAtlas(
-          node0.pos, atlasShift, fifo, fifoCurrLvlEnd, &occupancyAtlas,
+          node0.pos, atlasShift, fifoCurr, fifoCurrLvlEnd, &occupancyAtlas,
           &occupancyAtlasOrigin);
 
         GeometryNeighPattern gnp = makeGeometryNeighPattern(
@@ -1535,27 +1853,62 @@ encodeGeometryOctree(
           atlasShift, occupancyAtlas);
 
         node0.neighPattern = gnp.neighPattern;
-        occupancyAdjacencyGt0 = gnp.adjacencyGt0;
-        occupancyAdjacencyGt1 = gnp.adjacencyGt1;
-        occupancyAdjacencyUnocc = gnp.adjacencyUnocc;
+        lvlCtx.adjacencyGt0[nodeIdx] = gnp.adjacencyGt0;
+        lvlCtx.adjacencyGt1[nodeIdx] = gnp.adjacencyGt1;
+        lvlCtx.adjacencyUnocc[nodeIdx] = gnp.adjacencyUnocc;
       }
 
-      int occupancyIsPredicted = 0;
-      int occupancyPrediction = 0;
-
       // generate intra prediction
       if (nodeMaxDimLog2 < gps.intra_pred_max_node_size_log2) {
+        int occupancyIsPredicted, occupancyPrediction;
         predictGeometryOccupancyIntra(
           occupancyAtlas, node0.pos, atlasShift, &occupancyIsPredicted,
           &occupancyPrediction);
+        lvlCtx.occupancyIsPredicted[nodeIdx] = occupancyIsPredicted;
+        lvlCtx.occupancyPrediction[nodeIdx] = occupancyPrediction;
       }
 
       // update atlas for advanced neighbours
-      if (gps.neighbour_avail_boundary_log2) {
+      if (useNeighAvail) {
         updateGeometryOccupancyAtlasOccChild(
-          node0.pos, occupancy, &occupancyAtlas);
+          node0.pos, lvlCtx.occupancy[nodeIdx], &occupancyAtlas);
+      }
+    }
+
+    // code all nodes within a single level
+    for (int nodeIdx = 0; fifo.begin() != fifoCurrLvlEnd;
+         fifo.pop_front(), nodeIdx++) {
+      PCCOctree3Node& node0 = fifo.front();
+
+      // planar state of node0, or the initial state if not maintained
+      OctreeNodePlanar planarDefault;
+      OctreeNodePlanar& planar0 =
+        usePlanarState ? planarLvl[nodeIdx] : planarDefault;
+
+      // encode delta qp for each octree block
+      if (useInTreeQuant && numLvlsUntilQuantization == 0)
+        encoder.encodeQpOffset(node0.qp - sliceQp);
+
+      int shiftBits = useInTreeQuant ? node0.qp >> 2 : 0;
+      auto effectiveNodeSizeLog2 = nodeSizeLog2 - shiftBits;
+      auto effectiveChildSizeLog2 = childSizeLog2 - shiftBits;
+
+      // make quantisation work with qtbt and planar.
+      int occupancySkip = occupancySkipLevel;
+      int childOccupancySkip = childOccupancySkipLevel;
+      if (shiftBits != 0) {
+        for (int k = 0; k < 3; k++) {
+          if (effectiveChildSizeLog2[k] < 0)
+            occupancySkip |= (4 >> k);
+          if (effectiveChildSizeLog2[k] < 1)
+            childOccupancySkip |= (4 >> k);
+        }
       }
 
+      const auto& childCounts = lvlCtx.childCounts[nodeIdx];
+      int occupancy = lvlCtx.occupancy[nodeIdx];
+      int numSiblings = lvlCtx.numSiblings[nodeIdx];
+
       // when all points are quantized to a single point
       if (!isLeafNode(effectiveNodeSizeLog2)) {
         // encode child occupancy map
@@ -1566,19 +1919,20 @@ encodeGeometryOctree(
         // mask to be used for the occupancy coding
         // (bit =1 => occupancy bit not coded due to not belonging to the plane)
         int planarMask[3] = {0, 0, 0};
-        maskPlanar(node0, planarMask, occupancySkip);
+        maskPlanar(planar0, planarMask, occupancySkip);
 
         encoder.encodeOccupancy(
-          node0.neighPattern, occupancy, occupancyIsPredicted,
-          occupancyPrediction, occupancyAdjacencyGt0, occupancyAdjacencyGt1,
-          occupancyAdjacencyUnocc, planarMask[0], planarMask[1], planarMask[2],
-          node0.planarPossible & 1, node0.planarPossible & 2,
-          node0.planarPossible & 4);
+          node0.neighPattern, occupancy, lvlCtx.occupancyIsPredicted[nodeIdx],
+          lvlCtx.occupancyPrediction[nodeIdx], lvlCtx.adjacencyGt0[nodeIdx],
+          lvlCtx.adjacencyGt1[nodeIdx], lvlCtx.adjacencyUnocc[nodeIdx],
+          planarMask[0], planarMask[1], planarMask[2],
+          planar0.planarPossible & 1, planar0.planarPossible & 2,
+          planar0.planarPossible & 4);
       }
 
       // planar eligibility
       bool planarEligible[3] = {false, false, false};
-      if (gps.geom_planar_mode_enabled_flag) {
+      if (usePlanar) {
         // update the plane rate depending on the occupancy and local density
         encoder._planar.updateRate(occupancy, numSiblings);
         encoder._planar.isEligible(planarEligible);
@@ -1590,7 +1944,7 @@ encodeGeometryOctree(
           planarEligible[2] = false;
 
         // avoid mismatch when the next level will apply quantization
-        if (numLvlsUntilQuantization == 1) {
+        if (useInTreeQuant && numLvlsUntilQuantization == 1) {
           planarEligible[0] = false;
           planarEligible[1] = false;
           planarEligible[2] = false;
@@ -1602,7 +1956,7 @@ encodeGeometryOctree(
         int childStart = node0.start;
 
         // inverse quantise any quantised positions
-        geometryScale(pointCloud, node0, quantNodeSizeLog2);
+        geometryScale(pointCloud, pointIdx, node0, quantNodeSizeLog2);
 
         for (int i = 0; i < 8; i++) {
           if (!childCounts[i]) {
@@ -1646,6 +2000,12 @@ encodeGeometryOctree(
         fifo.emplace_back();
         auto& child = fifo.back();
 
+        OctreeNodePlanar childPlanarDefault;
+        if (usePlanarState)
+          planarNextLvl.emplace_back();
+        OctreeNodePlanar& childPlanar =
+          usePlanarState ? planarNextLvl.back() : childPlanarDefault;
+
         int x = !!(i & 4);
         int y = !!(i & 2);
         int z = !!(i & 1);
@@ -1661,17 +2021,16 @@ encodeGeometryOctree(
         child.end = childPointsStartIdx;
         child.numSiblingsPlus1 = numSiblings;
         child.siblingOccupancy = occupancy;
-        child.laserIndex = node0.laserIndex;
+        childPlanar.laserIndex = planar0.laserIndex;
 
         int contextAngle = -1;
         int contextAnglePhiX = -1;
         int contextAnglePhiY = -1;
-        if (
-          gps.geom_angular_mode_enabled_flag
-          && gps.geom_planar_mode_enabled_flag) {
+        if (useAngular && usePlanar) {
           contextAngle = determineContextAngleForPlanar(
-            child, headPos, childSizeLog2, zLaser, thetaLaser, numLasers,
-            deltaAngle, encoder._phiZi, encoder._phiBuffer.data(),
+            child, childPlanar, headPos, childSizeLog2, zLaser, thetaLaser,
+            encoder._laserLut, deltaAngle, encoder._phiZi,
+            encoder._phiBuffer.data(), &encoder._angularColumn,
             &contextAnglePhiX, &contextAnglePhiY);
 
           if (contextAngle != -1)
@@ -1682,19 +2041,25 @@ encodeGeometryOctree(
 
         // determine planarity if eligible
         int planarProb[3] = {127, 127, 127};
-        if (planarEligible[0] || planarEligible[1] || planarEligible[2])
+        if (planarEligible[0] || planarEligible[1] || planarEligible[2]) {
+          uint8_t planarMode, planePosBits;
+          isPlanarNode(
+            keyCoder, depth + 1, pointKeys, pointCloud, pointIdx, child,
+            childSizeLog2, planarMode, planePosBits, planarEligible);
+
           encoder.determinePlanarMode(
-            pointCloud, planarEligible, childSizeLog2, child,
+            planarMode, planePosBits, planarEligible, child, childPlanar,
             node0.neighPattern, x, y, z, planarProb, contextAngle,
             contextAnglePhiX, contextAnglePhiY);
+        }
 
         // IDCM
-        bool idcmEnabled = gps.inferred_direct_coding_mode_enabled_flag
+        bool idcmEnabled = useIdcm
           && planarProb[0] * planarProb[1] * planarProb[2] <= idcmThreshold;
 
         if (isDirectModeEligible(idcmEnabled, nodeMaxDimLog2, node0, child)) {
           auto mode = canEncodeDirectPosition(
-            gps.geom_unique_points_flag, child, pointCloud);
+            gps.geom_unique_points_flag, child, pointCloud, pointIdx);
 
           int idcmShiftBits = shiftBits;
           auto idcmSize = effectiveChildSizeLog2;
@@ -1703,17 +2068,18 @@ encodeGeometryOctree(
             child.qp = idcmQp;
             idcmShiftBits = idcmQp >> 2;
             idcmSize = childSizeLog2 - idcmShiftBits;
-            geometryQuantization(pointCloud, child, quantNodeSizeLog2);
+            geometryQuantization(
+              pointCloud, pointIdx, child, quantNodeSizeLog2);
           }
 
           encoder.encodeDirectPosition(
             mode, gps.geom_unique_points_flag, idcmSize, idcmShiftBits, child,
-            pointCloud, gps.geom_angular_mode_enabled_flag, headPos, zLaser,
-            thetaLaser, numLasers);
+            childPlanar, pointCloud, pointIdx, useAngular, headPos, zLaser,
+            thetaLaser);
 
           if (mode != DirectMode::kUnavailable) {
             // inverse quantise any quantised positions
-            geometryScale(pointCloud, child, quantNodeSizeLog2);
+            geometryScale(pointCloud, pointIdx, child, quantNodeSizeLog2);
 
             // point reordering to match decoder's order
             for (auto idx = child.start; idx < child.end; idx++)
@@ -1725,6 +2091,8 @@ encodeGeometryOctree(
             // remove leaf node from fifo: it has been consumed and will
             // not be further split.
             fifo.pop_back();
+            if (usePlanarState)
+              planarNextLvl.pop_back();
             break;
           }
         }
@@ -1733,15 +2101,21 @@ encodeGeometryOctree(
 
         // NB: when neighbourAvailBoundaryLog2 is set, an alternative
         //     implementation is used to calculate neighPattern.
-        if (!gps.neighbour_avail_boundary_log2) {
+        if (!useNeighAvail) {
           updateGeometryNeighState(
             gps.neighbour_context_restriction_flag, fifo.end(),
             numNodesNextLvl, child, i, node0.neighPattern, occupancy);
         }
       }
     }
+
+    if (usePlanarState)
+      std::swap(planarLvl, planarNextLvl);
   }
 
+  // save the context state for possible use by a later slice
+  ctxtMem = encoder.getCtx();
+
   // return partial coding result
   //  - add missing levels to node positions
   //  - inverse quantise the point cloud
@@ -1751,9 +2125,29 @@ encodeGeometryOctree(
     for (auto& node : fifo) {
       for (int k = 0; k < 3; k++)
         node.pos[k] <<= nodeSizeLog2[k];
-      geometryScale(pointCloud, node, quantNodeSizeLog2);
+      geometryScale(pointCloud, pointIdx, node, quantNodeSizeLog2);
     }
     *nodesRemaining = std::move(fifo);
+
+    // the node ranges index points: apply the same order to pointCloud
+    PCCPointSet3 pointCloud2;
+    pointCloud2.addRemoveAttributes(
+      pointCloud.hasColors(), pointCloud.hasReflectances());
+    if (pointCloud.hasFrameIndex())
+      pointCloud2.addFrameIndex();
+    pointCloud2.resize(pointCloud.getPointCount());
+
+    for (size_t i = 0; i < pointIdx.size(); i++) {
+      int srcIdx = pointIdx[i];
+      pointCloud2[i] = pointCloud[srcIdx];
+      if (pointCloud.hasColors())
+        pointCloud2.setColor(i, pointCloud.getColor(srcIdx));
+      if (pointCloud.hasReflectances())
+        pointCloud2.setReflectance(i, pointCloud.getReflectance(srcIdx));
+      if (pointCloud.hasFrameIndex())
+        pointCloud2.setFrameIndex(i, pointCloud.getFrameIndex(srcIdx));
+    }
+    swap(pointCloud, pointCloud2);
     return;
   }
 
@@ -1776,16 +2170,56 @@ encodeGeometryOctree(
       continue;
     }
 
-    pointCloud2[dstIdx] = pointCloud[i];
+    // NB: this is the only point at which attributes are moved
+    int srcIdx = pointIdx[i];
+    pointCloud2[dstIdx] = pointCloud[srcIdx];
     if (pointCloud.hasColors())
-      pointCloud2.setColor(dstIdx, pointCloud.getColor(i));
+      pointCloud2.setColor(dstIdx, pointCloud.getColor(srcIdx));
     if (pointCloud.hasReflectances())
-      pointCloud2.setReflectance(dstIdx, pointCloud.getReflectance(i));
+      pointCloud2.setReflectance(dstIdx, pointCloud.getReflectance(srcIdx));
   }
   pointCloud2.resize(outIdx);
   swap(pointCloud, pointCloud2);
 }
 
+//-------------------------------------------------------------------------
+
+void
+encodeGeometryOctree(
+  const OctreeEncOpts& params,
+  const GeometryParameterSet& gps,
+  GeometryBrickHeader& gbh,
+  PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
+  std::vector<std::unique_ptr<EntropyEncoder>>& arithmeticEncoders,
+  pcc::ringbuf<PCCOctree3Node>* nodesRemaining)
+{
+  switch (octreeTools(gps)) {
+  case kOctreeToolsCtcOctree:
+    encodeGeometryOctree(
+      OctreeToolsFixed<kOctreeToolsCtcOctree>(), params, gps, gbh,
+      pointCloud, ctxtMem, arithmeticEncoders, nodesRemaining);
+    break;
+
+  case kOctreeToolsCtcOctreeAngular:
+    encodeGeometryOctree(
+      OctreeToolsFixed<kOctreeToolsCtcOctreeAngular>(), params, gps, gbh,
+      pointCloud, ctxtMem, arithmeticEncoders, nodesRemaining);
+    break;
+
+  case kOctreeToolsCtcTrisoup:
+    encodeGeometryOctree(
+      OctreeToolsFixed<kOctreeToolsCtcTrisoup>(), params, gps, gbh,
+      pointCloud, ctxtMem, arithmeticEncoders, nodesRemaining);
+    break;
+
+  default:
+    encodeGeometryOctree(
+      OctreeToolsAny(), params, gps, gbh, pointCloud, ctxtMem,
+      arithmeticEncoders, nodesRemaining);
+  }
+}
+
 //============================================================================
 
 void
@@ -1794,9 +2228,11 @@ encodeGeometryOctree(
   const GeometryParameterSet& gps,
   GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyEncoder>>& arithmeticEncoders)
 {
-  encodeGeometryOctree(opt, gps, gbh, pointCloud, arithmeticEncoders, nullptr);
+  encodeGeometryOctree(
+    opt, gps, gbh, pointCloud, ctxtMem, arithmeticEncoders, nullptr);
 }
 
 //============================================================================
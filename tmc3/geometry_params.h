@@ -57,6 +57,13 @@ struct QtBtParameters {
 
 struct OctreeEncOpts {
   QtBtParameters qtbt;
+
+  // Sort the points once by their octree child indexes prior to coding
+  // rather than partitioning the points at each tree level.
+  bool presortPoints;
+
+  // Maximum number of threads used to derive per-level node contexts
+  int numThreads;
 };
 
 //=============================================================================
@@ -72,6 +79,9 @@ struct PredGeomEncOpts {
 
   // limit on number of points per tree
   int maxPtsPerTree;
+
+  // Maximum number of threads used to sort and build prediction trees
+  int numThreads;
 };
 
 //=============================================================================
@@ -72,7 +72,15 @@ struct GNode {
 
 //============================================================================
 
-struct PredGeomCodec {
+// The entropy coding contexts of the predictive geometry coder.
+//
+// NB: the context state may be carried from the end of one slice to the
+//     start of another (gbh.entropy_continuation_flag).
+
+struct PredGeomContexts {
+  // Restore the initial context state
+  void reset() { *this = PredGeomContexts(); }
+
   StaticBitModel _ctxBypass;
   AdaptiveBitModel _ctxNumChildren[3];
   AdaptiveBitModel _ctxPredMode[3];
@@ -38,18 +38,24 @@
 #include "geometry.h"
 #include "hls.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace pcc {
 
 //============================================================================
 
-class PredGeomDecoder : public PredGeomCodec {
+class PredGeomDecoder : protected PredGeomContexts {
 public:
   PredGeomDecoder(const PredGeomDecoder&) = delete;
   PredGeomDecoder& operator=(const PredGeomDecoder&) = delete;
 
-  PredGeomDecoder(const GeometryParameterSet&, EntropyDecoder* aed);
+  PredGeomDecoder(
+    const GeometryParameterSet&,
+    const PredGeomContexts& ctxtMem,
+    EntropyDecoder* aed);
+
+  const PredGeomContexts& getCtx() const { return *this; }
 
   /**
    * decodes a sequence of decoded geometry trees.
@@ -58,10 +64,10 @@ public:
   int decode(int numPoints, Vec3<int32_t>* outputPoints);
 
   /**
-   * decodes a single predictive geometry tree.
+   * decodes a single predictive geometry tree, of at most maxPoints points.
    * @returns the number of points decoded.
    */
-  int decodeTree(Vec3<int32_t>* outputPoints);
+  int decodeTree(Vec3<int32_t>* outputPoints, int maxPoints);
 
 private:
   int decodeNumDuplicatePoints();
@@ -70,20 +76,28 @@ private:
   Vec3<int32_t> decodeResidual(GPredicter::Mode mode);
 
 private:
+  // A node with children that are yet to be decoded, along with the
+  // positions required to predict them: the node itself, its parent
+  // and grandparent.
+  struct StackEntry {
+    Vec3<int32_t> ancestors[3];
+    int numChildren;
+  };
+
   EntropyDecoder* _aed;
-  std::vector<int32_t> _stack;
-  std::vector<int32_t> _nodeIdxToParentIdx;
+  std::vector<StackEntry> _stack;
   bool _geom_unique_points_flag;
 };
 
 //============================================================================
 
 PredGeomDecoder::PredGeomDecoder(
-  const GeometryParameterSet& gps, EntropyDecoder* aed)
-  : _aed(aed), _geom_unique_points_flag(gps.geom_unique_points_flag)
-{
-  _stack.reserve(1024);
-}
+  const GeometryParameterSet& gps,
+  const PredGeomContexts& ctxtMem,
+  EntropyDecoder* aed)
+  : PredGeomContexts(ctxtMem)
+  , _aed(aed), _geom_unique_points_flag(gps.geom_unique_points_flag)
+{}
 
 //----------------------------------------------------------------------------
 
@@ -147,9 +161,7 @@ PredGeomDecoder::decodeResidual(GPredicter::Mode mode)
       res = 2 + numBits;
     } else {
       res = 1 + (1 << numBits);
-      for (int i = 0; i < numBits; ++i) {
-        res += _aed->decode(_ctxBypass) << i;
-      }
+      res += reverseBits(_aed->decodeBypass(numBits), numBits);
     }
     residual[k] = sign ? res : -res;
   }
@@ -159,19 +171,40 @@ PredGeomDecoder::decodeResidual(GPredicter::Mode mode)
 
 //----------------------------------------------------------------------------
 
-int
-PredGeomDecoder::decodeTree(Vec3<int32_t>* outputPoints)
+static inline Vec3<int32_t>
+predict(GPredicter::Mode mode, const Vec3<int32_t> ancestors[3])
 {
-  int nodeCount = 0;
-  _stack.push_back(-1);
+  switch (mode) {
+  case GPredicter::None: return 0;
+  case GPredicter::Delta: return ancestors[0];
+  case GPredicter::Linear2: return 2 * ancestors[0] - ancestors[1];
+  default:
+  case GPredicter::Linear3: return ancestors[0] + ancestors[1] - ancestors[2];
+  }
+}
 
-  while (!_stack.empty()) {
-    auto parentNodeIdx = _stack.back();
-    _stack.pop_back();
+//----------------------------------------------------------------------------
 
-    // allocate point in traversal order (depth first)
-    auto curNodeIdx = nodeCount++;
-    _nodeIdxToParentIdx[curNodeIdx] = parentNodeIdx;
+int
+PredGeomDecoder::decodeTree(Vec3<int32_t>* outputPoints, int maxPoints)
+{
+  // The tree is traversed depth first.  Each node's ancestor positions are
+  // taken from its parent's stack entry rather than by following links
+  // through the decoded points.
+  // NB: the root is the only child of a notional entry without ancestors.
+  StackEntry* stack = _stack.data();
+  int stackSize = 1;
+  stack[0] = StackEntry();
+  stack[0].numChildren = 1;
+
+  int nodeCount = 0;
+  while (stackSize && nodeCount < maxPoints) {
+    // NB: the parent entry may be reused by the current node
+    auto& parent = stack[stackSize - 1];
+    const Vec3<int32_t> ancestors[3] = {
+      parent.ancestors[0], parent.ancestors[1], parent.ancestors[2]};
+    if (!--parent.numChildren)
+      stackSize--;
 
     int numDuplicatePoints = 0;
     if (!_geom_unique_points_flag)
@@ -180,17 +213,19 @@ PredGeomDecoder::decodeTree(Vec3<int32_t>* outputPoints)
     auto mode = decodePredMode();
     auto residual = decodeResidual(mode);
 
-    auto predicter = makePredicter(
-      curNodeIdx, mode, [&](int idx) { return _nodeIdxToParentIdx[idx]; });
-
-    auto pred = predicter.predict(outputPoints, mode);
-    outputPoints[curNodeIdx] = pred + residual;
-
-    for (int i = 0; i < numDuplicatePoints; i++)
-      outputPoints[nodeCount++] = outputPoints[curNodeIdx];
-
-    for (int i = 0; i < numChildren; i++)
-      _stack.push_back(curNodeIdx);
+    // the decoded point (and any duplicates) are written in place
+    auto point = predict(mode, ancestors) + residual;
+    numDuplicatePoints = std::min(numDuplicatePoints, maxPoints - nodeCount);
+    for (int i = 0; i <= numDuplicatePoints; i++)
+      outputPoints[nodeCount++] = point;
+
+    if (numChildren) {
+      auto& entry = stack[stackSize++];
+      entry.ancestors[0] = point;
+      entry.ancestors[1] = ancestors[0];
+      entry.ancestors[2] = ancestors[1];
+      entry.numChildren = numChildren;
+    }
   }
 
   return nodeCount;
@@ -201,13 +236,14 @@ PredGeomDecoder::decodeTree(Vec3<int32_t>* outputPoints)
 int
 PredGeomDecoder::decode(int numPoints, Vec3<int32_t>* outputPoints)
 {
-  _nodeIdxToParentIdx.resize(numPoints);
+  // Each stack entry (excluding the root's) belongs to a decoded point,
+  // bounding the traversal stack size.
+  _stack.resize(numPoints + 1);
 
   int32_t pointCount = 0;
   while (pointCount < numPoints) {
-    auto numSubtreePoints = decodeTree(outputPoints);
-    outputPoints += numSubtreePoints;
-    pointCount += numSubtreePoints;
+    pointCount +=
+      decodeTree(outputPoints + pointCount, numPoints - pointCount);
   }
 
   return pointCount;
@@ -220,10 +256,14 @@ decodePredictiveGeometry(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  PredGeomContexts& ctxtMem,
   EntropyDecoder* aed)
 {
-  PredGeomDecoder dec(gps, aed);
+  PredGeomDecoder dec(gps, ctxtMem, aed);
   dec.decode(gbh.footer.geom_num_points_minus1 + 1, &pointCloud[0]);
+
+  // save the context state for possible use by a later slice
+  ctxtMem = dec.getCtx();
 }
 
 //============================================================================
@@ -38,49 +38,218 @@
 #include "pointset_processing.h"
 
 #include "PCCMisc.h"
+#include "entropyrate.h"
+#include "parallel.h"
 
-#include "nanoflann.hpp"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
 
 namespace pcc {
 
 //============================================================================
 
 namespace {
-  struct NanoflannCloud {
-    std::vector<Vec3<int32_t>> pts;
+  // An incremental spatial index of predicted positions, used to find the
+  // nearest prediction to a query point during prediction tree generation.
+  //
+  // Predictions are binned into a hash of cubic voxels.  A query visits
+  // rings of voxels about the query point until no closer prediction may
+  // exist.  Predictions that are no longer available (their node has no
+  // free child slots) are pruned from the index as they are encountered,
+  // and voxels left empty by pruning are removed.
+  //
+  // The search is bounded: if no available prediction lies within
+  // kMaxSearchRing voxels of the query point, none is returned.
+  class PredictionIndex {
+  public:
+    PredictionIndex(int cellSizeLog2, int capacity);
+
+    void insert(const Vec3<int32_t>& pos, int32_t nodeIdx);
+
+    // Returns the node of the prediction nearest to @query for which
+    // isAvailable(node) is true, or -1 if no such prediction exists within
+    // the search limit.  Equidistant predictions are resolved in favour of
+    // the most recent.
+    template<typename Fn>
+    int32_t findNearest(const Vec3<int32_t>& query, Fn isAvailable);
+
+  private:
+    struct Entry {
+      Vec3<int32_t> pos;
+      int32_t nodeIdx;
+      int32_t next;
+    };
+
+    struct CellHash {
+      size_t operator()(const Vec3<int32_t>& cell) const
+      {
+        return size_t(cell[0]) * 73856093u ^ size_t(cell[1]) * 19349669u
+          ^ size_t(cell[2]) * 83492791u;
+      }
+    };
+
+    struct Nearest {
+      int64_t dist;
+      int32_t entryIdx;
+    };
+
+    // Returns true if the voxel no longer contains any predictions
+    template<typename Fn>
+    bool searchCell(
+      int32_t& head, const Vec3<int32_t>& query, Fn& isAvailable,
+      Nearest& best);
+
+    // Rings of voxels searched before giving up
+    static const int kMaxSearchRing = 8;
+
+    int _cellSizeLog2;
+
+    // The number of indexed predictions that are not known to be pruned
+    int _numEntries;
+
+    // Bounding box of all voxels that have been populated
+    Box3<int32_t> _cellBox;
+
+    // Storage of predictions, linked by voxel
+    std::vector<Entry> _entries;
+
+    // Mapping of voxel position to first entry in that voxel
+    std::unordered_map<Vec3<int32_t>, int32_t, CellHash> _cells;
+  };
+
+  //--------------------------------------------------------------------------
+
+  PredictionIndex::PredictionIndex(int cellSizeLog2, int capacity)
+    : _cellSizeLog2(cellSizeLog2), _numEntries(0)
+  {
+    _cellBox.min = std::numeric_limits<int32_t>::max();
+    _cellBox.max = std::numeric_limits<int32_t>::min();
+    _entries.reserve(capacity);
+    _cells.reserve(capacity);
+  }
 
-    inline size_t kdtree_get_point_count() const { return pts.size(); }
+  //--------------------------------------------------------------------------
 
-    int32_t kdtree_get_pt(const size_t idx, const size_t dim) const
-    {
-      return pts[idx][dim];
+  void
+  PredictionIndex::insert(const Vec3<int32_t>& pos, int32_t nodeIdx)
+  {
+    auto cell = pos >> _cellSizeLog2;
+    for (int k = 0; k < 3; k++) {
+      _cellBox.min[k] = std::min(_cellBox.min[k], cell[k]);
+      _cellBox.max[k] = std::max(_cellBox.max[k], cell[k]);
     }
 
-    template<class BBOX>
-    bool kdtree_get_bbox(BBOX& /* bb */) const
-    {
-      return false;
+    auto it = _cells.emplace(cell, -1).first;
+    _entries.push_back({pos, nodeIdx, it->second});
+    it->second = _entries.size() - 1;
+    _numEntries++;
+  }
+
+  //--------------------------------------------------------------------------
+
+  template<typename Fn>
+  bool
+  PredictionIndex::searchCell(
+    int32_t& head, const Vec3<int32_t>& query, Fn& isAvailable,
+    Nearest& best)
+  {
+    for (int32_t* link = &head; *link >= 0;) {
+      const auto& entry = _entries[*link];
+      if (!isAvailable(entry.nodeIdx)) {
+        *link = entry.next;
+        _numEntries--;
+        continue;
+      }
+
+      auto delta = Vec3<int64_t>(entry.pos) - Vec3<int64_t>(query);
+      auto dist = delta.getNorm2<int64_t>();
+      if (dist < best.dist || (dist == best.dist && *link > best.entryIdx))
+        best = {dist, *link};
+
+      link = &_entries[*link].next;
     }
-  };
-}  // namespace
 
-//============================================================================
+    return head < 0;
+  }
 
-namespace {
-  float estimate(bool bit, AdaptiveBitModel model)
+  //--------------------------------------------------------------------------
+
+  template<typename Fn>
+  int32_t
+  PredictionIndex::findNearest(const Vec3<int32_t>& query, Fn isAvailable)
   {
-    return -log2(dirac::approxSymbolProbability(bit, model) / 128.);
+    Nearest best = {std::numeric_limits<int64_t>::max(), -1};
+    if (!_numEntries)
+      return -1;
+
+    const auto cell0 = query >> _cellSizeLog2;
+    const int64_t cellSize = int64_t(1) << _cellSizeLog2;
+
+    // the search radius required to cover every populated voxel
+    int maxRing = 0;
+    for (int k = 0; k < 3; k++) {
+      maxRing = std::max(maxRing, std::abs(_cellBox.min[k] - cell0[k]));
+      maxRing = std::max(maxRing, std::abs(_cellBox.max[k] - cell0[k]));
+    }
+
+    for (int r = 0; r <= maxRing; r++) {
+      // give up on sparsely populated regions
+      if (r > kMaxSearchRing && best.entryIdx < 0)
+        break;
+
+      // visit each voxel in the shell at Chebyshev distance r
+      Vec3<int32_t> cell;
+      for (int dx = -r; dx <= r; dx++) {
+        cell[0] = cell0[0] + dx;
+        if (cell[0] < _cellBox.min[0] || cell[0] > _cellBox.max[0])
+          continue;
+
+        for (int dy = -r; dy <= r; dy++) {
+          cell[1] = cell0[1] + dy;
+          if (cell[1] < _cellBox.min[1] || cell[1] > _cellBox.max[1])
+            continue;
+
+          bool onShell = std::abs(dx) == r || std::abs(dy) == r;
+          int dzStep = onShell ? 1 : std::max(1, 2 * r);
+          for (int dz = -r; dz <= r; dz += dzStep) {
+            cell[2] = cell0[2] + dz;
+            if (cell[2] < _cellBox.min[2] || cell[2] > _cellBox.max[2])
+              continue;
+
+            auto it = _cells.find(cell);
+            if (it == _cells.end())
+              continue;
+
+            if (searchCell(it->second, query, isAvailable, best))
+              _cells.erase(it);
+          }
+        }
+      }
+
+      // any prediction beyond this shell is at least r * cellSize + 1 away
+      int64_t bound = r * cellSize + 1;
+      if (best.entryIdx >= 0 && best.dist < bound * bound)
+        break;
+    }
+
+    return best.entryIdx < 0 ? -1 : _entries[best.entryIdx].nodeIdx;
   }
 }  // namespace
 
 //============================================================================
 
-class PredGeomEncoder : public PredGeomCodec {
+class PredGeomEncoder : protected PredGeomContexts {
 public:
   PredGeomEncoder(const PredGeomEncoder&) = delete;
   PredGeomEncoder& operator=(const PredGeomEncoder&) = delete;
 
-  PredGeomEncoder(const GeometryParameterSet&, EntropyEncoder* aec);
+  PredGeomEncoder(
+    const GeometryParameterSet&,
+    const PredGeomContexts& ctxtMem,
+    EntropyEncoder* aec);
+
+  const PredGeomContexts& getCtx() const { return *this; }
 
   void encode(
     const Vec3<int32_t>* cloud,
@@ -100,7 +269,8 @@ public:
   void encodePredMode(GPredicter::Mode mode);
   void encodeResidual(const Vec3<int32_t>& residual, GPredicter::Mode mode);
 
-  float estimateBits(GPredicter::Mode mode, const Vec3<int32_t>& residual);
+  // Estimate of the rate (in units of 2^-kRateFracBits) to code a node
+  int estimateBits(GPredicter::Mode mode, const Vec3<int32_t>& residual);
 
 private:
   EntropyEncoder* _aec;
@@ -111,8 +281,11 @@ private:
 //============================================================================
 
 PredGeomEncoder::PredGeomEncoder(
-  const GeometryParameterSet& gps, EntropyEncoder* aec)
-  : _aec(aec), _geom_unique_points_flag(gps.geom_unique_points_flag)
+  const GeometryParameterSet& gps,
+  const PredGeomContexts& ctxtMem,
+  EntropyEncoder* aec)
+  : PredGeomContexts(ctxtMem)
+  , _aec(aec), _geom_unique_points_flag(gps.geom_unique_points_flag)
 {
   _stack.reserve(1024);
 }
@@ -177,48 +350,48 @@ PredGeomEncoder::encodeResidual(
     if (!k)
       ctxIdx = (numBits + 1) >> 1;
 
-    --numBits;
-    for (int32_t i = 0; i < numBits; ++i)
-      _aec->encode((value >> i) & 1, _ctxBypass);
+    // NB: the remaining bits are coded lsb first
+    if (--numBits > 0)
+      _aec->encodeBypass(reverseBits(value, numBits), numBits);
   }
 }
 
 //----------------------------------------------------------------------------
 
-float
+int
 PredGeomEncoder::estimateBits(
   GPredicter::Mode mode, const Vec3<int32_t>& residual)
 {
   int iMode = int(mode);
-  float bits = 0.;
-  bits += estimate(iMode & 1, _ctxPredMode[0]);
-  bits += estimate((iMode >> 1) & 1, _ctxPredMode[1 + (iMode & 1)]);
+  int bits = 0;
+  bits += rateOfBit(iMode & 1, _ctxPredMode[0]);
+  bits += rateOfBit((iMode >> 1) & 1, _ctxPredMode[1 + (iMode & 1)]);
 
   for (int k = 0, ctxIdx = 0; k < 3; k++) {
     const auto res = residual[k];
     const bool isZero = res == 0;
-    bits += estimate(isZero, _ctxIsZero[k]);
+    bits += rateOfBit(isZero, _ctxIsZero[k]);
     if (isZero)
       continue;
 
     if (iMode > 0) {
-      bits += estimate(res > 0, _ctxSign[k]);
+      bits += rateOfBit(res > 0, _ctxSign[k]);
     }
 
     int32_t value = abs(res) - 1;
     int32_t numBits = 1 + ilog2(uint32_t(value));
 
     AdaptiveBitModel* ctxs = _ctxNumBits[ctxIdx][k];
-    bits += estimate(numBits & 1, ctxs[0]);
-    bits += estimate((numBits >> 1) & 1, ctxs[1 + (numBits & 1)]);
-    bits += estimate((numBits >> 2) & 1, ctxs[3 + (numBits & 3)]);
-    bits += estimate((numBits >> 3) & 1, ctxs[7 + (numBits & 7)]);
-    bits += estimate((numBits >> 4) & 1, ctxs[15 + (numBits & 15)]);
+    bits += rateOfBit(numBits & 1, ctxs[0]);
+    bits += rateOfBit((numBits >> 1) & 1, ctxs[1 + (numBits & 1)]);
+    bits += rateOfBit((numBits >> 2) & 1, ctxs[3 + (numBits & 3)]);
+    bits += rateOfBit((numBits >> 3) & 1, ctxs[7 + (numBits & 7)]);
+    bits += rateOfBit((numBits >> 4) & 1, ctxs[15 + (numBits & 15)]);
 
     if (!k)
       ctxIdx = (numBits + 1) >> 1;
 
-    bits += numBits - 1;
+    bits += (numBits - 1) << kRateFracBits;
   }
 
   return bits;
@@ -245,7 +418,7 @@ PredGeomEncoder::encodeTree(
     const auto point = cloud[nodeIdx];
 
     struct {
-      float bits;
+      int bits;
       GPredicter::Mode mode;
       Vec3<int32_t> residual;
     } best;
@@ -328,26 +501,51 @@ generateGeomPredictionTree(
   //  - For each point, find the node with the nearest prediction
   //    with empty children slots:
   //     - generate new predictions based upon the current point and
-  //       insert into the search tree
-  using NanoflannKdTreeT = nanoflann::KDTreeSingleIndexDynamicAdaptor<
-    nanoflann::L2_Simple_Adaptor<int32_t, NanoflannCloud, int64_t>,
-    NanoflannCloud, 3, int32_t>;
+  //       insert into the search index
+  //
+  // NB: the parent is the nearest prediction with a free child slot within
+  // the search limit of the index, otherwise the node has no parent.  This
+  // differs from considering only the three nearest predictions (of any
+  // node) and so may produce a different tree to a kd-tree search.
+
+  // The index voxel size is chosen such that each occupied voxel
+  // contains roughly kPtsPerCell points.  The number of occupied voxels
+  // at each size is determined from the points in Morton order.
+  const int kPtsPerCell = 4;
+  int cellSizeLog2 = 0;
+  if (pointCount > 1) {
+    std::vector<int64_t> mortonCodes(pointCount);
+    for (int i = 0; i < pointCount; i++)
+      mortonCodes[i] = mortonAddr(begin[i]);
+    std::sort(mortonCodes.begin(), mortonCodes.end());
+
+    // numCells[s] is the number of voxel boundaries of size 2^s crossed
+    int numCells[22] = {};
+    for (int i = 1; i < pointCount; i++) {
+      auto diff = uint64_t(mortonCodes[i] ^ mortonCodes[i - 1]);
+      if (diff)
+        numCells[ilog2(diff) / 3]++;
+    }
+    for (int s = 20; s >= 0; s--)
+      numCells[s] += numCells[s + 1];
 
-  using NanoflannResultT = nanoflann::KNNResultSet<int64_t, int32_t>;
+    while (cellSizeLog2 < 21
+           && (numCells[cellSizeLog2 + 1] + 1) * kPtsPerCell >= pointCount)
+      cellSizeLog2++;
+  }
 
   // the predicted point positions, used for searching.
   // each node will generate up to three predicted positions
-  NanoflannCloud predictedPoints;
-  NanoflannKdTreeT predictedPointsTree(3, predictedPoints);
-  predictedPoints.pts.reserve(3 * pointCount);
-
-  // mapping of predictedPoints indicies to prediction tree nodes
-  std::vector<int32_t> predictedPointIdxToNodeIdx;
-  predictedPointIdxToNodeIdx.reserve(3 * pointCount);
+  PredictionIndex predictedPoints(cellSizeLog2, 3 * pointCount);
 
   // the prediction tree, one node for each point
   std::vector<GNode> nodes(pointCount);
 
+  // predictions of nodes without free child slots are not candidates
+  auto isAvailable = [&](int32_t nodeIdx) {
+    return nodes[nodeIdx].childrenCount < GNode::MaxChildrenCount;
+  };
+
   for (int nodeIdx = 0, nodeIdxN; nodeIdx < pointCount; nodeIdx = nodeIdxN) {
     auto& node = nodes[nodeIdx];
     auto queryPoint = begin[nodeIdx];
@@ -362,29 +560,14 @@ generateGeomPredictionTree(
       node.numDups++;
     }
 
-    int32_t nnPredictedPointIdx[GNode::MaxChildrenCount];
-    int64_t nnPredictedDist[GNode::MaxChildrenCount];
-    NanoflannResultT resultSet(GNode::MaxChildrenCount);
-
-    resultSet.init(nnPredictedPointIdx, nnPredictedDist);
-    predictedPointsTree.findNeighbors(resultSet, &queryPoint[0], {});
-
     // find a suitable parent.  default case: node has no parent
-    node.parent = -1;
+    node.parent = predictedPoints.findNearest(queryPoint, isAvailable);
     node.childrenCount = 0;
-    for (size_t r = 0; r < resultSet.size(); ++r) {
-      auto parentIdx = predictedPointIdxToNodeIdx[nnPredictedPointIdx[r]];
-      auto& pnode = nodes[parentIdx];
-      if (pnode.childrenCount < GNode::MaxChildrenCount) {
-        node.parent = parentIdx;
-        pnode.children[pnode.childrenCount++] = nodeIdx;
-        break;
-      }
+    if (node.parent >= 0) {
+      auto& pnode = nodes[node.parent];
+      pnode.children[pnode.childrenCount++] = nodeIdx;
     }
 
-    // update the search tree with new predictions from this point
-    const auto size0 = predictedPoints.pts.size();
-
     // set the indicies for prediction
     GPredicter predicter;
     predicter.index[0] = nodeIdx;
@@ -392,6 +575,7 @@ generateGeomPredictionTree(
     if (predicter.index[1] >= 0)
       predicter.index[2] = nodes[predicter.index[1]].parent;
 
+    // update the search index with new predictions from this point
     for (int iMode = 0; iMode < 4; iMode++) {
       GPredicter::Mode mode = GPredicter::Mode(iMode);
 
@@ -402,14 +586,8 @@ generateGeomPredictionTree(
       if (!predicter.isValid(mode))
         continue;
 
-      auto prediction = predicter.predict(begin, mode);
-      predictedPointIdxToNodeIdx.push_back(nodeIdx);
-      predictedPoints.pts.push_back(prediction);
+      predictedPoints.insert(predicter.predict(begin, mode), nodeIdx);
     }
-
-    const auto size1 = predictedPoints.pts.size();
-    if (size0 != size1)
-      predictedPointsTree.addPoints(size0, size1 - 1);
   }
 
   return nodes;
@@ -439,6 +617,7 @@ encodePredictiveGeometry(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   PCCPointSet3& cloud,
+  PredGeomContexts& ctxtMem,
   EntropyEncoder* arithmeticEncoder)
 {
   auto numPoints = cloud.getPointCount();
@@ -454,18 +633,19 @@ encodePredictiveGeometry(
   // src indexes in coded order
   std::vector<int32_t> codedOrder(numPoints, -1);
 
-  // determine each geometry tree, and encode.  Size of trees is limited
+  // the point range of each geometry tree.  Size of trees is limited
   // by maxPtsPerTree.
-  PredGeomEncoder enc(gps, arithmeticEncoder);
-  int maxPtsPerTree = std::min(opt.maxPtsPerTree, int(numPoints));
-  ;
-  for (int i = 0; i < numPoints;) {
+  int maxPtsPerTree = std::max(1, std::min(opt.maxPtsPerTree, int(numPoints)));
+  int numTrees = (numPoints + maxPtsPerTree - 1) / maxPtsPerTree;
+  std::vector<std::vector<GNode>> trees(numTrees);
+
+  // first, put the points of each tree into a sorted order and build
+  // the tree.  Trees are independent and may be built concurrently.
+  // NB: sorting can significantly improve the constructed tree
+  parallelFor(opt.numThreads, 0, numTrees, [&](int treeIdx) {
+    int i = treeIdx * maxPtsPerTree;
     int iEnd = std::min(i + maxPtsPerTree, int(numPoints));
-    auto* begin = &cloud[i];
-    auto* end = &cloud[0] + iEnd;
 
-    // first, put the points in this tree into a sorted order
-    // this can significantly improve the constructed tree
     if (opt.sortMode == PredGeomEncOpts::kSortMorton)
       mortonSort(cloud, i, iEnd, gbh.maxRootNodeDimLog2);
     else if (opt.sortMode == PredGeomEncOpts::kSortAzimuth)
@@ -473,9 +653,17 @@ encodePredictiveGeometry(
     else if (opt.sortMode == PredGeomEncOpts::kSortRadius)
       sortByRadius(cloud, i, iEnd, origin);
 
-    // then build and encode the tree
-    auto nodes = generateGeomPredictionTree(gps, gbh, begin, end);
-    enc.encode(begin, nodes.data(), nodes.size(), codedOrder.data() + i);
+    trees[treeIdx] =
+      generateGeomPredictionTree(gps, gbh, &cloud[i], &cloud[0] + iEnd);
+  });
+
+  // then encode each tree in turn
+  PredGeomEncoder enc(gps, ctxtMem, arithmeticEncoder);
+  for (int treeIdx = 0, i = 0; treeIdx < numTrees; treeIdx++) {
+    auto& nodes = trees[treeIdx];
+    int iEnd = i + nodes.size();
+    enc.encode(&cloud[i], nodes.data(), nodes.size(), codedOrder.data() + i);
+    std::vector<GNode>().swap(nodes);
 
     // put points in output cloud in decoded order
     for (auto iBegin = i; i < iEnd; i++) {
@@ -490,6 +678,9 @@ encodePredictiveGeometry(
   }
 
   swap(cloud, outCloud);
+
+  // save the context state for possible use by a later slice
+  ctxtMem = enc.getCtx();
 }
 
 //============================================================================
@@ -92,12 +92,14 @@ decodeGeometryTrisoup(
   const GeometryParameterSet& gps,
   const GeometryBrickHeader& gbh,
   PCCPointSet3& pointCloud,
+  GeometryOctreeContexts& ctxtMem,
   std::vector<std::unique_ptr<EntropyDecoder>>& arithmeticDecoders)
 {
   // trisoup uses octree coding until reaching the triangulation level.
   // todo(df): pass trisoup node size rather than 0?
   pcc::ringbuf<PCCOctree3Node> nodes;
-  decodeGeometryOctree(gps, gbh, 0, pointCloud, arithmeticDecoders, &nodes);
+  decodeGeometryOctree(
+    gps, gbh, 0, pointCloud, ctxtMem, arithmeticDecoders, &nodes, nullptr);
 
   // resume decoding with the last decoder
   auto arithmeticDecoder = arithmeticDecoders.back().get();
@@ -312,6 +312,11 @@ struct SequenceParameterSet {
   // Controls whether bypass bins are written to a seperate sub-stream, or
   // encoded as ep bins via CABAC.
   bool cabac_bypass_stream_enabled_flag;
+
+  // Permits slices to inherit the entropy contexts of a previous slice.
+  // Signalled in the sps extension: sps_extension_flag is set only when
+  // this flag is, and is followed by it.
+  bool entropy_continuation_enabled_flag;
 };
 
 //============================================================================
@@ -421,6 +426,11 @@ struct GeometryBrickHeader {
   int geom_slice_id;
   int frame_idx;
 
+  // Indicates that the entropy contexts are initialised from the state at
+  // the end of the slice prev_slice_id.
+  bool entropy_continuation_flag;
+  int prev_slice_id;
+
   // Origin of the reconstructed geometry, relative to sequence bounding box
   // (in stv axis order).
   Vec3<int> geomBoxOrigin;
@@ -397,8 +397,12 @@ write(const SequenceParameterSet& sps)
   bs.writeUn(3, sps.geometry_axis_order);
   bs.write(sps.cabac_bypass_stream_enabled_flag);
 
-  bool sps_extension_flag = false;
+  // the extension is only present when an extension tool is enabled,
+  // leaving the baseline sps unchanged
+  bool sps_extension_flag = sps.entropy_continuation_enabled_flag;
   bs.write(sps_extension_flag);
+  if (sps_extension_flag)
+    bs.write(sps.entropy_continuation_enabled_flag);
   bs.byteAlign();
 
   return buf;
@@ -495,11 +499,10 @@ parseSps(const PayloadBuffer& buf)
   bs.readUn(3, &sps.geometry_axis_order);
   bs.read(&sps.cabac_bypass_stream_enabled_flag);
 
+  sps.entropy_continuation_enabled_flag = false;
   bool sps_extension_flag = bs.read();
-  if (sps_extension_flag) {
-    // todo(df): sps_extension_data;
-    assert(!sps_extension_flag);
-  }
+  if (sps_extension_flag)
+    bs.read(&sps.entropy_continuation_enabled_flag);
   bs.byteAlign();
 
   return sps;
@@ -905,6 +908,12 @@ write(
   bs.writeUe(gbh.geom_slice_id);
   bs.writeUn(sps.log2_max_frame_idx, gbh.frame_idx);
 
+  if (sps.entropy_continuation_enabled_flag) {
+    bs.write(gbh.entropy_continuation_flag);
+    if (gbh.entropy_continuation_flag)
+      bs.writeUe(gbh.prev_slice_id);
+  }
+
   int geomBoxLog2Scale = gbh.geomBoxLog2Scale(gps);
   auto geom_box_origin = toXyz(sps.geometry_axis_order, gbh.geomBoxOrigin);
   geom_box_origin.x() >>= geomBoxLog2Scale;
@@ -965,6 +974,13 @@ parseGbh(
   bs.readUe(&gbh.geom_slice_id);
   bs.readUn(sps.log2_max_frame_idx, &gbh.frame_idx);
 
+  gbh.entropy_continuation_flag = false;
+  if (sps.entropy_continuation_enabled_flag) {
+    bs.read(&gbh.entropy_continuation_flag);
+    if (gbh.entropy_continuation_flag)
+      bs.readUe(&gbh.prev_slice_id);
+  }
+
   if (gps.geom_box_log2_scale_present_flag)
     bs.readUe(&gbh.geom_box_log2_scale);
 
@@ -975,6 +991,8 @@ parseGbh(
   gbh.geomBoxOrigin = fromXyz(sps.geometry_axis_order, geom_box_origin);
   gbh.geomBoxOrigin *= 1 << gbh.geomBoxLog2Scale(gps);
 
+  // NB: predictive geometry is coded using a single entropy stream
+  gbh.geom_stream_cnt_minus1 = 0;
   if (!gps.predgeom_enabled_flag) {
     int tree_depth_minus1;
     bs.readUe(&tree_depth_minus1);
@@ -0,0 +1,233 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "io_points.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace pcc {
+
+//============================================================================
+
+static const int kPointFrameHeaderLen = 8;
+
+// The maximum number of point records read at once
+static const uint32_t kPointFrameChunkLen = 1 << 16;
+
+//----------------------------------------------------------------------------
+// Determine the index of each internal position component in the xyz
+// ordered point record.
+
+static Vec3<int>
+xyzIndexes(const ply::PropertyNameMap& propertyNames)
+{
+  Vec3<int> idx;
+  for (int k = 0; k < 3; k++)
+    idx[k] = propertyNames.position[k][0] - 'x';
+  return idx;
+}
+
+//----------------------------------------------------------------------------
+
+static int
+pointRecordLen(uint32_t flags)
+{
+  int len = 3 * 4;
+  if (flags & kPointFrameHasColour)
+    len += 3;
+  if (flags & kPointFrameHasReflectance)
+    len += 2;
+  return len;
+}
+
+//----------------------------------------------------------------------------
+
+static char*
+putU32(char* p, uint32_t val)
+{
+  *p++ = char(val >> 0);
+  *p++ = char(val >> 8);
+  *p++ = char(val >> 16);
+  *p++ = char(val >> 24);
+  return p;
+}
+
+//----------------------------------------------------------------------------
+
+static const char*
+getU32(const char* p, uint32_t* val)
+{
+  *val = uint32_t(uint8_t(p[0])) << 0 | uint32_t(uint8_t(p[1])) << 8
+    | uint32_t(uint8_t(p[2])) << 16 | uint32_t(uint8_t(p[3])) << 24;
+  return p + 4;
+}
+
+//============================================================================
+
+std::ostream&
+writePointFrame(
+  const PCCPointSet3& cloud,
+  const ply::PropertyNameMap& propertyNames,
+  double positionScale,
+  Vec3<double> positionOffset,
+  std::ostream& os)
+{
+  uint32_t flags = 0;
+  if (cloud.hasColors())
+    flags |= kPointFrameHasColour;
+  if (cloud.hasReflectances())
+    flags |= kPointFrameHasReflectance;
+
+  const auto xyzIdx = xyzIndexes(propertyNames);
+  const size_t pointCount = cloud.getPointCount();
+  const int recordLen = pointRecordLen(flags);
+
+  // The frame is assembled in memory and written with a single call
+  std::vector<char> buf(kPointFrameHeaderLen + pointCount * recordLen);
+  char* p = buf.data();
+  p = putU32(p, uint32_t(pointCount));
+  p = putU32(p, flags);
+
+  for (size_t i = 0; i < pointCount; i++) {
+    Vec3<double> position = cloud[i] * positionScale + positionOffset;
+
+    Vec3<int32_t> xyz;
+    for (int k = 0; k < 3; k++)
+      xyz[xyzIdx[k]] = int32_t(std::round(position[k]));
+
+    for (int k = 0; k < 3; k++)
+      p = putU32(p, uint32_t(xyz[k]));
+
+    if (cloud.hasColors()) {
+      // NB: the internal representation is gbr
+      const Vec3<attr_t>& color = cloud.getColor(i);
+      *p++ = char(color[2]);
+      *p++ = char(color[0]);
+      *p++ = char(color[1]);
+    }
+
+    if (cloud.hasReflectances()) {
+      attr_t reflectance = cloud.getReflectance(i);
+      *p++ = char(reflectance);
+      *p++ = char(reflectance >> 8);
+    }
+  }
+
+  os.write(buf.data(), buf.size());
+  return os;
+}
+
+//============================================================================
+
+std::istream&
+readPointFrame(
+  std::istream& is,
+  const ply::PropertyNameMap& propertyNames,
+  PCCPointSet3* cloud)
+{
+  char hdr[kPointFrameHeaderLen];
+  if (!is.read(hdr, kPointFrameHeaderLen))
+    return is;
+
+  uint32_t pointCount;
+  uint32_t flags;
+  getU32(getU32(hdr, &pointCount), &flags);
+
+  // reject frames using unknown features
+  if (flags & ~uint32_t(kPointFrameHasColour | kPointFrameHasReflectance)) {
+    is.setstate(std::ios::failbit);
+    return is;
+  }
+
+  const auto xyzIdx = xyzIndexes(propertyNames);
+  const int recordLen = pointRecordLen(flags);
+
+  cloud->clear();
+  cloud->addRemoveAttributes(
+    flags & kPointFrameHasColour, flags & kPointFrameHasReflectance);
+  cloud->removeFrameIndex();
+
+  // NB: the point count is not trusted.  The point records are read in
+  //     bounded chunks such that a corrupt header cannot cause a large
+  //     allocation before the end of the input is reached.
+  const uint32_t chunkLen = std::min(pointCount, kPointFrameChunkLen);
+  std::vector<char> buf(size_t(chunkLen) * recordLen);
+
+  for (uint32_t start = 0; start < pointCount;) {
+    uint32_t end = start + std::min(pointCount - start, chunkLen);
+    if (!is.read(buf.data(), size_t(end - start) * recordLen))
+      return is;
+
+    cloud->resize(end);
+    const char* p = buf.data();
+    for (size_t i = start; i < end; i++) {
+      Vec3<int32_t> xyz;
+      for (int k = 0; k < 3; k++) {
+        uint32_t val;
+        p = getU32(p, &val);
+        xyz[k] = int32_t(val);
+      }
+
+      auto& position = (*cloud)[i];
+      for (int k = 0; k < 3; k++)
+        position[k] = xyz[xyzIdx[k]];
+
+      if (cloud->hasColors()) {
+        // NB: the internal representation is gbr
+        auto& color = cloud->getColor(i);
+        color[2] = uint8_t(*p++);
+        color[0] = uint8_t(*p++);
+        color[1] = uint8_t(*p++);
+      }
+
+      if (cloud->hasReflectances()) {
+        attr_t reflectance = uint8_t(p[0]) | uint8_t(p[1]) << 8;
+        cloud->setReflectance(i, reflectance);
+        p += 2;
+      }
+    }
+
+    start = end;
+  }
+
+  return is;
+}
+
+//============================================================================
+
+}  // namespace pcc
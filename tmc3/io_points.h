@@ -0,0 +1,97 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "PCCMath.h"
+#include "PCCPointSet.h"
+#include "ply.h"
+
+#include <istream>
+#include <ostream>
+
+namespace pcc {
+
+//============================================================================
+// Raw point frames, used when streaming point clouds through pipes.
+//
+// Each frame consists of an eight byte header followed by pointCount
+// fixed-length point records.  All values are little endian:
+//
+//   u32 pointCount
+//   u32 flags          bit 0: colour present, bit 1: reflectance present
+//   pointCount * {
+//     i32 x, i32 y, i32 z
+//     u8 red, u8 green, u8 blue   (if colour present)
+//     u16 reflectance             (if reflectance present)
+//   }
+//
+// The positions are stored in x, y, z order, with the mapping to the
+// internal axis order determined by the property names.
+
+enum PointFrameFlags
+{
+  kPointFrameHasColour = 1 << 0,
+  kPointFrameHasReflectance = 1 << 1,
+};
+
+//----------------------------------------------------------------------------
+// Write @a cloud as a single point frame.  Each point position, pt, is
+// converted prior to writing by:
+//  pt' = round(pt * positionScale + positionOffset)
+//
+// NB: attribute values are truncated to the width of the record fields
+//     (8 bits for colour and 16 bits for reflectance).
+
+std::ostream& writePointFrame(
+  const PCCPointSet3& cloud,
+  const ply::PropertyNameMap& propertyNames,
+  double positionScale,
+  Vec3<double> positionOffset,
+  std::ostream& os);
+
+//----------------------------------------------------------------------------
+// Read a single point frame into @a cloud.  The stream is put into a
+// failed state if the end of input is reached before the frame is complete,
+// or if the frame uses unknown flags.
+
+std::istream& readPointFrame(
+  std::istream& is,
+  const ply::PropertyNameMap& propertyNames,
+  PCCPointSet3* cloud);
+
+//============================================================================
+
+}  // namespace pcc
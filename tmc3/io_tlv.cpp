@@ -78,6 +78,43 @@ readTlv(std::istream& is, PayloadBuffer* buf)
   return is;
 }
 
+//============================================================================
+// NB: the encapsulation must match writeTlv().
+
+void
+appendTlv(const PayloadBuffer& buf, std::vector<char>* out)
+{
+  uint32_t length = uint32_t(buf.size());
+
+  out->push_back(char(buf.type));
+  out->push_back(char(length >> 24));
+  out->push_back(char(length >> 16));
+  out->push_back(char(length >> 8));
+  out->push_back(char(length >> 0));
+
+  out->insert(out->end(), buf.begin(), buf.end());
+}
+
+//----------------------------------------------------------------------------
+
+size_t
+readTlv(const char* data, size_t len, PayloadBuffer* buf)
+{
+  if (len < kTlvHeaderLen)
+    return 0;
+
+  uint32_t length = 0;
+  for (int i = 1; i < kTlvHeaderLen; i++)
+    length = (length << 8) | uint8_t(data[i]);
+
+  if (len - kTlvHeaderLen < length)
+    return 0;
+
+  buf->type = PayloadType(uint8_t(data[0]));
+  buf->assign(data + kTlvHeaderLen, data + kTlvHeaderLen + length);
+  return kTlvHeaderLen + length;
+}
+
 //============================================================================
 
 }  // namespace pcc
\ No newline at end of file
@@ -37,8 +37,10 @@
 
 #include "PayloadBuffer.h"
 
+#include <cstddef>
 #include <istream>
 #include <ostream>
+#include <vector>
 
 namespace pcc {
 
@@ -48,6 +50,18 @@ std::ostream& writeTlv(const PayloadBuffer& buf, std::ostream& os);
 
 std::istream& readTlv(std::istream& is, PayloadBuffer* buf);
 
+//----------------------------------------------------------------------------
+// In-memory variants of the above.
+
+// The length of the TLV header (type and length fields)
+const int kTlvHeaderLen = 5;
+
+void appendTlv(const PayloadBuffer& buf, std::vector<char>* out);
+
+// Reads a single TLV encapsulated data unit from data.
+// Returns the number of bytes consumed, or 0 if the data unit is incomplete.
+size_t readTlv(const char* data, size_t len, PayloadBuffer* buf);
+
 //============================================================================
 
 }  // namespace pcc
\ No newline at end of file
@@ -0,0 +1,136 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "io_tlv_writer.h"
+
+#include <cstdint>
+
+#include "io_tlv.h"
+
+namespace pcc {
+
+//============================================================================
+
+AsyncTlvWriter::AsyncTlvWriter(std::ostream& os)
+  : _os(os)
+  , _busy(false)
+  , _exit(false)
+  , _error(false)
+  , _length(0)
+  , _thread(&AsyncTlvWriter::run, this)
+{}
+
+//----------------------------------------------------------------------------
+
+AsyncTlvWriter::~AsyncTlvWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _exit = true;
+  }
+  _cvPending.notify_one();
+  _thread.join();
+}
+
+//----------------------------------------------------------------------------
+
+size_t
+AsyncTlvWriter::write(PayloadBuffer&& buf)
+{
+  size_t len = kTlvHeaderLen + buf.size();
+  _length += len;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.emplace_back(std::move(buf));
+  }
+  _cvPending.notify_one();
+
+  return len;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+AsyncTlvWriter::flush()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _cvIdle.wait(lock, [&] { return _queue.empty() && !_busy; });
+
+  // NB: the writer thread is idle and will not access the stream
+  if (!_os.flush())
+    _error = true;
+
+  return !_error;
+}
+
+//----------------------------------------------------------------------------
+
+void
+AsyncTlvWriter::run()
+{
+  std::vector<PayloadBuffer> work;
+  std::vector<char> chunk;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _cvPending.wait(lock, [&] { return !_queue.empty() || _exit; });
+
+    // NB: the queue is always drained before exiting
+    if (_queue.empty())
+      break;
+
+    std::swap(work, _queue);
+    _busy = true;
+    lock.unlock();
+
+    chunk.clear();
+    for (const auto& buf : work)
+      appendTlv(buf, &chunk);
+    work.clear();
+
+    bool ok = bool(_os.write(chunk.data(), chunk.size()));
+
+    lock.lock();
+    _error |= !ok;
+    _busy = false;
+    if (_queue.empty())
+      _cvIdle.notify_all();
+  }
+}
+
+//============================================================================
+
+}  // namespace pcc
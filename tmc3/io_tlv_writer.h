@@ -0,0 +1,109 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "PayloadBuffer.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace pcc {
+
+//============================================================================
+// Writes TLV encapsulated data units to an output stream from a
+// background thread.
+//
+// Ownership of each PayloadBuffer is transferred to the writer.  All data
+// units queued while a previous write is in progress are coalesced into
+// a single write to the output stream.
+
+class AsyncTlvWriter {
+public:
+  explicit AsyncTlvWriter(std::ostream& os);
+  AsyncTlvWriter(const AsyncTlvWriter&) = delete;
+  AsyncTlvWriter& operator=(const AsyncTlvWriter&) = delete;
+
+  // Any queued data units are written prior to destruction.
+  ~AsyncTlvWriter();
+
+  // Queue @a buf for output.
+  // @returns the number of bytes occupied by the encapsulated data unit.
+  size_t write(PayloadBuffer&& buf);
+
+  // Wait until all queued data units have been written and the output
+  // stream has been flushed.
+  // @returns false if an error occurred writing to the output stream.
+  bool flush();
+
+  // The total number of bytes queued for output since construction.
+  size_t length() const { return _length; }
+
+private:
+  void run();
+
+  std::ostream& _os;
+
+  std::mutex _mutex;
+
+  // Signalled when data units are queued, or the writer is to exit
+  std::condition_variable _cvPending;
+
+  // Signalled when all queued data units have been written
+  std::condition_variable _cvIdle;
+
+  // Data units waiting to be written
+  std::vector<PayloadBuffer> _queue;
+
+  // The background thread is writing data units removed from the queue
+  bool _busy;
+
+  bool _exit;
+  bool _error;
+
+  // NB: only accessed by the producer
+  size_t _length;
+
+  // NB: the thread is started once all other members are initialised
+  std::thread _thread;
+};
+
+//============================================================================
+
+}  // namespace pcc
@@ -0,0 +1,632 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libtmc3.h"
+
+#include <cmath>
+#include <exception>
+#include <sstream>
+
+#include "PCCTMC3Decoder.h"
+#include "PCCTMC3Encoder.h"
+#include "codec_options.h"
+#include "io_tlv.h"
+#include "ply.h"
+#include "pointset_processing.h"
+#include "program_options_lite.h"
+
+using namespace pcc;
+namespace po = df::program_options_lite;
+
+namespace tmc3 {
+
+//============================================================================
+// Collects option parsing errors rather than reporting them on stderr.
+
+struct ErrorCollector : public po::ErrorReporter {
+  std::ostream& error(const std::string&) override
+  {
+    is_errored = true;
+    return msgs;
+  }
+
+  std::ostream& warn(const std::string&) override { return ignored; }
+
+  std::ostringstream msgs;
+  std::ostream ignored{nullptr};
+};
+
+//----------------------------------------------------------------------------
+// Set a single option as if it were given on the command line.
+
+static bool
+setOption(
+  po::Options& opts,
+  const std::string& name,
+  const std::string& value,
+  std::string* error)
+{
+  std::string arg = "--" + name + "=" + value;
+  const char* argv[] = {"", arg.c_str()};
+
+  ErrorCollector err;
+  try {
+    po::scanArgv(opts, 2, argv, err);
+  }
+  catch (po::ParseFailure& e) {
+    *error = "Error parsing option \"" + e.arg + "\" with argument \""
+      + e.val + "\"";
+    return false;
+  }
+
+  if (err.is_errored) {
+    *error = err.msgs.str();
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// The scale factor applied to output positions (cf. tmc3 outputScale).
+
+static double
+outputScale(const SequenceParameterSet& sps, float outputResolution)
+{
+  switch (sps.seq_geom_scale_unit_flag) {
+  case ScaleUnit::kPointsPerMetre:
+    return outputResolution > 0 ? outputResolution / sps.seq_geom_scale : 1.;
+
+  case ScaleUnit::kDimensionless: return 1. / sps.seq_geom_scale;
+  }
+  return 1.;
+}
+
+//----------------------------------------------------------------------------
+// Determine the index of each internal position component in the xyz
+// ordered arrays.
+
+static Vec3<int>
+xyzIndexes(AxisOrder order)
+{
+  auto names = axisOrderToPropertyNames(order);
+
+  Vec3<int> idx;
+  for (int k = 0; k < 3; k++)
+    idx[k] = names[k][0] - 'x';
+  return idx;
+}
+
+//----------------------------------------------------------------------------
+
+static void
+toPointSet(const PointFrameView& frame, AxisOrder order, PCCPointSet3* cloud)
+{
+  const auto xyzIdx = xyzIndexes(order);
+  const size_t pointCount = frame.numPoints;
+
+  cloud->clear();
+  cloud->addRemoveAttributes(frame.rgb, frame.reflectance);
+  cloud->removeFrameIndex();
+  cloud->resize(pointCount);
+
+  for (size_t i = 0; i < pointCount; i++) {
+    const int32_t* xyz = &frame.xyz[3 * i];
+    auto& position = (*cloud)[i];
+    for (int k = 0; k < 3; k++)
+      position[k] = xyz[xyzIdx[k]];
+
+    if (frame.rgb) {
+      // NB: the internal representation is gbr
+      const uint8_t* rgb = &frame.rgb[3 * i];
+      auto& color = cloud->getColor(i);
+      color[0] = rgb[1];
+      color[1] = rgb[2];
+      color[2] = rgb[0];
+    }
+
+    if (frame.reflectance)
+      cloud->setReflectance(i, frame.reflectance[i]);
+  }
+}
+
+//----------------------------------------------------------------------------
+// Each output position, pt, is converted by:
+//  pt' = round(pt * positionScale + positionOffset)
+
+static void
+fromPointSet(
+  const PCCPointSet3& cloud,
+  AxisOrder order,
+  double positionScale,
+  Vec3<double> positionOffset,
+  PointFrame* frame)
+{
+  const auto xyzIdx = xyzIndexes(order);
+  const size_t pointCount = cloud.getPointCount();
+
+  frame->xyz.resize(3 * pointCount);
+  frame->rgb.resize(cloud.hasColors() ? 3 * pointCount : 0);
+  frame->reflectance.resize(cloud.hasReflectances() ? pointCount : 0);
+
+  for (size_t i = 0; i < pointCount; i++) {
+    Vec3<double> position = cloud[i] * positionScale + positionOffset;
+
+    int32_t* xyz = &frame->xyz[3 * i];
+    for (int k = 0; k < 3; k++)
+      xyz[xyzIdx[k]] = int32_t(std::round(position[k]));
+
+    if (cloud.hasColors()) {
+      // NB: the internal representation is gbr
+      const Vec3<attr_t>& color = cloud.getColor(i);
+      uint8_t* rgb = &frame->rgb[3 * i];
+      rgb[0] = uint8_t(color[2]);
+      rgb[1] = uint8_t(color[0]);
+      rgb[2] = uint8_t(color[1]);
+    }
+
+    if (cloud.hasReflectances())
+      frame->reflectance[i] = cloud.getReflectance(i);
+  }
+}
+
+//============================================================================
+
+struct Encoder::Impl : public PCCTMC3Encoder3::Callbacks {
+  Impl();
+
+  bool configure();
+
+  bool toPointSet(const PointFrameView& frame, PCCPointSet3* cloud);
+
+  void onOutputBuffer(PayloadBuffer&& buf) override;
+  void onPostRecolour(const PCCPointSet3&) override {}
+
+  po::Options opts;
+  CodecOptions codecParams;
+  EncoderOptions params;
+
+  // Set once the options have been sanitised, successfully or otherwise
+  bool configured;
+
+  // The reason the options were rejected, if they were
+  std::string configError;
+
+  // Discards coding statistics unless another log is set
+  std::ostream quiet{nullptr};
+
+  // The raw origin used for input sorting
+  Vec3<int> angularOrigin;
+
+  PCCTMC3Encoder3 encoder;
+
+  // The destination of encoded data units
+  std::vector<char>* bitstream;
+
+  std::string error;
+};
+
+//----------------------------------------------------------------------------
+
+Encoder::Impl::Impl() : configured(false), bitstream(nullptr)
+{
+  addCodecOptions(opts, &codecParams);
+  addEncoderOptions(opts, &params);
+  po::setDefaults(opts);
+  encoder.setLog(&quiet);
+}
+
+//----------------------------------------------------------------------------
+
+// NB: the options may only be sanitised once.  A failure is latched and
+//     reported by every subsequent call.
+
+bool
+Encoder::Impl::configure()
+{
+  if (configured) {
+    if (configError.empty())
+      return true;
+    error = configError;
+    return false;
+  }
+
+  configured = true;
+
+  // NB: this is the raw origin before the encoder tweaks it
+  angularOrigin = params.gps.geomAngularOrigin;
+
+  ErrorCollector err;
+  applyCodecOptions(codecParams, &params);
+  sanitiseEncoderOptions(&params, err);
+  if (err.is_errored) {
+    configError = err.msgs.str();
+    if (configError.empty())
+      configError = "Invalid encoder configuration";
+    error = configError;
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Convert frame to the internal representation of the configured
+// attributes.
+
+bool
+Encoder::Impl::toPointSet(const PointFrameView& frame, PCCPointSet3* cloud)
+{
+  bool codeColour = params.attributeIdxMap.count("color");
+  bool codeReflectance = params.attributeIdxMap.count("reflectance");
+  if ((codeColour && !frame.rgb) || (codeReflectance && !frame.reflectance)) {
+    error = "Frame is missing a configured attribute";
+    return false;
+  }
+
+  // Unused attributes are ignored
+  PointFrameView input = frame;
+  if (!codeColour)
+    input.rgb = nullptr;
+  if (!codeReflectance)
+    input.reflectance = nullptr;
+
+  tmc3::toPointSet(input, params.sps.geometry_axis_order, cloud);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+
+void
+Encoder::Impl::onOutputBuffer(PayloadBuffer&& buf)
+{
+  appendTlv(buf, bitstream);
+}
+
+//----------------------------------------------------------------------------
+
+Encoder::Encoder() : _impl(new Impl)
+{}
+
+//----------------------------------------------------------------------------
+
+Encoder::~Encoder() = default;
+
+//----------------------------------------------------------------------------
+
+bool
+Encoder::setOption(const std::string& name, const std::string& value)
+{
+  if (_impl->configured) {
+    _impl->error = "Options cannot be set after encoding has started";
+    return false;
+  }
+
+  return tmc3::setOption(_impl->opts, name, value, &_impl->error);
+}
+
+//----------------------------------------------------------------------------
+
+void
+Encoder::setLog(std::ostream* log)
+{
+  _impl->encoder.setLog(log ? log : &_impl->quiet);
+}
+
+//----------------------------------------------------------------------------
+
+bool
+Encoder::encode(
+  const PointFrameView& frame, std::vector<char>* bitstream, PointFrame* recon)
+{
+  auto& params = _impl->params;
+  if (!_impl->configure())
+    return false;
+
+  PCCPointSet3 pointCloud;
+  if (!_impl->toPointSet(frame, &pointCloud))
+    return false;
+
+  if (params.sortInputByAzimuth)
+    sortByAzimuth(
+      pointCloud, 0, pointCloud.getPointCount(), _impl->angularOrigin);
+
+  convertFromGbr(params.sps, pointCloud);
+
+  std::unique_ptr<PCCPointSet3> reconPointCloud;
+  if (recon)
+    reconPointCloud.reset(new PCCPointSet3);
+
+  _impl->bitstream = bitstream;
+
+  try {
+    if (_impl->encoder.compress(
+          pointCloud, &params, _impl.get(), reconPointCloud.get())) {
+      _impl->error = "Failed to compress point cloud";
+      return false;
+    }
+  }
+  catch (const std::exception& e) {
+    _impl->error = e.what();
+    return false;
+  }
+
+  if (recon) {
+    convertToGbr(params.sps, *reconPointCloud);
+
+    auto scale = outputScale(params.sps, params.srcResolution);
+    auto origin = params.sps.seqBoundingBoxOrigin * scale;
+    fromPointSet(
+      *reconPointCloud, params.sps.geometry_axis_order, scale, origin, recon);
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+Encoder::push(const PointFrameView& packet, std::vector<char>* bitstream)
+{
+  auto& params = _impl->params;
+  if (!_impl->configure())
+    return false;
+
+  PCCPointSet3 pointCloud;
+  if (!_impl->toPointSet(packet, &pointCloud))
+    return false;
+
+  convertFromGbr(params.sps, pointCloud);
+
+  _impl->bitstream = bitstream;
+
+  try {
+    if (_impl->encoder.pushPoints(pointCloud, &params, _impl.get())) {
+      _impl->error = "Failed to compress point cloud";
+      return false;
+    }
+  }
+  catch (const std::exception& e) {
+    _impl->error = e.what();
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+Encoder::endFrame(std::vector<char>* bitstream)
+{
+  if (!_impl->configure())
+    return false;
+
+  _impl->bitstream = bitstream;
+
+  try {
+    if (_impl->encoder.endFrame(&_impl->params, _impl.get())) {
+      _impl->error = "Failed to compress point cloud";
+      return false;
+    }
+  }
+  catch (const std::exception& e) {
+    _impl->error = e.what();
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+
+const std::string&
+Encoder::lastError() const
+{
+  return _impl->error;
+}
+
+//============================================================================
+
+struct Decoder::Impl : public PCCTMC3Decoder3::Callbacks {
+  Impl();
+
+  bool decompress(const PayloadBuffer* buf);
+
+  void onOutputCloud(
+    const SequenceParameterSet& sps, PCCPointSet3& cloud) override;
+
+  po::Options opts;
+  CodecOptions codecParams;
+  DecoderParams params;
+
+  // NB: the decoder is created when decoding starts, after configuration
+  std::unique_ptr<PCCTMC3Decoder3> decoder;
+
+  // Any incomplete data unit from the previous call
+  std::vector<char> pending;
+
+  // The destination of decoded frames
+  std::vector<PointFrame>* frames;
+
+  // The destination of decoding statistics
+  std::ostream* log;
+
+  // Discards decoding statistics unless another log is set
+  std::ostream quiet{nullptr};
+
+  std::string error;
+};
+
+//----------------------------------------------------------------------------
+
+Decoder::Impl::Impl() : frames(nullptr), log(&quiet)
+{
+  addCodecOptions(opts, &codecParams);
+  addDecoderOptions(opts, &params);
+  po::setDefaults(opts);
+}
+
+//----------------------------------------------------------------------------
+
+bool
+Decoder::Impl::decompress(const PayloadBuffer* buf)
+{
+  if (!decoder) {
+    applyCodecOptions(codecParams, &params);
+    decoder.reset(new PCCTMC3Decoder3(params));
+    decoder->setLog(log);
+  }
+
+  try {
+    if (decoder->decompress(buf, this)) {
+      error = "Failed to decompress point cloud";
+      return false;
+    }
+  }
+  catch (const std::exception& e) {
+    error = e.what();
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+
+void
+Decoder::Impl::onOutputCloud(
+  const SequenceParameterSet& sps, PCCPointSet3& cloud)
+{
+  convertToGbr(sps, cloud);
+
+  auto scale = outputScale(sps, 0.f);
+  auto origin = sps.seqBoundingBoxOrigin * scale;
+
+  frames->emplace_back();
+  fromPointSet(cloud, sps.geometry_axis_order, scale, origin, &frames->back());
+}
+
+//----------------------------------------------------------------------------
+
+Decoder::Decoder() : _impl(new Impl)
+{}
+
+//----------------------------------------------------------------------------
+
+Decoder::~Decoder() = default;
+
+//----------------------------------------------------------------------------
+
+bool
+Decoder::setOption(const std::string& name, const std::string& value)
+{
+  if (_impl->decoder) {
+    _impl->error = "Options cannot be set after decoding has started";
+    return false;
+  }
+
+  return tmc3::setOption(_impl->opts, name, value, &_impl->error);
+}
+
+//----------------------------------------------------------------------------
+
+void
+Decoder::setLog(std::ostream* log)
+{
+  _impl->log = log ? log : &_impl->quiet;
+  if (_impl->decoder)
+    _impl->decoder->setLog(_impl->log);
+}
+
+//----------------------------------------------------------------------------
+
+bool
+Decoder::decode(const char* data, size_t len, std::vector<PointFrame>* frames)
+{
+  auto& pending = _impl->pending;
+  _impl->frames = frames;
+
+  // Complete data units are decoded directly from the input
+  if (!pending.empty()) {
+    pending.insert(pending.end(), data, data + len);
+    data = pending.data();
+    len = pending.size();
+  }
+
+  PayloadBuffer buf;
+  size_t pos = 0;
+  while (size_t unitLen = readTlv(data + pos, len - pos, &buf)) {
+    pos += unitLen;
+    if (!_impl->decompress(&buf))
+      return false;
+  }
+
+  // Retain the start of any incomplete data unit
+  std::vector<char>(data + pos, data + len).swap(pending);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+
+bool
+Decoder::flush(std::vector<PointFrame>* frames)
+{
+  _impl->frames = frames;
+
+  if (!_impl->decompress(nullptr))
+    return false;
+
+  if (!_impl->pending.empty()) {
+    _impl->error = "Bitstream ends with an incomplete data unit";
+    _impl->pending.clear();
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+
+const std::string&
+Decoder::lastError() const
+{
+  return _impl->error;
+}
+
+//============================================================================
+
+}  // namespace tmc3
@@ -0,0 +1,191 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+// The tmc3 library interface: in-process, memory to memory encoding and
+// decoding of point clouds.
+//
+// NB: this header is self-contained and does not expose any internal
+//     codec types.  See libtmc3_c.h for the equivalent C interface.
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tmc3 {
+
+//============================================================================
+// A read-only view of a point cloud frame stored in caller owned arrays.
+// Positions are stored in x, y, z order.  Absent attributes are nullptr.
+
+struct PointFrameView {
+  size_t numPoints;
+
+  // 3 * numPoints position components
+  const int32_t* xyz;
+
+  // 3 * numPoints colour components (r, g, b), or nullptr
+  const uint8_t* rgb;
+
+  // numPoints reflectance values, or nullptr
+  const uint16_t* reflectance;
+};
+
+//----------------------------------------------------------------------------
+// A point cloud frame.  Absent attributes are empty.
+
+struct PointFrame {
+  std::vector<int32_t> xyz;
+  std::vector<uint8_t> rgb;
+  std::vector<uint16_t> reflectance;
+
+  size_t size() const { return xyz.size() / 3; }
+
+  PointFrameView view() const
+  {
+    return {size(), xyz.data(), rgb.empty() ? nullptr : rgb.data(),
+            reflectance.empty() ? nullptr : reflectance.data()};
+  }
+};
+
+//============================================================================
+// Encodes a sequence of frames.
+//
+// The configuration options are those of the tmc3 Encoder, Geometry,
+// Attributes and Recolouring sections (see README.options.md).  Options
+// are applied in order, as if given on the command line.  For instance,
+// to code colour:
+//   setOption("qp", "28");
+//   setOption("attribute", "color");
+//
+// Colour is converted from RGB according to the attribute colourMatrix.
+//
+// If the configuration is invalid, the first call to encode(), push() or
+// endFrame() fails, as do all subsequent calls.
+
+class Encoder {
+public:
+  Encoder();
+  ~Encoder();
+
+  Encoder(const Encoder&) = delete;
+  Encoder& operator=(const Encoder&) = delete;
+
+  // Sets the option name (without any leading "--") to value.
+  // Options may only be set before the first frame is encoded.
+  // Returns false if the option is unknown or the value is invalid.
+  bool setOption(const std::string& name, const std::string& value);
+
+  // Sets the stream to which coding statistics are written.  By default,
+  // or if log is nullptr, they are discarded.
+  void setLog(std::ostream* log);
+
+  // Encodes frame, appending the TLV encapsulated data units to bitstream.
+  // If recon is not nullptr, it is set to the reconstructed frame.
+  // Returns false on error.
+  bool encode(
+    const PointFrameView& frame,
+    std::vector<char>* bitstream,
+    PointFrame* recon = nullptr);
+
+  // Low-latency encoding of a frame supplied as a sequence of packets of
+  // points in acquisition order.  Each slice is appended to bitstream as
+  // soon as it is coded: whenever sliceMaxPoints points or sliceMaxDuration
+  // milliseconds of points have been buffered.  endFrame() codes any
+  // remaining points of the frame.
+  //
+  // Points are coded in the order supplied, and the sequence bounding box
+  // (seq_bounding_box_xyz0 / seq_bounding_box_whd) must be set.
+  // Returns false on error.
+  bool push(const PointFrameView& packet, std::vector<char>* bitstream);
+  bool endFrame(std::vector<char>* bitstream);
+
+  // A description of the most recent error.
+  const std::string& lastError() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> _impl;
+};
+
+//============================================================================
+// Decodes a sequence of frames.
+//
+// The configuration options are those of the tmc3 Decoder section.
+//
+// Output positions are scaled as per the tmc3 decoder with the default
+// outputResolution.  Colour is converted to RGB.
+
+class Decoder {
+public:
+  Decoder();
+  ~Decoder();
+
+  Decoder(const Decoder&) = delete;
+  Decoder& operator=(const Decoder&) = delete;
+
+  // Sets the option name (without any leading "--") to value.
+  // Options may only be set before any data is decoded.
+  // Returns false if the option is unknown or the value is invalid.
+  bool setOption(const std::string& name, const std::string& value);
+
+  // Sets the stream to which decoding statistics are written.  By default,
+  // or if log is nullptr, they are discarded.
+  void setLog(std::ostream* log);
+
+  // Decodes TLV encapsulated data.  Data units may be split between calls.
+  // Any frames that are completed are appended to frames.
+  // Returns false on error.
+  bool decode(const char* data, size_t len, std::vector<PointFrame>* frames);
+
+  // Signals the end of the bitstream, appending any final frame to frames.
+  // Returns false on error.
+  bool flush(std::vector<PointFrame>* frames);
+
+  // A description of the most recent error.
+  const std::string& lastError() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> _impl;
+};
+
+//============================================================================
+
+}  // namespace tmc3
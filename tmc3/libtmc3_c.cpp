@@ -0,0 +1,304 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "libtmc3_c.h"
+
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "libtmc3.h"
+
+//============================================================================
+// NB: exceptions must not propagate through the C interface.
+
+struct tmc3_encoder {
+  tmc3::Encoder encoder;
+  std::vector<char> bitstream;
+  std::string error;
+};
+
+//----------------------------------------------------------------------------
+
+struct tmc3_decoder {
+  tmc3::Decoder decoder;
+  std::deque<tmc3::PointFrame> queue;
+
+  // The frame most recently returned by tmc3_decoder_get_frame
+  tmc3::PointFrame current;
+
+  std::string error;
+};
+
+//============================================================================
+
+tmc3_encoder*
+tmc3_encoder_create(void)
+{
+  try {
+    return new tmc3_encoder;
+  }
+  catch (...) {
+    return nullptr;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+void
+tmc3_encoder_destroy(tmc3_encoder* enc)
+{
+  delete enc;
+}
+
+//----------------------------------------------------------------------------
+
+int
+tmc3_encoder_set_option(tmc3_encoder* enc, const char* name, const char* value)
+{
+  try {
+    if (enc->encoder.setOption(name, value))
+      return 0;
+    enc->error = enc->encoder.lastError();
+  }
+  catch (const std::exception& e) {
+    enc->error = e.what();
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+
+void
+tmc3_encoder_set_verbose(tmc3_encoder* enc, int verbose)
+{
+  enc->encoder.setLog(verbose ? &std::cerr : nullptr);
+}
+
+//----------------------------------------------------------------------------
+
+int
+tmc3_encoder_encode(
+  tmc3_encoder* enc, const tmc3_points* frame, const char** data, size_t* len)
+{
+  try {
+    tmc3::PointFrameView view{frame->num_points, frame->xyz, frame->rgb,
+                              frame->reflectance};
+
+    enc->bitstream.clear();
+    if (enc->encoder.encode(view, &enc->bitstream)) {
+      *data = enc->bitstream.data();
+      *len = enc->bitstream.size();
+      return 0;
+    }
+    enc->error = enc->encoder.lastError();
+  }
+  catch (const std::exception& e) {
+    enc->error = e.what();
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+
+int
+tmc3_encoder_push(
+  tmc3_encoder* enc, const tmc3_points* packet, const char** data, size_t* len)
+{
+  try {
+    tmc3::PointFrameView view{packet->num_points, packet->xyz, packet->rgb,
+                              packet->reflectance};
+
+    enc->bitstream.clear();
+    if (enc->encoder.push(view, &enc->bitstream)) {
+      *data = enc->bitstream.data();
+      *len = enc->bitstream.size();
+      return 0;
+    }
+    enc->error = enc->encoder.lastError();
+  }
+  catch (const std::exception& e) {
+    enc->error = e.what();
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+
+int
+tmc3_encoder_end_frame(tmc3_encoder* enc, const char** data, size_t* len)
+{
+  try {
+    enc->bitstream.clear();
+    if (enc->encoder.endFrame(&enc->bitstream)) {
+      *data = enc->bitstream.data();
+      *len = enc->bitstream.size();
+      return 0;
+    }
+    enc->error = enc->encoder.lastError();
+  }
+  catch (const std::exception& e) {
+    enc->error = e.what();
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+
+const char*
+tmc3_encoder_error(const tmc3_encoder* enc)
+{
+  return enc->error.c_str();
+}
+
+//============================================================================
+
+tmc3_decoder*
+tmc3_decoder_create(void)
+{
+  try {
+    return new tmc3_decoder;
+  }
+  catch (...) {
+    return nullptr;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+void
+tmc3_decoder_destroy(tmc3_decoder* dec)
+{
+  delete dec;
+}
+
+//----------------------------------------------------------------------------
+
+int
+tmc3_decoder_set_option(tmc3_decoder* dec, const char* name, const char* value)
+{
+  try {
+    if (dec->decoder.setOption(name, value))
+      return 0;
+    dec->error = dec->decoder.lastError();
+  }
+  catch (const std::exception& e) {
+    dec->error = e.what();
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+
+void
+tmc3_decoder_set_verbose(tmc3_decoder* dec, int verbose)
+{
+  dec->decoder.setLog(verbose ? &std::cerr : nullptr);
+}
+
+//----------------------------------------------------------------------------
+
+int
+tmc3_decoder_decode(tmc3_decoder* dec, const char* data, size_t len)
+{
+  try {
+    std::vector<tmc3::PointFrame> frames;
+    bool ok = dec->decoder.decode(data, len, &frames);
+
+    for (auto& frame : frames)
+      dec->queue.emplace_back(std::move(frame));
+
+    if (ok)
+      return 0;
+    dec->error = dec->decoder.lastError();
+  }
+  catch (const std::exception& e) {
+    dec->error = e.what();
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+
+int
+tmc3_decoder_flush(tmc3_decoder* dec)
+{
+  try {
+    std::vector<tmc3::PointFrame> frames;
+    bool ok = dec->decoder.flush(&frames);
+
+    for (auto& frame : frames)
+      dec->queue.emplace_back(std::move(frame));
+
+    if (ok)
+      return 0;
+    dec->error = dec->decoder.lastError();
+  }
+  catch (const std::exception& e) {
+    dec->error = e.what();
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+
+int
+tmc3_decoder_get_frame(tmc3_decoder* dec, tmc3_points* frame)
+{
+  if (dec->queue.empty())
+    return 0;
+
+  dec->current = std::move(dec->queue.front());
+  dec->queue.pop_front();
+
+  auto view = dec->current.view();
+  frame->num_points = view.numPoints;
+  frame->xyz = view.xyz;
+  frame->rgb = view.rgb;
+  frame->reflectance = view.reflectance;
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+
+const char*
+tmc3_decoder_error(const tmc3_decoder* dec)
+{
+  return dec->error.c_str();
+}
+
+//============================================================================
@@ -0,0 +1,117 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+/* The C interface to the tmc3 library.  This mirrors the C++ interface
+ * in libtmc3.h, with functions returning 0 on success. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A point cloud frame.  Positions are stored in x, y, z order.
+ * Absent attributes are NULL. */
+typedef struct tmc3_points {
+  size_t num_points;
+  const int32_t* xyz;
+  const uint8_t* rgb;
+  const uint16_t* reflectance;
+} tmc3_points;
+
+typedef struct tmc3_encoder tmc3_encoder;
+typedef struct tmc3_decoder tmc3_decoder;
+
+/*--------------------------------------------------------------------------*/
+
+tmc3_encoder* tmc3_encoder_create(void);
+void tmc3_encoder_destroy(tmc3_encoder* enc);
+
+int tmc3_encoder_set_option(
+  tmc3_encoder* enc, const char* name, const char* value);
+
+/* Writes coding statistics to stderr if verbose is non-zero.  By default,
+ * they are discarded. */
+void tmc3_encoder_set_verbose(tmc3_encoder* enc, int verbose);
+
+/* Encodes a frame.  On success, *data and *len describe the encoded
+ * bitstream, which remains valid until the next call using enc. */
+int tmc3_encoder_encode(
+  tmc3_encoder* enc, const tmc3_points* frame, const char** data,
+  size_t* len);
+
+/* Low-latency encoding of a frame supplied as packets of points in
+ * acquisition order.  On success, *data and *len describe any slices
+ * completed by the call, which remain valid until the next call using enc.
+ * tmc3_encoder_end_frame() codes the remaining points of the frame. */
+int tmc3_encoder_push(
+  tmc3_encoder* enc, const tmc3_points* packet, const char** data,
+  size_t* len);
+
+int tmc3_encoder_end_frame(tmc3_encoder* enc, const char** data, size_t* len);
+
+const char* tmc3_encoder_error(const tmc3_encoder* enc);
+
+/*--------------------------------------------------------------------------*/
+
+tmc3_decoder* tmc3_decoder_create(void);
+void tmc3_decoder_destroy(tmc3_decoder* dec);
+
+int tmc3_decoder_set_option(
+  tmc3_decoder* dec, const char* name, const char* value);
+
+/* Writes decoding statistics to stderr if verbose is non-zero.  By default,
+ * they are discarded. */
+void tmc3_decoder_set_verbose(tmc3_decoder* dec, int verbose);
+
+/* Decodes TLV encapsulated data.  Data units may be split between calls.
+ * Completed frames are queued for tmc3_decoder_get_frame(). */
+int tmc3_decoder_decode(tmc3_decoder* dec, const char* data, size_t len);
+
+/* Signals the end of the bitstream, queuing any final frame. */
+int tmc3_decoder_flush(tmc3_decoder* dec);
+
+/* Retrieves the next queued frame, returning 1 if a frame was available,
+ * otherwise 0.  The frame remains valid until the next call using dec. */
+int tmc3_decoder_get_frame(tmc3_decoder* dec, tmc3_points* frame);
+
+const char* tmc3_decoder_error(const tmc3_decoder* dec);
+
+#ifdef __cplusplus
+}
+#endif
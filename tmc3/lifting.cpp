@@ -0,0 +1,248 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PCCTMC3Common.h"
+#include "cpu_features.h"
+#include "lifting_kernels.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace pcc {
+
+//============================================================================
+// Portable lifting kernels
+
+static void
+liftPredictScalar(
+  const LiftingKernelArgs& args, size_t start, size_t end, bool direct)
+{
+  // NB: predictors only reference predictors of preceding levels of
+  //     detail, allowing the range to be processed in any order.
+  for (size_t predictorIndex = start; predictorIndex < end;
+       ++predictorIndex) {
+    for (int c = 0; c < args.numComponents; ++c) {
+      int64_t* attrs = args.attributes[c];
+      int64_t predicted = 0;
+      for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+        const uint32_t neighIndex = args.neighIndexes[j][predictorIndex];
+        assert(neighIndex < start);
+        predicted += args.neighWeights[j][predictorIndex] * attrs[neighIndex];
+      }
+      predicted = divExp2RoundHalfInf(predicted, kFixedPointWeightShift);
+      if (direct)
+        attrs[predictorIndex] -= predicted;
+      else
+        attrs[predictorIndex] += predicted;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+
+static void
+liftAccumulateUpdatesScalar(
+  const LiftingKernelArgs& args, size_t start, size_t end)
+{
+  // NB: the accumulation order does not affect the (integer) result
+  for (size_t predictorIndex = start; predictorIndex < end;
+       ++predictorIndex) {
+    const uint64_t quantWeight = args.quantWeights[predictorIndex];
+    for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+      const uint64_t weight = divExp2RoundHalfInf(
+        args.neighWeights[j][predictorIndex] * quantWeight,
+        kFixedPointWeightShift);
+      if (!weight)
+        continue;
+
+      const uint32_t neighIndex = args.neighIndexes[j][predictorIndex];
+      assert(neighIndex < start);
+      args.updateWeights[neighIndex] += weight;
+      for (int c = 0; c < args.numComponents; ++c)
+        args.updates[c][neighIndex] +=
+          weight * args.attributes[c][predictorIndex];
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+
+void
+liftApplyUpdatesScalar(
+  const LiftingKernelArgs& args, size_t start, size_t end, bool direct)
+{
+  for (size_t predictorIndex = start; predictorIndex < end;
+       ++predictorIndex) {
+    // NB: only the low 32 bits of the accumulated weight are used
+    const uint32_t sumWeights = args.updateWeights[predictorIndex];
+    if (sumWeights) {
+      int32_t log2InvScale;
+      const int64_t invB = divInvDivisorApprox(sumWeights, log2InvScale);
+      for (int c = 0; c < args.numComponents; ++c) {
+        const int64_t sum = args.updates[c][predictorIndex];
+        assert(std::abs(sum) < (1ll << 46));
+        const int64_t update = (invB * sum) >> log2InvScale;
+        if (direct)
+          args.attributes[c][predictorIndex] += update;
+        else
+          args.attributes[c][predictorIndex] -= update;
+      }
+    }
+
+    args.updateWeights[predictorIndex] = 0;
+    for (int c = 0; c < args.numComponents; ++c)
+      args.updates[c][predictorIndex] = 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+const LiftingKernels kLiftingKernelsScalar = {
+  liftPredictScalar, liftAccumulateUpdatesScalar, liftApplyUpdatesScalar};
+
+//============================================================================
+
+static const LiftingKernels&
+selectLiftingKernels()
+{
+#if HAVE_X86_SIMD
+  switch (hostSimdLevel()) {
+  case SimdLevel::kAvx2: return kLiftingKernelsAvx2;
+  case SimdLevel::kSse41: return kLiftingKernelsSse41;
+  case SimdLevel::kNone: break;
+  }
+#endif
+
+  return kLiftingKernelsScalar;
+}
+
+//----------------------------------------------------------------------------
+// The lifting kernels, the update accumulators and the arguments that
+// reference them for a transform.
+
+namespace {
+  struct LiftingTransform {
+    const LiftingKernels& kernels;
+    std::vector<int64_t> updates;
+    std::vector<uint64_t> updateWeights;
+    LiftingKernelArgs args;
+
+    LiftingTransform(
+      const LiftingNeighbours& neighbours,
+      const std::vector<uint64_t>& quantizationWeights,
+      int numComponents,
+      int64_t* const attributes[]);
+  };
+}  // namespace
+
+//----------------------------------------------------------------------------
+
+LiftingTransform::LiftingTransform(
+  const LiftingNeighbours& neighbours,
+  const std::vector<uint64_t>& quantizationWeights,
+  int numComponents,
+  int64_t* const attributes[])
+  : kernels(selectLiftingKernels())
+{
+  const size_t pointCount = neighbours.size();
+  assert(quantizationWeights.size() == pointCount);
+  assert(numComponents >= 1 && numComponents <= 3);
+
+  updates.resize(numComponents * pointCount);
+  updateWeights.resize(pointCount);
+
+  for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+    args.neighIndexes[j] = neighbours.indexes[j].data();
+    args.neighWeights[j] = neighbours.weights[j].data();
+  }
+  args.quantWeights = quantizationWeights.data();
+  args.numComponents = numComponents;
+  for (int c = 0; c < 3; ++c) {
+    args.attributes[c] = c < numComponents ? attributes[c] : nullptr;
+    args.updates[c] = c < numComponents ? &updates[c * pointCount] : nullptr;
+  }
+  args.updateWeights = updateWeights.data();
+}
+
+//============================================================================
+
+void
+PCCLiftForward(
+  const LiftingNeighbours& neighbours,
+  const std::vector<uint64_t>& quantizationWeights,
+  const std::vector<uint32_t>& numPointsInLod,
+  int numComponents,
+  int64_t* const attributes[])
+{
+  LiftingTransform lift(
+    neighbours, quantizationWeights, numComponents, attributes);
+
+  const size_t lodCount = numPointsInLod.size();
+  for (size_t i = 0; (i + 1) < lodCount; ++i) {
+    const size_t lodIndex = lodCount - i - 1;
+    const size_t startIndex = numPointsInLod[lodIndex - 1];
+    const size_t endIndex = numPointsInLod[lodIndex];
+    lift.kernels.predict(lift.args, startIndex, endIndex, true);
+    lift.kernels.accumulateUpdates(lift.args, startIndex, endIndex);
+    lift.kernels.applyUpdates(lift.args, 0, startIndex, true);
+  }
+}
+
+//----------------------------------------------------------------------------
+
+void
+PCCLiftInverse(
+  const LiftingNeighbours& neighbours,
+  const std::vector<uint64_t>& quantizationWeights,
+  const std::vector<uint32_t>& numPointsInLod,
+  int numComponents,
+  int64_t* const attributes[])
+{
+  LiftingTransform lift(
+    neighbours, quantizationWeights, numComponents, attributes);
+
+  const size_t lodCount = numPointsInLod.size();
+  for (size_t lodIndex = 1; lodIndex < lodCount; ++lodIndex) {
+    const size_t startIndex = numPointsInLod[lodIndex - 1];
+    const size_t endIndex = numPointsInLod[lodIndex];
+    lift.kernels.accumulateUpdates(lift.args, startIndex, endIndex);
+    lift.kernels.applyUpdates(lift.args, 0, startIndex, false);
+    lift.kernels.predict(lift.args, startIndex, endIndex, false);
+  }
+}
+
+//============================================================================
+
+}  // namespace pcc
@@ -0,0 +1,279 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "lifting_kernels.h"
+
+#if HAVE_X86_SIMD
+
+#  include <immintrin.h>
+
+namespace pcc {
+
+// The reciprocal table used by divApprox() (see PCCMath.h)
+extern const uint16_t kDivApproxDivisor[256];
+
+//============================================================================
+// Lifting kernels using AVX2.  Each 64-bit lane holds the attribute
+// component of a different predictor.  The arithmetic is that of the
+// portable kernels, which process any remaining predictors.
+
+namespace {
+  // The low 64 bits of the product of each 64-bit lane of @a and the
+  // unsigned 32-bit value in the low half of each 64-bit lane of @b.
+  inline __m256i
+  mulLo64x32(__m256i a, __m256i b)
+  {
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+  }
+
+  // The low 64 bits of the product of each 64-bit lane of @a and @b.
+  inline __m256i
+  mulLo64(__m256i a, __m256i b)
+  {
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i hi = _mm256_add_epi64(
+      _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+      _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+  }
+
+  // Integer division of each signed 64-bit lane by 2^kFixedPointWeightShift,
+  // rounding intermediate half values away from zero.
+  inline __m256i
+  divExp2RoundHalfInfEpi64(__m256i a)
+  {
+    const int shift = kFixedPointWeightShift;
+    __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), a);
+    __m256i mag = _mm256_sub_epi64(_mm256_xor_si256(a, sign), sign);
+    mag = _mm256_add_epi64(mag, _mm256_set1_epi64x(1ll << (shift - 1)));
+    mag = _mm256_srli_epi64(mag, shift);
+    return _mm256_sub_epi64(_mm256_xor_si256(mag, sign), sign);
+  }
+
+  // Loads four unsigned 32-bit values, zero extended to 64 bits.
+  inline __m256i
+  loadEpu32(const uint32_t* src)
+  {
+    return _mm256_cvtepu32_epi64(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+  }
+
+  inline __m256i
+  loadEpi64(const void* src)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+  }
+
+  inline void
+  storeEpi64(void* dst, __m256i val)
+  {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), val);
+  }
+}  // namespace
+
+//----------------------------------------------------------------------------
+
+static void
+liftPredictAvx2(
+  const LiftingKernelArgs& args, size_t start, size_t end, bool direct)
+{
+  const int numComponents = args.numComponents;
+
+  size_t predictorIndex = start;
+  for (; predictorIndex + 4 <= end; predictorIndex += 4) {
+    __m256i predicted[3];
+    for (int c = 0; c < numComponents; ++c)
+      predicted[c] = _mm256_setzero_si256();
+
+    for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+      __m128i neighIndex = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+        args.neighIndexes[j] + predictorIndex));
+      __m256i weight = loadEpu32(args.neighWeights[j] + predictorIndex);
+      for (int c = 0; c < numComponents; ++c) {
+        const auto* attrs =
+          reinterpret_cast<const long long*>(args.attributes[c]);
+        __m256i attr = _mm256_i32gather_epi64(attrs, neighIndex, 8);
+        predicted[c] =
+          _mm256_add_epi64(predicted[c], mulLo64x32(attr, weight));
+      }
+    }
+
+    for (int c = 0; c < numComponents; ++c) {
+      int64_t* attr = args.attributes[c] + predictorIndex;
+      __m256i delta = divExp2RoundHalfInfEpi64(predicted[c]);
+      if (direct)
+        storeEpi64(attr, _mm256_sub_epi64(loadEpi64(attr), delta));
+      else
+        storeEpi64(attr, _mm256_add_epi64(loadEpi64(attr), delta));
+    }
+  }
+
+  kLiftingKernelsScalar.predict(args, predictorIndex, end, direct);
+}
+
+//----------------------------------------------------------------------------
+// NB: the weighted updates are derived four predictors at a time, and are
+//     then accumulated individually since neighbours may be shared.
+
+static void
+liftAccumulateUpdatesAvx2(
+  const LiftingKernelArgs& args, size_t start, size_t end)
+{
+  const int numComponents = args.numComponents;
+  const int shift = kFixedPointWeightShift;
+  const __m256i round = _mm256_set1_epi64x(1ll << (shift - 1));
+
+  size_t predictorIndex = start;
+  for (; predictorIndex + 4 <= end; predictorIndex += 4) {
+    __m256i quantWeight = loadEpi64(args.quantWeights + predictorIndex);
+    __m256i attr[3];
+    for (int c = 0; c < numComponents; ++c)
+      attr[c] = loadEpi64(args.attributes[c] + predictorIndex);
+
+    for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+      __m256i weight = loadEpu32(args.neighWeights[j] + predictorIndex);
+      weight = mulLo64x32(quantWeight, weight);
+      weight = _mm256_srli_epi64(_mm256_add_epi64(weight, round), shift);
+
+      uint64_t weights[4];
+      int64_t updates[3][4];
+      storeEpi64(weights, weight);
+      for (int c = 0; c < numComponents; ++c)
+        storeEpi64(updates[c], mulLo64(weight, attr[c]));
+
+      const uint32_t* neighIndex = args.neighIndexes[j] + predictorIndex;
+      for (int i = 0; i < 4; ++i) {
+        if (!weights[i])
+          continue;
+        args.updateWeights[neighIndex[i]] += weights[i];
+        for (int c = 0; c < numComponents; ++c)
+          args.updates[c][neighIndex[i]] += updates[c][i];
+      }
+    }
+  }
+
+  kLiftingKernelsScalar.accumulateUpdates(args, predictorIndex, end);
+}
+
+//----------------------------------------------------------------------------
+// Applies the accumulated updates using the reciprocal approximation of
+// divInvDivisorApprox(), with the floor(log2(.)) of each (32-bit) sum of
+// weights taken from the exponent of its double precision representation.
+
+static void
+liftApplyUpdatesAvx2(
+  const LiftingKernelArgs& args, size_t start, size_t end, bool direct)
+{
+  const int numComponents = args.numComponents;
+  const int lutSizeLog2 = 8;
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i exp52 = _mm256_set1_epi64x(0x4330000000000000ll);
+
+  size_t predictorIndex = start;
+  for (; predictorIndex + 4 <= end; predictorIndex += 4) {
+    // NB: only the low 32 bits of the accumulated weight are used.  Lanes
+    //     without an update use a divisor of one, and are left unmodified.
+    __m256i sumWeights = loadEpi64(args.updateWeights + predictorIndex);
+    sumWeights = _mm256_and_si256(sumWeights, _mm256_set1_epi64x(0xffffffff));
+    __m256i noUpdate = _mm256_cmpeq_epi64(sumWeights, zero);
+    __m256i b = _mm256_sub_epi64(sumWeights, noUpdate);
+
+    // n = max(0, ilog2(b) + 1 - lutSizeLog2), where 2^52 + b is exact
+    __m256d bd = _mm256_sub_pd(
+      _mm256_castsi256_pd(_mm256_or_si256(b, exp52)),
+      _mm256_castsi256_pd(exp52));
+    __m256i log2b = _mm256_srli_epi64(_mm256_castpd_si256(bd), 52);
+    __m256i n = _mm256_sub_epi64(log2b, _mm256_set1_epi64x(1023 - 1));
+    n = _mm256_sub_epi64(n, _mm256_set1_epi64x(lutSizeLog2));
+    // NB: a 32-bit maximum suffices since the lanes are sign extended
+    n = _mm256_max_epi32(n, zero);
+
+    // index = (b + ((1 << n) >> 1)) >> n, in the range [1, 256]
+    __m256i half = _mm256_srli_epi64(_mm256_sllv_epi64(one, n), 1);
+    __m256i index = _mm256_srlv_epi64(_mm256_add_epi64(b, half), n);
+
+    // Gather the pair of 16-bit table entries starting at the entry
+    // index - 1, or at index - 2 for the last entry to remain within the
+    // table.  The wanted entry is then the low or high half of the pair.
+    __m256i entry = _mm256_sub_epi64(index, one);
+    __m256i isLast = _mm256_cmpeq_epi64(entry, _mm256_set1_epi64x(255));
+    __m256i pairIdx = _mm256_add_epi64(entry, isLast);
+    __m256i pair = _mm256_cvtepu32_epi64(_mm256_i64gather_epi32(
+      reinterpret_cast<const int*>(kDivApproxDivisor), pairIdx, 2));
+    __m256i invB = _mm256_srlv_epi64(
+      pair, _mm256_and_si256(isLast, _mm256_set1_epi64x(16)));
+    invB = _mm256_and_si256(invB, _mm256_set1_epi64x(0xffff));
+    invB = _mm256_add_epi64(invB, one);
+    __m256i log2InvScale =
+      _mm256_add_epi64(n, _mm256_set1_epi64x(2 * lutSizeLog2));
+
+    for (int c = 0; c < numComponents; ++c) {
+      int64_t* attr = args.attributes[c] + predictorIndex;
+      int64_t* sum = args.updates[c] + predictorIndex;
+
+      // update = (invB * sum) >> log2InvScale, an arithmetic shift
+      __m256i update = mulLo64x32(loadEpi64(sum), invB);
+      __m256i sign = _mm256_cmpgt_epi64(zero, update);
+      update = _mm256_xor_si256(update, sign);
+      update = _mm256_srlv_epi64(update, log2InvScale);
+      update = _mm256_xor_si256(update, sign);
+      update = _mm256_andnot_si256(noUpdate, update);
+
+      if (direct)
+        storeEpi64(attr, _mm256_add_epi64(loadEpi64(attr), update));
+      else
+        storeEpi64(attr, _mm256_sub_epi64(loadEpi64(attr), update));
+      storeEpi64(sum, zero);
+    }
+
+    storeEpi64(args.updateWeights + predictorIndex, zero);
+  }
+
+  kLiftingKernelsScalar.applyUpdates(args, predictorIndex, end, direct);
+}
+
+//----------------------------------------------------------------------------
+
+const LiftingKernels kLiftingKernelsAvx2 = {
+  liftPredictAvx2, liftAccumulateUpdatesAvx2, liftApplyUpdatesAvx2};
+
+//============================================================================
+
+}  // namespace pcc
+
+#endif
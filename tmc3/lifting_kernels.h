@@ -0,0 +1,100 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "TMC3Config.h"
+#include "constants.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// NB: this header is included by translation units that are compiled for
+//     specific instruction set extensions.  It must not introduce inline
+//     functions or templates that may be shared with other translation
+//     units.
+
+namespace pcc {
+
+//============================================================================
+// The state operated on by the lifting transform kernels.  Attributes and
+// their update accumulators have numComponents separate component arrays,
+// all indexed by predictor.  Unused neighbours have zero weight.
+
+struct LiftingKernelArgs {
+  const uint32_t* neighIndexes[kAttributePredictionMaxNeighbourCount];
+  const uint32_t* neighWeights[kAttributePredictionMaxNeighbourCount];
+  const uint64_t* quantWeights;
+  int numComponents;
+  int64_t* attributes[3];
+  int64_t* updates[3];
+  uint64_t* updateWeights;
+};
+
+//----------------------------------------------------------------------------
+
+struct LiftingKernels {
+  // Subtracts (direct) or adds the prediction of each predictor in the
+  // range [start, end) from its neighbours.
+  void (*predict)(
+    const LiftingKernelArgs& args, size_t start, size_t end, bool direct);
+
+  // Accumulates the weighted update of the neighbours of each predictor
+  // in the range [start, end).
+  void (*accumulateUpdates)(
+    const LiftingKernelArgs& args, size_t start, size_t end);
+
+  // Adds (direct) or subtracts the accumulated update of each predictor
+  // in the range [start, end), clearing the accumulators.
+  void (*applyUpdates)(
+    const LiftingKernelArgs& args, size_t start, size_t end, bool direct);
+};
+
+//----------------------------------------------------------------------------
+
+extern const LiftingKernels kLiftingKernelsScalar;
+
+// The portable update kernel, shared by kernel sets without their own.
+void liftApplyUpdatesScalar(
+  const LiftingKernelArgs& args, size_t start, size_t end, bool direct);
+
+#if HAVE_X86_SIMD
+extern const LiftingKernels kLiftingKernelsSse41;
+extern const LiftingKernels kLiftingKernelsAvx2;
+#endif
+
+//============================================================================
+
+}  // namespace pcc
@@ -0,0 +1,199 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "lifting_kernels.h"
+
+#if HAVE_X86_SIMD
+
+#  include <smmintrin.h>
+
+namespace pcc {
+
+//============================================================================
+// Lifting kernels using SSE4.1.  Each 64-bit lane holds the attribute
+// component of a different predictor.  The arithmetic is that of the
+// portable kernels, which process any remaining predictors.
+
+namespace {
+  // The low 64 bits of the product of each 64-bit lane of @a and the
+  // unsigned 32-bit value in the low half of each 64-bit lane of @b.
+  inline __m128i
+  mulLo64x32(__m128i a, __m128i b)
+  {
+    __m128i lo = _mm_mul_epu32(a, b);
+    __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+    return _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+  }
+
+  // The low 64 bits of the product of each 64-bit lane of @a and @b.
+  inline __m128i
+  mulLo64(__m128i a, __m128i b)
+  {
+    __m128i lo = _mm_mul_epu32(a, b);
+    __m128i hi = _mm_add_epi64(
+      _mm_mul_epu32(_mm_srli_epi64(a, 32), b),
+      _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+    return _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+  }
+
+  // Integer division of each signed 64-bit lane by 2^kFixedPointWeightShift,
+  // rounding intermediate half values away from zero.
+  inline __m128i
+  divExp2RoundHalfInfEpi64(__m128i a)
+  {
+    const int shift = kFixedPointWeightShift;
+    __m128i sign = _mm_srai_epi32(_mm_shuffle_epi32(a, 0xf5), 31);
+    __m128i mag = _mm_sub_epi64(_mm_xor_si128(a, sign), sign);
+    mag = _mm_add_epi64(mag, _mm_set1_epi64x(1ll << (shift - 1)));
+    mag = _mm_srli_epi64(mag, shift);
+    return _mm_sub_epi64(_mm_xor_si128(mag, sign), sign);
+  }
+
+  // Loads two unsigned 32-bit values, zero extended to 64 bits.
+  inline __m128i
+  loadEpu32(const uint32_t* src)
+  {
+    return _mm_cvtepu32_epi64(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+  }
+
+  inline __m128i
+  loadEpi64(const void* src)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  }
+
+  inline void
+  storeEpi64(void* dst, __m128i val)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), val);
+  }
+}  // namespace
+
+//----------------------------------------------------------------------------
+
+static void
+liftPredictSse41(
+  const LiftingKernelArgs& args, size_t start, size_t end, bool direct)
+{
+  const int numComponents = args.numComponents;
+
+  size_t predictorIndex = start;
+  for (; predictorIndex + 2 <= end; predictorIndex += 2) {
+    __m128i predicted[3];
+    for (int c = 0; c < numComponents; ++c)
+      predicted[c] = _mm_setzero_si128();
+
+    for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+      const uint32_t* neighIndex = args.neighIndexes[j] + predictorIndex;
+      __m128i weight = loadEpu32(args.neighWeights[j] + predictorIndex);
+      for (int c = 0; c < numComponents; ++c) {
+        const int64_t* attrs = args.attributes[c];
+        __m128i attr =
+          _mm_set_epi64x(attrs[neighIndex[1]], attrs[neighIndex[0]]);
+        predicted[c] = _mm_add_epi64(predicted[c], mulLo64x32(attr, weight));
+      }
+    }
+
+    for (int c = 0; c < numComponents; ++c) {
+      int64_t* attr = args.attributes[c] + predictorIndex;
+      __m128i delta = divExp2RoundHalfInfEpi64(predicted[c]);
+      if (direct)
+        storeEpi64(attr, _mm_sub_epi64(loadEpi64(attr), delta));
+      else
+        storeEpi64(attr, _mm_add_epi64(loadEpi64(attr), delta));
+    }
+  }
+
+  kLiftingKernelsScalar.predict(args, predictorIndex, end, direct);
+}
+
+//----------------------------------------------------------------------------
+// NB: the weighted updates are derived two predictors at a time, and are
+//     then accumulated individually since neighbours may be shared.
+
+static void
+liftAccumulateUpdatesSse41(
+  const LiftingKernelArgs& args, size_t start, size_t end)
+{
+  const int numComponents = args.numComponents;
+  const int shift = kFixedPointWeightShift;
+  const __m128i round = _mm_set1_epi64x(1ll << (shift - 1));
+
+  size_t predictorIndex = start;
+  for (; predictorIndex + 2 <= end; predictorIndex += 2) {
+    __m128i quantWeight = loadEpi64(args.quantWeights + predictorIndex);
+    __m128i attr[3];
+    for (int c = 0; c < numComponents; ++c)
+      attr[c] = loadEpi64(args.attributes[c] + predictorIndex);
+
+    for (size_t j = 0; j < kAttributePredictionMaxNeighbourCount; ++j) {
+      __m128i weight = loadEpu32(args.neighWeights[j] + predictorIndex);
+      weight = mulLo64x32(quantWeight, weight);
+      weight = _mm_srli_epi64(_mm_add_epi64(weight, round), shift);
+
+      uint64_t weights[2];
+      int64_t updates[3][2];
+      storeEpi64(weights, weight);
+      for (int c = 0; c < numComponents; ++c)
+        storeEpi64(updates[c], mulLo64(weight, attr[c]));
+
+      const uint32_t* neighIndex = args.neighIndexes[j] + predictorIndex;
+      for (int i = 0; i < 2; ++i) {
+        if (!weights[i])
+          continue;
+        args.updateWeights[neighIndex[i]] += weights[i];
+        for (int c = 0; c < numComponents; ++c)
+          args.updates[c][neighIndex[i]] += updates[c][i];
+      }
+    }
+  }
+
+  kLiftingKernelsScalar.accumulateUpdates(args, predictorIndex, end);
+}
+
+//----------------------------------------------------------------------------
+
+// NB: normalising the updates requires per-lane variable shifts, which
+//     SSE4.1 lacks; the portable kernel is used instead.
+
+const LiftingKernels kLiftingKernelsSse41 = {
+  liftPredictSse41, liftAccumulateUpdatesSse41, liftApplyUpdatesScalar};
+
+//============================================================================
+
+}  // namespace pcc
+
+#endif
@@ -42,6 +42,9 @@
 
 #if _WIN32
 #  include <direct.h>
+#  include <fcntl.h>
+#  include <io.h>
+#  include <stdio.h>
 #endif
 
 /* NB: if this file gets large, split into per-os variants */
@@ -52,6 +55,13 @@ pcc::mkdir(const char* path)
 {
   return _mkdir(path);
 }
+
+void
+pcc::setStdioBinaryMode()
+{
+  _setmode(_fileno(stdin), _O_BINARY);
+  _setmode(_fileno(stdout), _O_BINARY);
+}
 #endif
 
 #if _POSIX_C_SOURCE
@@ -60,4 +70,10 @@ pcc::mkdir(const char* path)
 {
   return ::mkdir(path, 0775);
 }
+
+void
+pcc::setStdioBinaryMode()
+{
+  // NB: there is no distinction between text and binary modes
+}
 #endif
@@ -40,4 +40,7 @@ namespace pcc {
 // Create a directory at the given path.
 int mkdir(const char* path);
 
+// Configure stdin and stdout for the transfer of binary data.
+void setStdioBinaryMode();
+
 } /* namespace pcc */
\ No newline at end of file
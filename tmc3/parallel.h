@@ -0,0 +1,85 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace pcc {
+
+//============================================================================
+// Invoke @fn(i) for each i in the range [@begin, @end) using up to
+// @numThreads threads.  The range is split into contiguous blocks of
+// similar size, one per thread; the calling thread processes the first.
+//
+// NB: @fn must be safe to call concurrently for distinct values of i.
+
+template<typename Fn>
+void
+parallelFor(int numThreads, int begin, int end, Fn fn)
+{
+  int count = end - begin;
+  numThreads = std::max(1, std::min(numThreads, count));
+
+  if (numThreads == 1) {
+    for (int i = begin; i < end; i++)
+      fn(i);
+    return;
+  }
+
+  auto runBlock = [&](int t) {
+    int blockBegin = begin + int(int64_t(count) * t / numThreads);
+    int blockEnd = begin + int(int64_t(count) * (t + 1) / numThreads);
+    for (int i = blockBegin; i < blockEnd; i++)
+      fn(i);
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for (int t = 1; t < numThreads; t++)
+    threads.emplace_back(runBlock, t);
+
+  runBlock(0);
+
+  for (auto& thread : threads)
+    thread.join();
+}
+
+//============================================================================
+
+}  // namespace pcc
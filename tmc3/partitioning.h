@@ -79,6 +79,10 @@ struct PartitionParams {
   // Minimum number of points per slice
   int sliceMinPoints;
 
+  // Maximum period to buffer pushed points before coding a slice, in ms.
+  // (0 => unlimited)
+  int sliceMaxDurationMs;
+
   // Baseline tile width. (0 => disabled)
   int tileSize;
 };
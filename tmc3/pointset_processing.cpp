@@ -874,20 +874,16 @@ recolour(
     bool ok = recolourColour(
       desc, cfg, source, sourceToTargetScaleFactor, tgtToSrcOffset, *target);
 
-    if (!ok) {
-      std::cout << "Error: can't transfer colors!" << std::endl;
+    if (!ok)
       return -1;
-    }
   }
 
   if (desc.attributeLabel == KnownAttributeLabel::kReflectance) {
     bool ok = recolourReflectance(
       desc, cfg, source, sourceToTargetScaleFactor, tgtToSrcOffset, *target);
 
-    if (!ok) {
-      std::cout << "Error: can't transfer reflectance!" << std::endl;
+    if (!ok)
       return -1;
-    }
   }
 
   return 0;
@@ -1025,4 +1021,72 @@ sortByRadius(PCCPointSet3& cloud, int start, int end, Vec3<int32_t> origin)
 
 //============================================================================
 
+static const AttributeDescription*
+findColourAttrDesc(const SequenceParameterSet& sps)
+{
+  // todo(df): don't assume that there is only one colour attribute in the sps
+  for (const auto& desc : sps.attributeSets) {
+    if (desc.attributeLabel == KnownAttributeLabel::kColour)
+      return &desc;
+  }
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------
+
+void
+convertToGbr(const SequenceParameterSet& sps, PCCPointSet3& cloud)
+{
+  const AttributeDescription* attrDesc = findColourAttrDesc(sps);
+  if (!attrDesc || !cloud.hasColors())
+    return;
+
+  switch (attrDesc->cicp_matrix_coefficients_idx) {
+  case ColourMatrix::kBt709: convertYCbCrBt709ToGbr(cloud); break;
+
+  case ColourMatrix::kYCgCo:
+    // todo(df): select YCgCoR vs YCgCo
+    convertYCgCoRToGbr(attrDesc->bitdepth, cloud);
+    break;
+
+  default: break;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+void
+convertFromGbr(const SequenceParameterSet& sps, PCCPointSet3& cloud)
+{
+  const AttributeDescription* attrDesc = findColourAttrDesc(sps);
+  if (!attrDesc || !cloud.hasColors())
+    return;
+
+  switch (attrDesc->cicp_matrix_coefficients_idx) {
+  case ColourMatrix::kBt709: convertGbrToYCbCrBt709(cloud); break;
+
+  case ColourMatrix::kYCgCo:
+    // todo(df): select YCgCoR vs YCgCo
+    convertGbrToYCgCoR(attrDesc->bitdepth, cloud);
+    break;
+
+  default: break;
+  }
+}
+
+//============================================================================
+
+std::array<const char*, 3>
+axisOrderToPropertyNames(AxisOrder order)
+{
+  static const std::array<const char*, 3> kAxisOrderToPropertyNames[] = {
+    {"z", "y", "x"}, {"x", "y", "z"}, {"x", "z", "y"}, {"y", "z", "x"},
+    {"z", "y", "x"}, {"z", "x", "y"}, {"y", "x", "z"}, {"x", "y", "z"},
+  };
+
+  return kAxisOrderToPropertyNames[int(order)];
+}
+
+//============================================================================
+
 }  // namespace pcc
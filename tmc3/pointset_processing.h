@@ -35,6 +35,7 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 
 #include "PCCPointSet.h"
@@ -181,6 +182,14 @@ void convertYCbCrBt709ToGbr(PCCPointSet3&);
 void convertGbrToYCgCoR(int bitDepth, PCCPointSet3&);
 void convertYCgCoRToGbr(int bitDepth, PCCPointSet3&);
 
+// Converts the colour attribute between GBR and the colourspace indicated
+// by the sps colour attribute description (if any).
+void convertToGbr(const SequenceParameterSet& sps, PCCPointSet3& cloud);
+void convertFromGbr(const SequenceParameterSet& sps, PCCPointSet3& cloud);
+
+// The names of the position axes (x, y, z) in coding order.
+std::array<const char*, 3> axisOrderToPropertyNames(AxisOrder order);
+
 //============================================================================
 
 // Generate index order sorted by azimuth angle.
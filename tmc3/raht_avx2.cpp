@@ -0,0 +1,325 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "raht_kernels.h"
+
+#if HAVE_X86_SIMD
+
+#  include <immintrin.h>
+
+namespace pcc {
+
+//============================================================================
+// RAHT block transform kernels using AVX2.  Each 64-bit lane holds one
+// operand of a different butterfly: the four butterflies of the first level
+// are evaluated together, those of the second level two blocks at a time,
+// and that of the third four blocks at a time.  The arithmetic is that of
+// FixedPoint.
+
+namespace {
+  const int kFracBits = 15;
+
+  // The fixed-point product of each signed 64-bit lane of @a and the
+  // non-negative Q15 coefficient in each 64-bit lane of @coeff, rounding
+  // intermediate half values away from zero.
+  inline __m256i
+  mulFixed(__m256i a, __m256i coeff)
+  {
+    __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), a);
+    __m256i mag = _mm256_sub_epi64(_mm256_xor_si256(a, sign), sign);
+    __m256i lo = _mm256_mul_epu32(mag, coeff);
+    __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(mag, 32), coeff);
+    mag = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+    mag = _mm256_add_epi64(mag, _mm256_set1_epi64x(1 << (kFracBits - 1)));
+    mag = _mm256_srli_epi64(mag, kFracBits);
+    return _mm256_sub_epi64(_mm256_xor_si256(mag, sign), sign);
+  }
+
+  //--------------------------------------------------------------------------
+
+  inline __m256i
+  loadEpi64(const int64_t* src)
+  {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+  }
+
+  inline __m128i
+  loadEpi64x2(const int64_t* src)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  }
+
+  inline void
+  storeEpi64(int64_t* dst, __m256i val)
+  {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), val);
+  }
+
+  //--------------------------------------------------------------------------
+  // The coefficients and node occupancy of a set of butterflies.
+
+  struct Butterflies {
+    __m256i a, b;
+
+    // all ones if both nodes are occupied
+    __m256i both;
+
+    // all ones if only the right node is occupied
+    __m256i swap;
+  };
+
+  //--------------------------------------------------------------------------
+  // The lane masks of the butterflies combining the node pairs in each
+  // 64-bit lane of @weights.
+
+  inline __m128i
+  bothMask(__m128i weights)
+  {
+    __m128i empty = _mm_cmpeq_epi32(weights, _mm_setzero_si128());
+    __m128i emptyPair = _mm_or_si128(empty, _mm_shuffle_epi32(empty, 0xb1));
+    return _mm_xor_si128(emptyPair, _mm_set1_epi32(-1));
+  }
+
+  inline __m128i
+  swapMask(__m128i weights)
+  {
+    __m128i empty = _mm_cmpeq_epi32(weights, _mm_setzero_si128());
+    __m128i rightOnly =
+      _mm_andnot_si128(_mm_shuffle_epi32(empty, 0xb1), empty);
+    return _mm_shuffle_epi32(rightOnly, 0xa0);
+  }
+
+  //--------------------------------------------------------------------------
+  // The butterflies of each level of a block.  The first level is in the
+  // lane order 0, 2, 1, 3 (see transformLevel1); the second repeats
+  // butterflies 4 and 5; the third repeats butterfly 6.
+
+  struct BlockButterflies {
+    Butterflies level1, level2, level3;
+
+    BlockButterflies(const RahtBlockCoeffs& coeffs);
+  };
+
+  //--------------------------------------------------------------------------
+
+  inline BlockButterflies::BlockButterflies(const RahtBlockCoeffs& coeffs)
+  {
+    const __m128i* weights = reinterpret_cast<const __m128i*>(coeffs.weights);
+    __m128i w0 = _mm_loadu_si128(weights);
+    __m128i w1 = _mm_loadu_si128(weights + 1);
+    __m128i w2 = _mm_loadu_si128(weights + 2);
+    __m128i w3 = _mm_loadl_epi64(weights + 3);
+
+    const int kOrder = 0xd8;
+    level1.a = _mm256_permute4x64_epi64(loadEpi64(&coeffs.a[0]), kOrder);
+    level1.b = _mm256_permute4x64_epi64(loadEpi64(&coeffs.b[0]), kOrder);
+    level1.both = _mm256_permute4x64_epi64(
+      _mm256_inserti128_si256(
+        _mm256_castsi128_si256(bothMask(w0)), bothMask(w1), 1),
+      kOrder);
+    level1.swap = _mm256_permute4x64_epi64(
+      _mm256_inserti128_si256(
+        _mm256_castsi128_si256(swapMask(w0)), swapMask(w1), 1),
+      kOrder);
+
+    level2.a = _mm256_broadcastsi128_si256(loadEpi64x2(&coeffs.a[4]));
+    level2.b = _mm256_broadcastsi128_si256(loadEpi64x2(&coeffs.b[4]));
+    level2.both = _mm256_broadcastsi128_si256(bothMask(w2));
+    level2.swap = _mm256_broadcastsi128_si256(swapMask(w2));
+
+    level3.a = _mm256_set1_epi64x(coeffs.a[6]);
+    level3.b = _mm256_set1_epi64x(coeffs.b[6]);
+    level3.both = _mm256_broadcastq_epi64(bothMask(w3));
+    level3.swap = _mm256_broadcastq_epi64(swapMask(w3));
+  }
+
+  //--------------------------------------------------------------------------
+  // Transform the node pairs (left, right) in place.
+
+  inline void
+  fwdButterfly(const Butterflies& bf, __m256i* left, __m256i* right)
+  {
+    __m256i lf =
+      _mm256_add_epi64(mulFixed(*right, bf.b), mulFixed(*left, bf.a));
+    __m256i hf =
+      _mm256_sub_epi64(mulFixed(*right, bf.a), mulFixed(*left, bf.b));
+
+    __m256i l = _mm256_blendv_epi8(*left, *right, bf.swap);
+    __m256i r = _mm256_blendv_epi8(*right, *left, bf.swap);
+    *left = _mm256_blendv_epi8(l, lf, bf.both);
+    *right = _mm256_blendv_epi8(r, hf, bf.both);
+  }
+
+  inline void
+  invButterfly(const Butterflies& bf, __m256i* lf, __m256i* hf)
+  {
+    __m256i l = _mm256_sub_epi64(mulFixed(*lf, bf.a), mulFixed(*hf, bf.b));
+    __m256i r = _mm256_add_epi64(mulFixed(*lf, bf.b), mulFixed(*hf, bf.a));
+
+    __m256i sl = _mm256_blendv_epi8(*lf, *hf, bf.swap);
+    __m256i sr = _mm256_blendv_epi8(*hf, *lf, bf.swap);
+    *lf = _mm256_blendv_epi8(sl, l, bf.both);
+    *hf = _mm256_blendv_epi8(sr, r, bf.both);
+  }
+
+  //--------------------------------------------------------------------------
+  // Each level of the block transform.  The first level pairs adjacent
+  // nodes: (0, 1), (2, 3), (4, 5), (6, 7); the second level pairs the low
+  // pass coefficients (0, 2) and (4, 6); the third (0, 4).
+
+  template<bool isFwd>
+  inline void
+  transformLevel1(const Butterflies& bf, int numBufs, int64_t buf[][8])
+  {
+    for (int k = 0; k < numBufs; k++) {
+      __m256i x = loadEpi64(&buf[k][0]);
+      __m256i y = loadEpi64(&buf[k][4]);
+      __m256i left = _mm256_unpacklo_epi64(x, y);
+      __m256i right = _mm256_unpackhi_epi64(x, y);
+
+      if (isFwd)
+        fwdButterfly(bf, &left, &right);
+      else
+        invButterfly(bf, &left, &right);
+
+      storeEpi64(&buf[k][0], _mm256_unpacklo_epi64(left, right));
+      storeEpi64(&buf[k][4], _mm256_unpackhi_epi64(left, right));
+    }
+  }
+
+  //--------------------------------------------------------------------------
+
+  template<bool isFwd>
+  inline void
+  transformLevel2(const Butterflies& bf, int numBufs, int64_t buf[][8])
+  {
+    for (int k = 0; k < numBufs; k += 2) {
+      // NB: an odd final block is processed in both halves
+      int k1 = k + 1 < numBufs ? k + 1 : k;
+      __m256i x0 = loadEpi64(&buf[k][0]);
+      __m256i y0 = loadEpi64(&buf[k][4]);
+      __m256i x1 = loadEpi64(&buf[k1][0]);
+      __m256i y1 = loadEpi64(&buf[k1][4]);
+
+      // nodes (0, 4, 2, 6) of each block
+      __m256i even0 = _mm256_unpacklo_epi64(x0, y0);
+      __m256i even1 = _mm256_unpacklo_epi64(x1, y1);
+      __m256i left = _mm256_permute2x128_si256(even0, even1, 0x20);
+      __m256i right = _mm256_permute2x128_si256(even0, even1, 0x31);
+
+      if (isFwd)
+        fwdButterfly(bf, &left, &right);
+      else
+        invButterfly(bf, &left, &right);
+
+      // NB: only the even nodes are modified
+      even0 = _mm256_permute2x128_si256(left, right, 0x20);
+      even1 = _mm256_permute2x128_si256(left, right, 0x31);
+      __m256i odd0 = _mm256_shuffle_epi32(even0, 0x4e);
+      __m256i odd1 = _mm256_shuffle_epi32(even1, 0x4e);
+      storeEpi64(&buf[k1][0], _mm256_blend_epi32(x1, even1, 0x33));
+      storeEpi64(&buf[k1][4], _mm256_blend_epi32(y1, odd1, 0x33));
+      storeEpi64(&buf[k][0], _mm256_blend_epi32(x0, even0, 0x33));
+      storeEpi64(&buf[k][4], _mm256_blend_epi32(y0, odd0, 0x33));
+    }
+  }
+
+  //--------------------------------------------------------------------------
+
+  template<bool isFwd>
+  inline void
+  transformLevel3(const Butterflies& bf, int numBufs, int64_t buf[][8])
+  {
+    for (int k = 0; k < numBufs; k += 4) {
+      // NB: a partial final set of blocks repeats the last block
+      int n = numBufs - k < 4 ? numBufs - k : 4;
+      int64_t lefts[4], rights[4];
+      for (int j = 0; j < 4; j++) {
+        lefts[j] = buf[k + (j < n ? j : n - 1)][0];
+        rights[j] = buf[k + (j < n ? j : n - 1)][4];
+      }
+
+      __m256i left = loadEpi64(lefts);
+      __m256i right = loadEpi64(rights);
+
+      if (isFwd)
+        fwdButterfly(bf, &left, &right);
+      else
+        invButterfly(bf, &left, &right);
+
+      storeEpi64(lefts, left);
+      storeEpi64(rights, right);
+      for (int j = 0; j < n; j++) {
+        buf[k + j][0] = lefts[j];
+        buf[k + j][4] = rights[j];
+      }
+    }
+  }
+}  // namespace
+
+//----------------------------------------------------------------------------
+
+static void
+fwdTransformBlock222Avx2(
+  const RahtBlockCoeffs& coeffs, int numBufs, int64_t buf[][8])
+{
+  BlockButterflies bf(coeffs);
+  transformLevel1<true>(bf.level1, numBufs, buf);
+  transformLevel2<true>(bf.level2, numBufs, buf);
+  transformLevel3<true>(bf.level3, numBufs, buf);
+}
+
+//----------------------------------------------------------------------------
+
+static void
+invTransformBlock222Avx2(
+  const RahtBlockCoeffs& coeffs, int numBufs, int64_t buf[][8])
+{
+  BlockButterflies bf(coeffs);
+  transformLevel3<false>(bf.level3, numBufs, buf);
+  transformLevel2<false>(bf.level2, numBufs, buf);
+  transformLevel1<false>(bf.level1, numBufs, buf);
+}
+
+//----------------------------------------------------------------------------
+
+const RahtKernels kRahtKernelsAvx2 = {
+  fwdTransformBlock222Avx2, invTransformBlock222Avx2};
+
+//============================================================================
+
+}  // namespace pcc
+
+#endif
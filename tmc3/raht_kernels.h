@@ -0,0 +1,89 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "TMC3Config.h"
+
+#include <cstdint>
+
+// NB: this header is included by translation units that are compiled for
+//     specific instruction set extensions.  It must not introduce inline
+//     functions or templates that may be shared with other translation
+//     units.
+
+namespace pcc {
+
+//============================================================================
+// The butterflies of a 2x2x2 RAHT block transform.  Butterfly i combines the
+// nodes with weights weights[2 * i] and weights[2 * i + 1], of which there
+// are four, two and one at each successive level (see mkWeightTree).
+//
+// The fixed-point (Q15) coefficients of a butterfly are a = sqrt(wl / w)
+// and b = sqrt(wr / w).  Those of butterflies with an unoccupied node are
+// zero: the occupied node, if any, is propagated to the next level.
+
+struct RahtBlockCoeffs {
+  const int* weights;
+  int64_t a[4 + 2 + 1];
+  int64_t b[4 + 2 + 1];
+};
+
+//----------------------------------------------------------------------------
+
+struct RahtKernels {
+  // In-place forward transform of numBufs blocks of fixed-point values
+  // that share the same weights.
+  void (*fwdTransformBlock222)(
+    const RahtBlockCoeffs& coeffs, int numBufs, int64_t buf[][8]);
+
+  // In-place inverse transform of numBufs blocks of fixed-point values
+  // that share the same weights.
+  void (*invTransformBlock222)(
+    const RahtBlockCoeffs& coeffs, int numBufs, int64_t buf[][8]);
+};
+
+//----------------------------------------------------------------------------
+
+extern const RahtKernels kRahtKernelsScalar;
+
+#if HAVE_X86_SIMD
+extern const RahtKernels kRahtKernelsSse41;
+extern const RahtKernels kRahtKernelsAvx2;
+#endif
+
+//============================================================================
+
+}  // namespace pcc
@@ -0,0 +1,290 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2017-2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "raht_kernels.h"
+
+#if HAVE_X86_SIMD
+
+#  include <smmintrin.h>
+
+namespace pcc {
+
+//============================================================================
+// RAHT block transform kernels using SSE4.1.  Each 64-bit lane holds one
+// operand of a different butterfly: the butterflies of the first level are
+// evaluated two at a time; those of the upper levels two blocks at a time.
+// The arithmetic is that of FixedPoint.
+
+namespace {
+  const int kFracBits = 15;
+
+  // The fixed-point product of each signed 64-bit lane of @a and the
+  // non-negative Q15 coefficient in each 64-bit lane of @coeff, rounding
+  // intermediate half values away from zero.
+  inline __m128i
+  mulFixed(__m128i a, __m128i coeff)
+  {
+    __m128i sign = _mm_srai_epi32(_mm_shuffle_epi32(a, 0xf5), 31);
+    __m128i mag = _mm_sub_epi64(_mm_xor_si128(a, sign), sign);
+    __m128i lo = _mm_mul_epu32(mag, coeff);
+    __m128i hi = _mm_mul_epu32(_mm_srli_epi64(mag, 32), coeff);
+    mag = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+    mag = _mm_add_epi64(mag, _mm_set1_epi64x(1 << (kFracBits - 1)));
+    mag = _mm_srli_epi64(mag, kFracBits);
+    return _mm_sub_epi64(_mm_xor_si128(mag, sign), sign);
+  }
+
+  //--------------------------------------------------------------------------
+  // The coefficients and node occupancy of a set of butterflies.
+
+  struct Butterflies {
+    __m128i a, b;
+
+    // all ones if both nodes are occupied
+    __m128i both;
+
+    // all ones if only the right node is occupied
+    __m128i swap;
+  };
+
+  //--------------------------------------------------------------------------
+  // Transform the node pairs (left, right) in place.
+
+  inline void
+  fwdButterfly(const Butterflies& bf, __m128i* left, __m128i* right)
+  {
+    __m128i lf = _mm_add_epi64(mulFixed(*right, bf.b), mulFixed(*left, bf.a));
+    __m128i hf = _mm_sub_epi64(mulFixed(*right, bf.a), mulFixed(*left, bf.b));
+
+    __m128i l = _mm_blendv_epi8(*left, *right, bf.swap);
+    __m128i r = _mm_blendv_epi8(*right, *left, bf.swap);
+    *left = _mm_blendv_epi8(l, lf, bf.both);
+    *right = _mm_blendv_epi8(r, hf, bf.both);
+  }
+
+  inline void
+  invButterfly(const Butterflies& bf, __m128i* lf, __m128i* hf)
+  {
+    __m128i l = _mm_sub_epi64(mulFixed(*lf, bf.a), mulFixed(*hf, bf.b));
+    __m128i r = _mm_add_epi64(mulFixed(*lf, bf.b), mulFixed(*hf, bf.a));
+
+    __m128i sl = _mm_blendv_epi8(*lf, *hf, bf.swap);
+    __m128i sr = _mm_blendv_epi8(*hf, *lf, bf.swap);
+    *lf = _mm_blendv_epi8(sl, l, bf.both);
+    *hf = _mm_blendv_epi8(sr, r, bf.both);
+  }
+
+  //--------------------------------------------------------------------------
+
+  inline __m128i
+  loadEpi64(const int64_t* src)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  }
+
+  inline void
+  storeEpi64(int64_t* dst, __m128i val)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), val);
+  }
+
+  //--------------------------------------------------------------------------
+  // The lane masks of the butterflies combining the node pairs in each
+  // 64-bit lane of @weights.
+
+  inline __m128i
+  bothMask(__m128i weights)
+  {
+    __m128i empty = _mm_cmpeq_epi32(weights, _mm_setzero_si128());
+    __m128i emptyPair = _mm_or_si128(empty, _mm_shuffle_epi32(empty, 0xb1));
+    return _mm_xor_si128(emptyPair, _mm_set1_epi32(-1));
+  }
+
+  inline __m128i
+  swapMask(__m128i weights)
+  {
+    __m128i empty = _mm_cmpeq_epi32(weights, _mm_setzero_si128());
+    __m128i rightOnly =
+      _mm_andnot_si128(_mm_shuffle_epi32(empty, 0xb1), empty);
+    return _mm_shuffle_epi32(rightOnly, 0xa0);
+  }
+
+  //--------------------------------------------------------------------------
+  // The butterflies of each level of a block: pairs of the first level,
+  // butterflies 4 and 5 of the second; the third repeats butterfly 6.
+
+  struct BlockButterflies {
+    Butterflies level1[2], level2, level3;
+
+    BlockButterflies(const RahtBlockCoeffs& coeffs);
+  };
+
+  //--------------------------------------------------------------------------
+
+  inline BlockButterflies::BlockButterflies(const RahtBlockCoeffs& coeffs)
+  {
+    const __m128i* weights = reinterpret_cast<const __m128i*>(coeffs.weights);
+    for (int i = 0; i < 3; i++) {
+      Butterflies& bf = i < 2 ? level1[i] : level2;
+      __m128i w = _mm_loadu_si128(weights + i);
+      bf.a = loadEpi64(&coeffs.a[2 * i]);
+      bf.b = loadEpi64(&coeffs.b[2 * i]);
+      bf.both = bothMask(w);
+      bf.swap = swapMask(w);
+    }
+
+    __m128i w = _mm_loadl_epi64(weights + 3);
+    level3.a = _mm_set1_epi64x(coeffs.a[6]);
+    level3.b = _mm_set1_epi64x(coeffs.b[6]);
+    level3.both = _mm_unpacklo_epi64(bothMask(w), bothMask(w));
+    level3.swap = _mm_unpacklo_epi64(swapMask(w), swapMask(w));
+  }
+
+  //--------------------------------------------------------------------------
+  // Each level of the block transform.  The first level pairs adjacent
+  // nodes: (0, 1), (2, 3), (4, 5), (6, 7); the second level pairs the low
+  // pass coefficients (0, 2) and (4, 6); the third (0, 4).
+
+  template<bool isFwd>
+  inline void
+  transformLevel1(const Butterflies bf[2], int numBufs, int64_t buf[][8])
+  {
+    for (int k = 0; k < numBufs; k++) {
+      for (int h = 0; h < 2; h++) {
+        __m128i x = loadEpi64(&buf[k][4 * h]);
+        __m128i y = loadEpi64(&buf[k][4 * h + 2]);
+        __m128i left = _mm_unpacklo_epi64(x, y);
+        __m128i right = _mm_unpackhi_epi64(x, y);
+
+        if (isFwd)
+          fwdButterfly(bf[h], &left, &right);
+        else
+          invButterfly(bf[h], &left, &right);
+
+        storeEpi64(&buf[k][4 * h], _mm_unpacklo_epi64(left, right));
+        storeEpi64(&buf[k][4 * h + 2], _mm_unpackhi_epi64(left, right));
+      }
+    }
+  }
+
+  //--------------------------------------------------------------------------
+
+  template<bool isFwd>
+  inline void
+  transformLevel2(const Butterflies& bf, int numBufs, int64_t buf[][8])
+  {
+    for (int k = 0; k < numBufs; k++) {
+      __m128i x = loadEpi64(&buf[k][0]);
+      __m128i y = loadEpi64(&buf[k][2]);
+      __m128i z = loadEpi64(&buf[k][4]);
+      __m128i w = loadEpi64(&buf[k][6]);
+      __m128i left = _mm_unpacklo_epi64(x, z);
+      __m128i right = _mm_unpacklo_epi64(y, w);
+
+      if (isFwd)
+        fwdButterfly(bf, &left, &right);
+      else
+        invButterfly(bf, &left, &right);
+
+      // NB: only the even nodes are modified
+      storeEpi64(&buf[k][0], _mm_blend_epi16(x, left, 0x0f));
+      storeEpi64(&buf[k][2], _mm_blend_epi16(y, right, 0x0f));
+      storeEpi64(&buf[k][4], _mm_unpackhi_epi64(left, z));
+      storeEpi64(&buf[k][6], _mm_unpackhi_epi64(right, w));
+    }
+  }
+
+  //--------------------------------------------------------------------------
+
+  template<bool isFwd>
+  inline void
+  transformLevel3(const Butterflies& bf, int numBufs, int64_t buf[][8])
+  {
+    for (int k = 0; k < numBufs; k += 2) {
+      // NB: an odd final block is processed in both lanes
+      int k1 = k + 1 < numBufs ? k + 1 : k;
+      __m128i left = _mm_set_epi64x(buf[k1][0], buf[k][0]);
+      __m128i right = _mm_set_epi64x(buf[k1][4], buf[k][4]);
+
+      if (isFwd)
+        fwdButterfly(bf, &left, &right);
+      else
+        invButterfly(bf, &left, &right);
+
+      int64_t lefts[2], rights[2];
+      storeEpi64(lefts, left);
+      storeEpi64(rights, right);
+      buf[k1][0] = lefts[1];
+      buf[k1][4] = rights[1];
+      buf[k][0] = lefts[0];
+      buf[k][4] = rights[0];
+    }
+  }
+}  // namespace
+
+//----------------------------------------------------------------------------
+
+static void
+fwdTransformBlock222Sse41(
+  const RahtBlockCoeffs& coeffs, int numBufs, int64_t buf[][8])
+{
+  BlockButterflies bf(coeffs);
+  transformLevel1<true>(bf.level1, numBufs, buf);
+  transformLevel2<true>(bf.level2, numBufs, buf);
+  transformLevel3<true>(bf.level3, numBufs, buf);
+}
+
+//----------------------------------------------------------------------------
+
+static void
+invTransformBlock222Sse41(
+  const RahtBlockCoeffs& coeffs, int numBufs, int64_t buf[][8])
+{
+  BlockButterflies bf(coeffs);
+  transformLevel3<false>(bf.level3, numBufs, buf);
+  transformLevel2<false>(bf.level2, numBufs, buf);
+  transformLevel1<false>(bf.level1, numBufs, buf);
+}
+
+//----------------------------------------------------------------------------
+
+const RahtKernels kRahtKernelsSse41 = {
+  fwdTransformBlock222Sse41, invTransformBlock222Sse41};
+
+//============================================================================
+
+}  // namespace pcc
+
+#endif
@@ -398,6 +398,22 @@ public:
 
   size_t capacity() const { return capacity_ - 1; }
 
+  //--------------------------------------------------------------------------
+  // Increase the capacity to at least @size elements.
+  // NB: if the capacity changes, all iterators are invalidated.
+
+  void reserve(size_t size)
+  {
+    if (size <= capacity())
+      return;
+
+    ringbuf tmp(size);
+    for (auto& val : *this)
+      tmp.emplace_back(std::move(val));
+
+    *this = std::move(tmp);
+  }
+
   //--------------------------------------------------------------------------
 private:
   struct operator_delete_arr {
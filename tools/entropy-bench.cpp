@@ -0,0 +1,177 @@
+/* The copyright in this software is being made available under the BSD
+ * Licence, included below.  This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such
+ * rights are granted under this licence.
+ *
+ * Copyright (c) 2020, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the ISO/IEC nor the names of its contributors
+ *   may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Microbenchmark comparing the arithmetic decoder used by the codec
+// against the reference schroedinger implementation.
+//
+// A synthetic sequence of bins, drawn from a set of contexts with skewed
+// probabilities, is encoded once and decoded repeatedly by each decoder.
+// The decoded bins and final context states are checked for equality.
+
+#include "entropy.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace pcc;
+
+//============================================================================
+
+namespace {
+
+struct BufferReader {
+  const uint8_t* ptr;
+  const uint8_t* end;
+
+  static uint8_t read(void* thisptr)
+  {
+    auto _this = reinterpret_cast<BufferReader*>(thisptr);
+    if (_this->ptr == _this->end)
+      return 0xff;
+    return *_this->ptr++;
+  }
+};
+
+//----------------------------------------------------------------------------
+// A small linear congruential generator, for reproducibility.
+
+struct Lcg {
+  uint32_t state = 1;
+
+  uint32_t operator()()
+  {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+  }
+};
+
+//----------------------------------------------------------------------------
+
+const int kNumCtx = 64;
+
+// Returns the context used to code the i-th bin
+int
+ctxIdx(int i)
+{
+  return (i * 7) & (kNumCtx - 1);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename Fn>
+double
+timeRuns(int numRuns, Fn fn)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (int run = 0; run < numRuns; run++)
+    fn();
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(t1 - t0).count() / numRuns;
+}
+
+}  // namespace
+
+//============================================================================
+
+int
+main(int argc, char* argv[])
+{
+  int numBins = argc > 1 ? atoi(argv[1]) : 10000000;
+  int numRuns = argc > 2 ? atoi(argv[2]) : 5;
+
+  // generate the source: each context has a fixed probability of a one
+  Lcg rand;
+  std::vector<uint32_t> pOne(kNumCtx);
+  for (auto& p : pOne)
+    p = rand() & 0xffff;
+
+  std::vector<uint8_t> bins(numBins);
+  for (int i = 0; i < numBins; i++)
+    bins[i] = (rand() & 0xffff) < pOne[ctxIdx(i)];
+
+  // encode
+  std::vector<AdaptiveBitModel> encCtx(kNumCtx);
+  EntropyEncoder enc(numBins / 4 + 1024, nullptr);
+  enc.start();
+  for (int i = 0; i < numBins; i++)
+    enc.encode(bins[i], encCtx[ctxIdx(i)]);
+  size_t bufLen = enc.stop();
+  const char* buf = enc.buffer();
+
+  std::vector<uint8_t> decRef(numBins);
+  std::vector<uint8_t> decFast(numBins);
+  std::vector<uint16_t> ctxRef(kNumCtx);
+  std::vector<AdaptiveBitModel> ctxFast(kNumCtx);
+
+  // the reference implementation
+  double tRef = timeRuns(numRuns, [&]() {
+    BufferReader reader;
+    reader.ptr = reinterpret_cast<const uint8_t*>(buf);
+    reader.end = reader.ptr + bufLen;
+
+    ::SchroArith impl;
+    schro_arith_decode_init(&impl, &BufferReader::read, &reader);
+    std::fill(ctxRef.begin(), ctxRef.end(), 0x8000);
+    for (int i = 0; i < numBins; i++)
+      decRef[i] = schro_arith_decode_bit(&impl, &ctxRef[ctxIdx(i)]);
+  });
+
+  // the codec's decoder
+  double tFast = timeRuns(numRuns, [&]() {
+    EntropyDecoder dec;
+    dec.setBuffer(bufLen, buf);
+    dec.start();
+    for (auto& ctx : ctxFast)
+      ctx.reset();
+    for (int i = 0; i < numBins; i++)
+      decFast[i] = dec.decode(ctxFast[ctxIdx(i)]);
+    dec.stop();
+  });
+
+  bool match = decRef == bins && decFast == bins;
+  for (int i = 0; i < kNumCtx; i++)
+    match &= ctxRef[i] == ctxFast[i].probability;
+
+  printf("bins: %d, bytes: %zu\n", numBins, bufLen);
+  printf("reference: %.2f ns/bin\n", 1e9 * tRef / numBins);
+  printf("codec:     %.2f ns/bin\n", 1e9 * tFast / numBins);
+  printf("speedup:   %.2fx\n", tRef / tFast);
+  printf("output:    %s\n", match ? "match" : "MISMATCH");
+
+  return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}